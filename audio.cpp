@@ -7,17 +7,23 @@
  */
 
 #include "audio.h"
+#include "cancel.h"
+#include "governor.h"
+#include "hints.h"
+#include "reader.h"
 
 #include <sstream>
+#include <cstdint>
 #include <cstring>
+#include <algorithm>
 
 using namespace std;
 
 const unsigned int MAX_U_32_NUM = 0xFFFFFFFF;
-AudioData::QUALITY_LEVEL AudioData::encoding_quality = QL_STANDARD;
+AudioData::EncodeSettings AudioData::encoding_settings = { QL_STANDARD, -1, -1, 0 };
 
 int
-AudioData::unpack_read_samples(ifstream* ifs, int* sample_buffer,
+AudioData::unpack_read_samples(istream* ifs, int* sample_buffer,
         int samples_to_read, const int bytes_per_sample, const int swap_order)
 {
     size_t          samples_read;
@@ -84,7 +90,7 @@ AudioData::unpack_read_samples(ifstream* ifs, int* sample_buffer,
 }
 
 int
-AudioData::read_samples_pcm(ifstream* ifs, int sample_buffer[2 * SAMPLE_SIZE], int samples_to_read)
+AudioData::read_samples_pcm(istream* ifs, int sample_buffer[2 * SAMPLE_SIZE], int samples_to_read)
 {
     int samples_read;
     int swap_byte_order;
@@ -136,7 +142,7 @@ AudioData::get_audio_common(lame_t gf, int buffer[2][SAMPLE_SIZE])
         }
     }
 
-    samples_read = read_samples_pcm(m_ifstream, insample, num_channels * frame_size);
+    samples_read = read_samples_pcm(m_istream, insample, num_channels * frame_size);
     if (samples_read < 0) {
         return samples_read;
     }
@@ -188,18 +194,97 @@ AudioData::get_audio(lame_t gf, int buffer[2][SAMPLE_SIZE])
 void
 AudioData::set_quality(QUALITY_LEVEL quality)
 {
-    AudioData::encoding_quality = quality;
+    AudioData::encoding_settings.preset = quality;
+}
+
+void
+AudioData::set_settings(const EncodeSettings& settings)
+{
+    AudioData::encoding_settings = settings;
+}
+
+string
+AudioData::settings_name()
+{
+    static const char* preset_names[] = { "fast", "standard", "best" };
+    const EncodeSettings& s = AudioData::encoding_settings;
+    ostringstream name;
+
+    if (s.cbr_kbps > 0) {
+        name << "cbr" << s.cbr_kbps;
+    } else if (s.vbr_q >= 0) {
+        name << "vbr" << s.vbr_q;
+    } else {
+        name << preset_names[s.preset];
+    }
+    if (s.quality >= 0) {
+        name << "+q" << s.quality;
+    }
+
+    return name.str();
 }
 
 void
 AudioData::run()
 {
+    encode();
+}
+
+bool
+AudioData::encode()
+{
+    bool ret = false;
+
     if (m_init) {
-        lame_encoder_loop(NULL);
+        ret = (lame_encoder_loop(NULL) == NULL);
     } else {
         DEBUG::ERR("can't start thread because not initialized");
     }
-    lame_init_bitstream(m_gf);
+    if (m_gf) {
+        lame_init_bitstream(m_gf);
+    }
+
+    return ret;
+}
+
+double
+AudioData::duration()
+{
+    if (!m_gf) {
+        return 0;
+    }
+    unsigned long const n = lame_get_num_samples(m_gf);
+    int const rate = lame_get_in_samplerate(m_gf);
+    if (n == MAX_U_32_NUM || rate <= 0) {
+        return 0;
+    }
+
+    return (double)n / rate;
+}
+
+string
+AudioData::format_name()
+{
+    ostringstream name;
+
+    if (!m_init) {
+        return "unknown";
+    }
+    name << m_pcmbitwidth << "-bit " << (m_pcm_is_ieee_float ? "float " : "");
+    switch (lame_get_num_channels(m_gf)) {
+    case 1:
+        name << "mono";
+        break;
+    case 2:
+        name << "stereo";
+        break;
+    default:
+        name << lame_get_num_channels(m_gf) << "ch";
+        break;
+    }
+    name << " " << lame_get_in_samplerate(m_gf) << "Hz";
+
+    return name.str();
 }
 
 void*
@@ -220,6 +305,9 @@ AudioData::lame_encoder_loop(void* data)
     id3v2_size = lame_get_id3v2_tag(m_gf, 0, 0);
 
     msg << "Start encoding [" << m_infile << " -> " << m_outfile << "]";
+    if (m_segment.samples) {
+        msg << " samples " << m_segment.first << "-" << (m_segment.first + m_segment.samples);
+    }
     if (DEBUG::IS_SET()) {
         msg << " as " << (1.e-3 * lame_get_out_samplerate(m_gf)) << "KHz ";
         static const char *mode_names[2][4] = {
@@ -246,10 +334,47 @@ AudioData::lame_encoder_loop(void* data)
     }
     cout << msg.str() << endl;
 
+    double t = monotonic_time();
+    auto lap = [&t](double& stage) {
+        double const now = monotonic_time();
+        stage += now - t;
+        t = now;
+    };
+    Governor& governor = Governor::instance();
+    size_t const frame_bytes = lame_get_num_channels(m_gf) * (m_pcmbitwidth / 8);
+    double const in_rate = lame_get_in_samplerate(m_gf);
+    auto beat = [this, &t](Heartbeat::STAGE stage) {
+        if (m_heartbeat) {
+            m_heartbeat->beat(stage, t);
+        }
+    };
+
+    /* bytes of pcm consumed so far, to read ahead of the input and drop what is behind */
+    size_t read_pos = m_hints.is_open() ? (size_t)max((streamoff)m_istream->tellg(), (streamoff)0) : 0;
+
     do {
-        iread = get_audio(m_gf, buf);
+        if (Cancel::aborted() || (m_heartbeat && m_heartbeat->abandoned)) {
+            cerr << "ERROR: encoding " << m_outfile << " canceled" << endl;
+            return (void*)1;
+        }
+        beat(Heartbeat::HB_READING);
+        {
+            Storage::Slot slot(m_device);
+            iread = get_audio(m_gf, buf);
+        }
+        if (iread > 0 && m_hints.is_open()) {
+            read_pos += iread * frame_bytes;
+            m_hints.advance(read_pos);
+        }
+        lap(m_stage.read);
         if (iread >= 0) {
+            beat(Heartbeat::HB_ENCODING);
             imp3 = lame_encode_buffer_int(m_gf, buf[0], buf[1], iread, mp3buf, sizeof(mp3buf));
+            lap(m_stage.encode);
+            if (m_heartbeat && in_rate > 0) {
+                /* only this thread writes it */
+                m_heartbeat->audio = m_heartbeat->audio + iread / in_rate;
+            }
             if (imp3 < 0) {
                 if (imp3 == -1) {
                     cerr << "ERROR: mp3 buffer is not big enough..." << endl;
@@ -259,14 +384,20 @@ AudioData::lame_encoder_loop(void* data)
                 return (void*)1;
             }
 
-            if (m_ofstream->write((char*)mp3buf, imp3).fail()) {
+            beat(Heartbeat::HB_WRITING);
+            if (!output(mp3buf, imp3)) {
                 cerr << "ERROR: failed to write mp3 output" << endl;
                 return (void*)1;
             }
+            lap(m_stage.write);
+            /* waiting for the governor is not attributed to any stage */
+            t += governor.pace(iread * frame_bytes, imp3);
         }
     } while (iread > 0);
 
+    beat(Heartbeat::HB_ENCODING);
     imp3 = lame_encode_flush(m_gf, mp3buf, sizeof(mp3buf));
+    lap(m_stage.encode);
     if (imp3 < 0) {
         if (imp3 == -1) {
             cerr << "ERROR: mp3 buffer is not big enough..." << endl;
@@ -275,35 +406,187 @@ AudioData::lame_encoder_loop(void* data)
         }
         return (void*)1;
     }
-    if (m_ofstream->write((char*)mp3buf, imp3).fail()) {
+    if (!output(mp3buf, imp3)) {
         cerr << "ERROR: failed to write mp3 output" << endl;
         return (void*)1;
     }
+    if (m_segment.samples) {
+        lap(m_stage.write);
+        return trim_segment() ? NULL : (void*)1;
+    }
 
     /* write xing frame */
+    beat(Heartbeat::HB_TAGGING);
     tagsize = lame_get_lametag_frame(m_gf, mp3buf, sizeof(mp3buf));
     if (tagsize <= 0) {
         DEBUG::INFO("no LAME-tag exists");
     } else if (tagsize > sizeof(mp3buf)) {
         DEBUG::INFO("LAME-tag frame exceeds buffer size");
-    } else if (m_ofstream->seekp(id3v2_size, std::ios::beg).fail()) {
-        DEBUG::WARN("fatal error: can't update LAME-tag frame!");
-    } else {
-        if (m_ofstream->write((char*)mp3buf, tagsize).fail()) {
-            cerr << "ERROR: failed to write LAME-tag" << endl;
-        } else {
-            cout << "Encoding " << m_outfile << " done" << endl;
-        }
+    } else if (!m_writer.write_at(id3v2_size, mp3buf, tagsize)) {
+        cerr << "ERROR: failed to write LAME-tag" << endl;
+        m_writer.abort();
+        return (void*)1;
     }
+    if (!m_writer.commit()) {
+        cerr << "ERROR: failed to write mp3 output" << endl;
+        return (void*)1;
+    }
+    lap(m_stage.write);
+    cout << "Encoding " << m_outfile << " done" << endl;
 
     return NULL;
 }
 
+bool
+AudioData::output(const unsigned char* data, size_t len)
+{
+    if (m_segment.samples) {
+        m_frames.insert(m_frames.end(), data, data + len);
+        return true;
+    }
+
+    return m_writer.write(data, len);
+}
+
+/**
+ * @brief   Length of the MPEG audio layer III frame starting at h, including the header.
+ * @return  0 if h is not a valid frame header
+ */
+static size_t
+mp3_frame_length(const unsigned char* h, size_t avail)
+{
+    static const int kbps[2][16] = {
+        { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160, 0 },        /* MPEG-2, 2.5 */
+        { 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 0 }     /* MPEG-1 */
+    };
+    static const int rates[4][3] = {
+        { 11025, 12000, 8000 }, { 0, 0, 0 }, { 22050, 24000, 16000 }, { 44100, 48000, 32000 }
+    };
+
+    if (avail < 4 || h[0] != 0xff || (h[1] & 0xe0) != 0xe0) {
+        return 0;
+    }
+    int const version = (h[1] >> 3) & 3;
+    int const layer = (h[1] >> 1) & 3;
+    int const bitrate = h[2] >> 4;
+    int const rate = (h[2] >> 2) & 3;
+    if (version == 1 || layer != 1 || bitrate == 0 || bitrate == 15 || rate == 3) {
+        return 0;
+    }
+    bool const mpeg1 = (version == 3);
+
+    return (mpeg1 ? 144000 : 72000) * kbps[mpeg1][bitrate] / rates[version][rate] + ((h[2] >> 1) & 1);
+}
+
+bool
+AudioData::trim_segment()
+{
+    int const frame_size = lame_get_framesize(m_gf);
+    size_t skip = m_segment.preroll / frame_size;
+    size_t keep = m_segment.samples / frame_size;
+    size_t begin = 0;
+    size_t pos = 0;
+
+    while (pos < m_frames.size() && (m_segment.last || keep > 0)) {
+        size_t const len = mp3_frame_length(&m_frames[pos], m_frames.size() - pos);
+        if (len == 0 || pos + len > m_frames.size()) {
+            cerr << "ERROR: broken mp3 frame in segment of " << m_infile << endl;
+            return false;
+        }
+        pos += len;
+        if (skip > 0) {
+            skip--;
+            begin = pos;
+        } else if (keep > 0) {
+            keep--;
+        }
+    }
+    if (skip > 0 || (!m_segment.last && keep > 0)) {
+        cerr << "ERROR: segment of " << m_infile << " is too short" << endl;
+        return false;
+    }
+    m_frames.resize(pos);
+    m_frames.erase(m_frames.begin(), m_frames.begin() + begin);
+
+    return true;
+}
+
+bool
+AudioData::join_segments(const string& outfile, const vector<vector<unsigned char> >& parts)
+{
+    size_t frames = 0;
+    size_t bytes = 0;
+    bool cbr = true;
+    const unsigned char* first = nullptr;
+
+    for (const vector<unsigned char>& part : parts) {
+        for (size_t pos = 0; pos < part.size(); frames++) {
+            size_t const len = mp3_frame_length(&part[pos], part.size() - pos);
+            if (len == 0) {
+                cerr << "ERROR: broken mp3 frame in segments of " << outfile << endl;
+                return false;
+            }
+            if (!first) {
+                first = &part[pos];
+            }
+            cbr = cbr && (part[pos + 2] >> 4) == (first[2] >> 4);
+            pos += len;
+        }
+        bytes += part.size();
+    }
+    if (!first) {
+        cerr << "ERROR: no mp3 frame in segments of " << outfile << endl;
+        return false;
+    }
+
+    /*
+     * Xing frame in place of the LAME-tag: a silent frame with the header of the first frame
+     * at the lowest bitrate that fits the side info and the frame and byte counts
+     */
+    bool const mpeg1 = ((first[1] >> 3) & 3) == 3;
+    bool const mono = (first[3] >> 6) == 3;
+    size_t const side = mpeg1 ? (mono ? 17 : 32) : (mono ? 9 : 17);
+    unsigned char h[4] = { 0xff, (unsigned char)(first[1] | 1), (unsigned char)(first[2] & 0x0c), first[3] };
+    size_t len = 0;
+    for (int bitrate = 1; bitrate < 15 && len < 4 + side + 16; bitrate++) {
+        h[2] = (unsigned char)((bitrate << 4) | (first[2] & 0x0c));
+        len = mp3_frame_length(h, sizeof(h));
+    }
+    vector<unsigned char> tag(len, 0);
+    memcpy(tag.data(), h, sizeof(h));
+    memcpy(&tag[4 + side], cbr ? "Info" : "Xing", 4);
+    uint32_t const fields[3] = { 3, (uint32_t)frames, (uint32_t)(bytes + len) };  /* flags: frames, bytes */
+    for (int i = 0; i < 3; i++) {
+        for (int b = 0; b < 4; b++) {
+            tag[4 + side + 4 * (i + 1) + b] = (unsigned char)(fields[i] >> (24 - 8 * b));
+        }
+    }
+
+    OutputWriter writer;
+    if (!writer.open(outfile)) {
+        cerr << "ERROR: failed to initialize output file" << endl;
+        return false;
+    }
+    writer.reserve(bytes + len);
+    bool ok = writer.write(tag.data(), tag.size());
+    for (const vector<unsigned char>& part : parts) {
+        ok = ok && writer.write(part.data(), part.size());
+    }
+    if (!ok || !writer.commit()) {
+        cerr << "ERROR: failed to write mp3 output" << endl;
+        return false;
+    }
+    cout << "Encoding " << outfile << " done, " << parts.size() << " segments joined" << endl;
+
+    return true;
+}
+
 void
 AudioData::init_pcm_buffer(PcmBuffer& b, int w)
 {
-    b.ch[0] = {};
-    b.ch[1] = {};
+    /* keep the capacity for the next input of a reopened instance */
+    b.ch[0].clear();
+    b.ch[1].clear();
     b.w = w;
     b.n = 0;
     b.u = 0;
@@ -417,23 +700,76 @@ AudioData::set_skip_start_and_end()
     m_pcm16.skip_end = m_pcm32.skip_end = skip_end;
 }
 
+/* heap of an initialized LAME context and the stack of lame_encoder_loop(), with some margin */
+static const size_t LAME_CONTEXT_MEMORY = 256 << 10;
+/* ifstream buffer and pcm buffers */
+static const size_t INPUT_MEMORY = 64 << 10;
+
+size_t
+AudioData::estimate_memory(double input_bytes)
+{
+    /* the presets compress 8-bit mono at 22kHz and anything richer to less than half */
+    size_t const output = (input_bytes > 0 ? (size_t)(input_bytes / 2) : 0) + LAME_MAXMP3BUFFER;
+
+    return LAME_CONTEXT_MEMORY + INPUT_MEMORY + OutputWriter::memory_estimate(output);
+}
+
+size_t
+AudioData::memory_used() const
+{
+    size_t used = LAME_CONTEXT_MEMORY + INPUT_MEMORY + m_writer.capacity() + m_frames.capacity();
+
+    for (const PcmBuffer* b : { &m_pcm32, &m_pcm16 }) {
+        size_t const pcm = b->ch[0].capacity() + b->ch[1].capacity();
+        if (pcm > INPUT_MEMORY / 4) {
+            used += pcm - INPUT_MEMORY / 4;
+        }
+    }
+
+    return used;
+}
+
+size_t
+AudioData::estimate_output_size()
+{
+    /* typical kbps of 44.1kHz stereo for VBR quality 0..9 */
+    static const int vbr_kbps[10] = { 245, 225, 190, 175, 165, 130, 115, 100, 85, 65 };
+    int kbps;
+
+    switch (lame_get_VBR(m_gf)) {
+    case vbr_off:
+        kbps = lame_get_brate(m_gf);
+        break;
+    case vbr_abr:
+        kbps = lame_get_VBR_mean_bitrate_kbps(m_gf);
+        break;
+    default:
+        kbps = vbr_kbps[min(max(lame_get_VBR_q(m_gf), 0), 9)];
+        kbps = (int)((double)kbps * lame_get_out_samplerate(m_gf) / 44100 *
+                (lame_get_num_channels(m_gf) == 1 ? 0.6 : 1.0));
+        break;
+    }
+
+    return (size_t)(duration() * kbps * 1000 / 8) + lame_get_id3v2_tag(m_gf, 0, 0) + LAME_MAXMP3BUFFER;
+}
+
 void
 AudioData::close_file()
 {
-    if (this->m_ifstream) {
-        this->m_ifstream->close();
+    if (this->m_istream) {
+        delete this->m_istream;
     }
-    if (this->m_ofstream) {
-        this->m_ofstream->close();
+    this->m_hints.close();
+    if (this->m_writer.is_open()) {
+        this->m_writer.abort();
     }
-    this->m_ifstream = nullptr;
-    this->m_ofstream = nullptr;
+    this->m_istream = nullptr;
 }
 
 AudioData::SOUNDFORMAT
 AudioData::parse_file_header(lame_t& gfp)
 {
-    int type = read_32_bits_high_low(m_ifstream);
+    int type = read_32_bits_high_low(m_istream);
 
     this->m_count_samples_carefully = 0;
     this->m_pcm_is_unsigned_8bit = 1;
@@ -468,58 +804,58 @@ AudioData::parse_wave_header(lame_t& gfp)
     int     data_length = 0;
     int     sub_size = 0;
 
-    /*file_length = */read_32_bits_high_low(m_ifstream);
-    if (read_32_bits_high_low(m_ifstream) != WAV_ID_WAVE) {
+    /*file_length = */read_32_bits_high_low(m_istream);
+    if (read_32_bits_high_low(m_istream) != WAV_ID_WAVE) {
         return -1;
     }
 
     for (int loop_count = 20; loop_count > 0; --loop_count) {
-        type = read_32_bits_high_low(m_ifstream);
+        type = read_32_bits_high_low(m_istream);
 
         if (type == WAV_ID_FMT) {
-            sub_size = read_32_bits_low_high(m_ifstream);
+            sub_size = read_32_bits_low_high(m_istream);
             sub_size = make_even_number_of_bytes_in_length(sub_size);
             if (sub_size < 16) {
                 /* chunk too short */
                 return -1;
             }
 
-            format_tag = read_16_bits_low_high(m_ifstream);
+            format_tag = read_16_bits_low_high(m_istream);
             sub_size -= 2;
-            channels = read_16_bits_low_high(m_ifstream);
+            channels = read_16_bits_low_high(m_istream);
             sub_size -= 2;
-            samples_per_sec = read_32_bits_low_high(m_ifstream);
+            samples_per_sec = read_32_bits_low_high(m_istream);
             sub_size -= 4;
-            /*avg_bytes_per_sec = */read_32_bits_low_high(m_ifstream);
+            /*avg_bytes_per_sec = */read_32_bits_low_high(m_istream);
             sub_size -= 4;
-            /*block_align = */read_16_bits_low_high(m_ifstream);
+            /*block_align = */read_16_bits_low_high(m_istream);
             sub_size -= 2;
-            bits_per_sample = read_16_bits_low_high(m_ifstream);
+            bits_per_sample = read_16_bits_low_high(m_istream);
             sub_size -= 2;
 
             if ((sub_size > 9) && (format_tag == WAVE_FORMAT_EXTENSIBLE)) {
-                read_16_bits_low_high(m_ifstream);    /* cbSize */
-                read_16_bits_low_high(m_ifstream);    /* ValidBitsPerSample */
-                read_32_bits_low_high(m_ifstream);    /* ChannelMask */
-                format_tag = read_16_bits_low_high(m_ifstream);
+                read_16_bits_low_high(m_istream);    /* cbSize */
+                read_16_bits_low_high(m_istream);    /* ValidBitsPerSample */
+                read_32_bits_low_high(m_istream);    /* ChannelMask */
+                format_tag = read_16_bits_low_high(m_istream);
                 sub_size -= 10;
             }
 
             if (sub_size > 0) {
-                if (m_ifstream->seekg(sub_size, std::ios::cur).fail()) {
+                if (m_istream->seekg(sub_size, std::ios::cur).fail()) {
                     DEBUG::ERR("WAV_ID_FMT seekg() failed");
                     return -1;
                 }
             }
         } else if (type == WAV_ID_DATA) {
-            sub_size = read_32_bits_low_high(m_ifstream);
+            sub_size = read_32_bits_low_high(m_istream);
             data_length = sub_size;
             is_wav = true;
             break;
         } else {
-            sub_size = read_32_bits_low_high(m_ifstream);
+            sub_size = read_32_bits_low_high(m_istream);
             sub_size = make_even_number_of_bytes_in_length(sub_size);
-            if (m_ifstream->seekg(sub_size, std::ios::cur).fail()) {
+            if (m_istream->seekg(sub_size, std::ios::cur).fail()) {
                 DEBUG::ERR("seekg() failed");
                 return -1;
             }
@@ -553,18 +889,25 @@ AudioData::parse_wave_header(lame_t& gfp)
     return -1;
 }
 
-ifstream*
+istream*
 AudioData::open_wave_file(lame_t& gfp, char const* infile)
 {
     lame_set_num_samples(gfp, MAX_U_32_NUM);
 
-    if (this->m_ifstream) {
+    if (this->m_istream) {
         DEBUG::WARN("file is already opened. try reopen.");
         close_file();
     }
-    this->m_ifstream = new ifstream(infile, std::ios::binary);
+    /* read by the central reader when it runs, directly otherwise */
+    this->m_istream = Reader::instance().open(infile);
+    this->m_device = nullptr;
+    if (!this->m_istream) {
+        this->m_istream = new ifstream(infile, std::ios::binary);
+        this->m_device = Storage::instance().lookup(infile);
+        this->m_hints.open(infile, 0);
+    }
 
-    if (!this->m_ifstream->is_open()) {
+    if (this->m_istream->fail()) {
         string msg = "could not find \"";
         msg += infile;
         msg += "\"";
@@ -593,25 +936,28 @@ AudioData::open_wave_file(lame_t& gfp, char const* infile)
         }
     }
 
-    return this->m_ifstream;
+    return this->m_istream;
 }
 
-bool
-AudioData::init_outfile(const string infile, const string outfile)
+string
+AudioData::output_name(const string& infile, const string& outfile)
 {
-    m_outfile = outfile;
-    if (m_outfile.empty()) {
-        m_outfile = infile;
-    }
-    string::reverse_iterator it = m_outfile.rbegin();
+    string name = outfile.empty() ? infile : outfile;
+    string::reverse_iterator it = name.rbegin();
 
     *(it + 2) = 'm';
     *(it + 1) = 'p';
     *(it)     = '3';
 
-    m_ofstream = new ofstream(m_outfile, std::ios::binary);
+    return name;
+}
+
+bool
+AudioData::init_outfile(const string infile, const string outfile)
+{
+    m_outfile = output_name(infile, outfile);
 
-    return (this->m_ofstream != NULL);
+    return m_writer.open(m_outfile);
 }
 
 bool
@@ -622,8 +968,7 @@ AudioData::init_infile(lame_t& gfp, const string infile)
     m_pcm_is_unsigned_8bit = 1;
     m_pcm_is_ieee_float = 0;
 
-    m_ifstream = open_wave_file(gfp, infile.c_str());
-    if (!m_ifstream)
+    if (!open_wave_file(gfp, infile.c_str()))
         return false;
     m_infile = infile;
 
@@ -640,16 +985,12 @@ AudioData::init_infile(lame_t& gfp, const string infile)
     return true;
 }
 
-bool
-AudioData::init(string infile, string outfile)
+void
+AudioData::apply_settings()
 {
-    m_gf = lame_init();
-    if (!m_gf) {
-        cerr << "ERROR: fatal error during initialization" << endl;
-        return false;
-    }
+    const EncodeSettings& settings = AudioData::encoding_settings;
 
-    switch (AudioData::encoding_quality) {
+    switch (settings.preset) {
     case QL_BEST:
         lame_set_preset(m_gf, INSANE);
         lame_set_quality(m_gf, 0);
@@ -665,13 +1006,73 @@ AudioData::init(string infile, string outfile)
         lame_set_VBR(m_gf, vbr_default);;
         break;
     }
+    if (settings.cbr_kbps > 0) {
+        lame_set_VBR(m_gf, vbr_off);
+        lame_set_brate(m_gf, settings.cbr_kbps);
+    } else if (settings.vbr_q >= 0) {
+        lame_set_VBR(m_gf, vbr_default);
+        lame_set_VBR_q(m_gf, settings.vbr_q);
+    }
+    if (settings.quality >= 0) {
+        lame_set_quality(m_gf, settings.quality);
+    }
+}
+
+bool
+AudioData::init_segment()
+{
+    unsigned long const n = lame_get_num_samples(m_gf);
+    int const bytes = lame_get_num_channels(m_gf) * ((m_pcmbitwidth + 7) / 8);
+
+    if (m_rconfig.input_format != SOUNDFORMAT::sf_wave || !m_count_samples_carefully ||
+        n == MAX_U_32_NUM || m_segment.first >= n || m_segment.first % SAMPLE_SIZE) {
+        return false;
+    }
+    m_segment.preroll = min(m_segment.first, (unsigned long)SEGMENT_PREROLL * SAMPLE_SIZE);
+
+    /* the stream stands at the beginning of the data chunk */
+    unsigned long const start = m_segment.first - m_segment.preroll;
+    streamoff const data = m_istream->tellg();
+    if (data < 0 || m_istream->seekg(data + (streamoff)start * bytes).fail()) {
+        DEBUG::ERR("seekg() to the segment failed");
+        return false;
+    }
+    unsigned long read = n - start;
+    if (!m_segment.last) {
+        read = min(read, m_segment.preroll + m_segment.samples + SEGMENT_TAIL * SAMPLE_SIZE);
+    }
+    lame_set_num_samples(m_gf, read);
+
+    /* every frame has to decode on its own to be cut and joined with other segments */
+    lame_set_disable_reservoir(m_gf, 1);
+    lame_set_bWriteVbrTag(m_gf, 0);
+
+    return true;
+}
+
+bool
+AudioData::init(string infile, string outfile)
+{
+    m_gf = lame_init();
+    if (!m_gf) {
+        cerr << "ERROR: fatal error during initialization" << endl;
+        return false;
+    }
+
+    apply_settings();
 
     if (!init_infile(m_gf, infile)) {
         cerr << "ERROR: failed to initialize input file: " << infile << endl;
         return false;
     }
 
-    if (!init_outfile(infile, outfile)) {
+    if (m_segment.samples) {
+        if (!init_segment()) {
+            cerr << "ERROR: " << infile << " can't be encoded in segments" << endl;
+            return false;
+        }
+        m_outfile = output_name(infile, outfile);
+    } else if (!init_outfile(infile, outfile)) {
         cerr << "ERROR: failed to initialize output file" << endl;
         return false;
     }
@@ -682,6 +1083,69 @@ AudioData::init(string infile, string outfile)
         return false;
     }
 
+    if (m_segment.samples) {
+        if (lame_get_out_samplerate(m_gf) != lame_get_in_samplerate(m_gf)) {
+            cerr << "ERROR: " << infile << " is resampled and can't be encoded in segments" << endl;
+            return false;
+        }
+        m_frames.reserve(estimate_output_size());
+    } else {
+        m_writer.reserve(estimate_output_size());
+    }
+
     DEBUG::INFO("LAME library initialization succeeded");
     return true;
 }
+
+bool
+AudioData::reopen(string infile, string outfile)
+{
+    close_file();
+    if (m_gf) {
+        lame_close(m_gf);
+        m_gf = nullptr;
+    }
+    m_infile.clear();
+    m_outfile.clear();
+    m_count_samples_carefully = 0;
+    m_num_samples_read = 0;
+    m_rconfig = { SOUNDFORMAT::sf_unknown, 0 };
+    m_stage = { 0, 0, 0, 0 };
+    m_segment = { 0, 0, 0, true };
+    m_frames.clear();
+
+    double const t = monotonic_time();
+    m_init = init(infile, outfile);
+    m_stage.open = monotonic_time() - t;
+    return m_init;
+}
+
+bool
+AudioData::probe(const string& infile, unsigned long& samples, int& samplerate, bool& splittable)
+{
+    AudioData a;
+
+    samples = 0;
+    samplerate = 0;
+    splittable = false;
+    if (!a.m_gf) {
+        return false;
+    }
+    a.apply_settings();
+    if (!a.init_infile(a.m_gf, infile)) {
+        return false;
+    }
+    samplerate = lame_get_in_samplerate(a.m_gf);
+    if (lame_get_num_samples(a.m_gf) != MAX_U_32_NUM) {
+        samples = lame_get_num_samples(a.m_gf);
+    }
+
+    lame_set_write_id3tag_automatic(a.m_gf, 0);
+    if (lame_init_params(a.m_gf) < 0) {
+        return false;
+    }
+    splittable = a.m_rconfig.input_format == SOUNDFORMAT::sf_wave && a.m_count_samples_carefully &&
+        samples > 0 && lame_get_out_samplerate(a.m_gf) == samplerate;
+
+    return true;
+}
@@ -12,6 +12,9 @@
 #include "common.h"
 #include "utils.h"
 #include "thread.h"
+#include "writer.h"
+#include "hints.h"
+#include "job.h"
 
 #include <vector>
 #include "lib/lame.h"
@@ -26,14 +29,59 @@ class AudioData : public Thread, Utils, DEBUG {
 public:
     enum QUALITY_LEVEL { QL_FAST, QL_STANDARD, QL_BEST };
 
+    /**
+     * @struct  StageTimes audio.h "audio.h"
+     * @brief   Seconds spent in each stage of lame_encoder_loop().
+     */
+    struct StageTimes {
+        double  read;       /**< reading and unpacking pcm samples */
+        double  encode;     /**< LAME encoding including the final flush */
+        double  write;      /**< writing mp3 frames and the LAME-tag */
+        double  open;       /**< opening the files and initializing LAME */
+    };
+
+    /**
+     * @struct  EncodeSettings audio.h "audio.h"
+     * @brief   LAME settings applied on top of the quality preset.
+     */
+    struct EncodeSettings {
+        QUALITY_LEVEL   preset;     /**< base preset */
+        int             quality;    /**< lame_set_quality() 0(best)..9, -1 to keep the preset */
+        int             vbr_q;      /**< VBR quality 0(best)..9, -1 to keep the preset */
+        int             cbr_kbps;   /**< constant bitrate in kbps, 0 to keep the preset */
+    };
+
+    static const int SAMPLE_SIZE = 1152;   /**< samples per channel in a frame at most */
+    /**
+     * @brief   Number of frames encoded ahead of a segment to settle the encoder state
+     *          and dropped from its output.
+     */
+    static const int SEGMENT_PREROLL = 2;
+    /**
+     * @brief   Number of frames read beyond the end of a segment so that its last frames
+     *          see the same lookahead as in a whole file encoding.
+     */
+    static const int SEGMENT_TAIL = 2;
+
     /* Constructor/Destructor */
-    AudioData(std::string infile, std::string outfile) : m_ifstream(nullptr), m_ofstream(nullptr),
+    /**
+     * @fn      AudioData(std::string infile, std::string outfile, unsigned long first, unsigned long samples, bool last)
+     * @brief   Constructor opening the input and output files.
+     *          Given samples, only the segment starting at sample first is encoded and its
+     *          frames are kept in memory for join_segments() instead of writing outfile.
+     *          first shall be a multiple of SAMPLE_SIZE, and the last segment runs to the end of the input.
+     */
+    AudioData(std::string infile, std::string outfile, unsigned long first = 0, unsigned long samples = 0,
+                bool last = true) : m_gf(nullptr), m_istream(nullptr), m_writer{},
                 m_infile{}, m_outfile{}, m_init(false), m_count_samples_carefully(0),
                 m_pcm_is_unsigned_8bit(0), m_pcm_is_ieee_float(0), m_pcmbitwidth(0),
                 m_pcm32{ {}, 0, 0, 0, 0, 0 }, m_pcm16{ {}, 0, 0, 0, 0, 0 },
-                m_num_samples_read(0), m_rconfig{SOUNDFORMAT::sf_unknown, 0}
+                m_num_samples_read(0), m_rconfig{SOUNDFORMAT::sf_unknown, 0}, m_stage{ 0, 0, 0, 0 },
+                m_heartbeat(nullptr), m_segment{ first, samples, 0, last }, m_frames{}, m_device(nullptr)
     {
+        double const t = monotonic_time();
         m_init = init(infile, outfile);
+        m_stage.open = monotonic_time() - t;
     }
 
     virtual ~AudioData() {
@@ -45,12 +93,33 @@ public:
         }
     }
 
+    /**
+     * @fn      bool reopen(std::string infile, std::string outfile)
+     * @brief   close the current files and prepare the next whole file, keeping the pcm and
+     *          output buffers. The LAME context is created anew so that the output does not
+     *          depend on the files encoded before.
+     * @return  true if initialized as by the constructor
+     */
+    bool            reopen(std::string infile, std::string outfile);
+
     /**
      * @fn      static void set_quality(QUALITY_LEVEL quality)
      * @brief   set encoding quality.
      * @param [in]  quality     encoding quality preset specified as QL_STANDARD, QL_FAST, QL_BEST
      */
     static void     set_quality(QUALITY_LEVEL quality);
+    /**
+     * @fn      static void set_settings(const EncodeSettings& settings)
+     * @brief   set encoding preset together with overrides of individual LAME settings.
+     * @param [in]  settings    settings applied to the instances created afterwards
+     */
+    static void     set_settings(const EncodeSettings& settings);
+    static const EncodeSettings& get_settings() { return encoding_settings; }  /**< current settings */
+    /**
+     * @fn      static std::string settings_name()
+     * @brief   describe the current settings, e.g. "standard", "fast+q5" or "cbr128+q2".
+     */
+    static std::string settings_name();
     /**
      * @fn      void* lame_encoder_loop(void* data)
      * @brief   An encoding subroutine to be run as thread.
@@ -63,9 +132,91 @@ public:
      * @brief   A function to be binded to thread. lame_encoder_loop() takes place.
      */
     void            run();
+    /**
+     * @fn      bool encode()
+     * @brief   Encode the whole input on the calling thread.
+     * @return  true if the output was written without error
+     */
+    bool            encode();
+    /**
+     * @fn      double duration()
+     * @brief   get the duration of the input audio.
+     * @return  seconds of audio, 0 if unknown
+     */
+    double          duration();
+    /**
+     * @fn      std::string format_name()
+     * @brief   describe the input sample format, e.g. "24-bit stereo 44100Hz".
+     */
+    std::string     format_name();
+    const StageTimes& stage_times() const { return m_stage; }  /**< time spent per stage */
+    void            set_heartbeat(Heartbeat* hb) { m_heartbeat = hb; }  /**< report progress to hb */
+    /**
+     * @fn      static size_t estimate_memory(double input_bytes)
+     * @brief   estimate the working set of encoding an input file before opening it:
+     *          LAME context, input stream and pcm buffers, and the output buffer.
+     * @param [in]  input_bytes     size of the input file
+     * @return  upper bound in bytes
+     */
+    static size_t   estimate_memory(double input_bytes);
+    /**
+     * @fn      size_t memory_used()
+     * @brief   get the working set actually allocated so far, counted the same way as
+     *          estimate_memory().
+     */
+    size_t          memory_used() const;
+    /**
+     * @fn      static bool probe(const std::string& infile, unsigned long& samples, int& samplerate, bool& splittable)
+     * @brief   read the header of an input file without opening an output.
+     * @param [in]  infile      input file
+     * @param [out] samples     number of samples of the input audio, 0 if unknown
+     * @param [out] samplerate  sampling rate of the input audio
+     * @param [out] splittable  the input can be encoded in segments: a seekable wave file
+     *                          of known length that is not resampled
+     * @return  true if the header is valid
+     */
+    static bool     probe(const std::string& infile, unsigned long& samples, int& samplerate,
+                                bool& splittable);
+    /**
+     * @fn      static std::string output_name(const std::string& infile, const std::string& outfile)
+     * @brief   get the output file: outfile, or infile if empty, with the extension replaced by mp3.
+     */
+    static std::string output_name(const std::string& infile, const std::string& outfile);
+    /**
+     * @fn      void take_segment(std::vector<unsigned char>& frames)
+     * @brief   move out the frames of a segment encoded by encode().
+     */
+    void            take_segment(std::vector<unsigned char>& frames) { frames.swap(m_frames); m_frames.clear(); }
+    /**
+     * @fn      static bool join_segments(const std::string& outfile, const std::vector<std::vector<unsigned char> >& parts)
+     * @brief   write the frames of all the segments of a file in order, behind a Xing frame
+     *          carrying the number of frames and bytes.
+     * @return  true if the output was written without error
+     */
+    static bool     join_segments(const std::string& outfile,
+                                const std::vector<std::vector<unsigned char> >& parts);
 
 private:
-    static const int SAMPLE_SIZE = 1152;
+    /**
+     * @brief   PcmBench drives the private PCM path from in-memory streams.
+     *          QualityBench reads the source PCM to measure fidelity of encoded output.
+     * @see     bench/bench_pcm.cpp, bench/bench_quality.cpp
+     */
+    friend class PcmBench;
+    friend class QualityBench;
+
+    /**
+     * @fn      AudioData()
+     * @brief   Constructor for the in-memory seam. Only the LAME context is created;
+     *          no file is opened and the caller attaches its own input stream.
+     */
+    AudioData() : m_gf(lame_init()), m_istream(nullptr), m_writer{},
+                m_infile{}, m_outfile{}, m_init(false), m_count_samples_carefully(0),
+                m_pcm_is_unsigned_8bit(0), m_pcm_is_ieee_float(0), m_pcmbitwidth(0),
+                m_pcm32{ {}, 0, 0, 0, 0, 0 }, m_pcm16{ {}, 0, 0, 0, 0, 0 },
+                m_num_samples_read(0), m_rconfig{SOUNDFORMAT::sf_unknown, 0}, m_stage{ 0, 0, 0, 0 },
+                m_heartbeat(nullptr), m_segment{ 0, 0, 0, true }, m_frames{}, m_device(nullptr) {}
+
     enum class SOUNDFORMAT {
         sf_unknown,
         sf_raw,
@@ -100,11 +251,26 @@ private:
         int         skip_end;       /**< number of samples to ignore at the end */
     };
 
+    /**
+     * @struct  Segment audio.h "audio.h"
+     * @brief   Range of the input encoded by a segment instance.
+     */
+    struct Segment {
+        unsigned long   first;      /**< first sample */
+        unsigned long   samples;    /**< number of samples, 0 for the whole input */
+        unsigned long   preroll;    /**< samples encoded ahead of first and dropped */
+        bool            last;       /**< the segment runs to the end of the input */
+    };
+
     /* Private functions */
     bool            init(std::string infile, std::string outfile);
     bool            init_infile(lame_t& gfp, const std::string infile);
     bool            init_outfile(const std::string infile, const std::string outfile);
-    std::ifstream*  open_wave_file(lame_t& gfp, char const* infile);
+    bool            init_segment();
+    bool            trim_segment();
+    void            apply_settings();
+    bool            output(const unsigned char* data, size_t len);
+    std::istream*   open_wave_file(lame_t& gfp, char const* infile);
     SOUNDFORMAT     parse_file_header(lame_t& gfp);
     int             parse_wave_header(lame_t& gfp);
     void            close_file();
@@ -113,16 +279,17 @@ private:
     int             add_pcm_buffer(PcmBuffer& b, void* a0, void* a1, int read);
     int             take_pcm_buffer(PcmBuffer& b, void* a0, void* a1, int a_n, int mm);
     void            set_skip_start_and_end();
+    size_t          estimate_output_size();
     int             get_audio(lame_t gf, int buffer[2][SAMPLE_SIZE]);
     int             get_audio_common(lame_t gf, int buffer[2][SAMPLE_SIZE]);
-    int             read_samples_pcm(std::ifstream* ifs, int sample_buffer[2 * SAMPLE_SIZE],
+    int             read_samples_pcm(std::istream* ifs, int sample_buffer[2 * SAMPLE_SIZE],
                                     int samples_to_read);
-    int             unpack_read_samples(std::ifstream* ifs, int* sample_buffer,
+    int             unpack_read_samples(std::istream* ifs, int* sample_buffer,
                         const int samples_to_read, const int bytes_per_sample, const int swap_order);
 
     lame_t          m_gf;
-    std::ifstream*  m_ifstream;
-    std::ofstream*  m_ofstream;
+    std::istream*   m_istream;
+    OutputWriter    m_writer;
     std::string     m_infile;
     std::string     m_outfile;
     bool            m_init;
@@ -134,7 +301,13 @@ private:
     PcmBuffer       m_pcm16;
     unsigned int    m_num_samples_read;
     ReaderConfig    m_rconfig;
-    static QUALITY_LEVEL encoding_quality;
+    StageTimes      m_stage;
+    Heartbeat*      m_heartbeat;
+    Segment         m_segment;
+    std::vector<unsigned char> m_frames;    /**< output of a segment */
+    Storage::Device* m_device;      /**< device whose I/O limit direct reads take, nullptr otherwise */
+    StreamHints     m_hints;        /**< page cache hints of a direct input under --stream */
+    static EncodeSettings encoding_settings;
 
     /**
      * @brief   Constant values for parsing wave header
@@ -0,0 +1,443 @@
+/**
+ * @file        bench.cpp
+ * @version     1.0
+ * @brief       MP3enc_cpp benchmark harness source
+ * @date        Oct 18, 2026
+ * @author      Siwon Kang (kkangshawn@gmail.com)
+ */
+
+#include "bench.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <dirent.h>
+using namespace std;
+
+#ifndef GIT_COMMIT
+#define GIT_COMMIT "unknown"
+#endif
+
+JsonValue::JsonValue(const vector<double>& v) : type(J_ARRAY), number(0)
+{
+    for (double d : v) {
+        items.push_back(JsonValue(d));
+    }
+}
+
+const JsonValue&
+JsonValue::operator[](const string& key) const
+{
+    static const JsonValue null_value;
+
+    for (const auto& m : members) {
+        if (m.first == key) {
+            return m.second;
+        }
+    }
+
+    return null_value;
+}
+
+JsonValue&
+JsonValue::set(const string& key, const JsonValue& v)
+{
+    for (auto& m : members) {
+        if (m.first == key) {
+            m.second = v;
+            return m.second;
+        }
+    }
+    members.push_back(make_pair(key, v));
+
+    return members.back().second;
+}
+
+vector<double>
+JsonValue::numbers() const
+{
+    vector<double> v;
+
+    for (const JsonValue& i : items) {
+        if (i.type == J_NUMBER) {
+            v.push_back(i.number);
+        }
+    }
+
+    return v;
+}
+
+static void
+dump_string(ostream& out, const string& s)
+{
+    out << '"';
+    for (char c : s) {
+        switch (c) {
+        case '"':  out << "\\\""; break;
+        case '\\': out << "\\\\"; break;
+        case '\n': out << "\\n"; break;
+        case '\t': out << "\\t"; break;
+        default:
+            if ((unsigned char)c < 0x20) {
+                out << "\\u" << hex << setw(4) << setfill('0') << (int)c << dec << setfill(' ');
+            } else {
+                out << c;
+            }
+            break;
+        }
+    }
+    out << '"';
+}
+
+void
+JsonValue::dump(ostream& out, int indent) const
+{
+    string const pad(indent + 2, ' ');
+
+    switch (type) {
+    case J_NULL:
+        out << "null";
+        break;
+    case J_BOOL:
+        out << (number ? "true" : "false");
+        break;
+    case J_NUMBER:
+        out << setprecision(10) << number;
+        break;
+    case J_STRING:
+        dump_string(out, str);
+        break;
+    case J_ARRAY:
+        out << '[';
+        for (size_t i = 0; i < items.size(); i++) {
+            out << (i ? ", " : "");
+            items[i].dump(out, indent);
+        }
+        out << ']';
+        break;
+    case J_OBJECT:
+        out << '{';
+        for (size_t i = 0; i < members.size(); i++) {
+            out << (i ? ",\n" : "\n") << pad;
+            dump_string(out, members[i].first);
+            out << ": ";
+            members[i].second.dump(out, indent + 2);
+        }
+        out << '\n' << string(indent, ' ') << '}';
+        break;
+    }
+}
+
+/**
+ * @class   JsonParser
+ * @brief   Recursive descent parser for JsonValue::parse().
+ */
+class JsonParser {
+public:
+    explicit JsonParser(const string& text) : m_text(text), m_pos(0) {}
+
+    bool parse(JsonValue& v) {
+        if (!value(v)) {
+            return false;
+        }
+        skip();
+        return m_pos == m_text.size();
+    }
+
+private:
+    void skip() {
+        while (m_pos < m_text.size() && isspace((unsigned char)m_text[m_pos])) {
+            m_pos++;
+        }
+    }
+    bool eat(char c) {
+        skip();
+        if (m_pos < m_text.size() && m_text[m_pos] == c) {
+            m_pos++;
+            return true;
+        }
+        return false;
+    }
+    bool literal(const char* word) {
+        size_t const n = string(word).size();
+        if (m_text.compare(m_pos, n, word) != 0) {
+            return false;
+        }
+        m_pos += n;
+        return true;
+    }
+    bool string_value(string& s) {
+        if (!eat('"')) {
+            return false;
+        }
+        while (m_pos < m_text.size() && m_text[m_pos] != '"') {
+            char c = m_text[m_pos++];
+            if (c == '\\' && m_pos < m_text.size()) {
+                c = m_text[m_pos++];
+                switch (c) {
+                case 'n': c = '\n'; break;
+                case 't': c = '\t'; break;
+                case 'u':
+                    c = (char)strtol(m_text.substr(m_pos, 4).c_str(), NULL, 16);
+                    m_pos += 4;
+                    break;
+                default: break;
+                }
+            }
+            s += c;
+        }
+        return eat('"');
+    }
+    bool value(JsonValue& v) {
+        skip();
+        if (m_pos >= m_text.size()) {
+            return false;
+        }
+        char const c = m_text[m_pos];
+        if (c == '{') {
+            v = JsonValue::object();
+            m_pos++;
+            if (eat('}')) {
+                return true;
+            }
+            do {
+                string key;
+                JsonValue member;
+                if (!string_value(key) || !eat(':') || !value(member)) {
+                    return false;
+                }
+                v.members.push_back(make_pair(key, member));
+            } while (eat(','));
+            return eat('}');
+        } else if (c == '[') {
+            v = JsonValue::array();
+            m_pos++;
+            if (eat(']')) {
+                return true;
+            }
+            do {
+                JsonValue item;
+                if (!value(item)) {
+                    return false;
+                }
+                v.items.push_back(item);
+            } while (eat(','));
+            return eat(']');
+        } else if (c == '"') {
+            v.type = JsonValue::J_STRING;
+            return string_value(v.str);
+        } else if (literal("true")) {
+            v.type = JsonValue::J_BOOL;
+            v.number = 1;
+            return true;
+        } else if (literal("false")) {
+            v.type = JsonValue::J_BOOL;
+            v.number = 0;
+            return true;
+        } else if (literal("null")) {
+            v.type = JsonValue::J_NULL;
+            return true;
+        }
+        char* end;
+        v.type = JsonValue::J_NUMBER;
+        v.number = strtod(m_text.c_str() + m_pos, &end);
+        if (end == m_text.c_str() + m_pos) {
+            return false;
+        }
+        m_pos = end - m_text.c_str();
+        return true;
+    }
+
+    const string&   m_text;
+    size_t          m_pos;
+};
+
+bool
+JsonValue::parse(const string& text, JsonValue& out)
+{
+    return JsonParser(text).parse(out);
+}
+
+double
+Stats::mean(const vector<double>& v)
+{
+    double sum = 0;
+
+    for (double d : v) {
+        sum += d;
+    }
+
+    return v.empty() ? 0 : sum / v.size();
+}
+
+double
+Stats::stddev(const vector<double>& v)
+{
+    double const m = mean(v);
+    double sum = 0;
+
+    if (v.size() < 2) {
+        return 0;
+    }
+    for (double d : v) {
+        sum += (d - m) * (d - m);
+    }
+
+    return sqrt(sum / (v.size() - 1));
+}
+
+double
+Stats::percentile(vector<double> v, double p)
+{
+    if (v.empty()) {
+        return 0;
+    }
+    sort(v.begin(), v.end());
+    size_t rank = (size_t)ceil(p / 100.0 * v.size());
+
+    return v[rank > 0 ? min(rank, v.size()) - 1 : 0];
+}
+
+double
+Stats::t_quantile(double df)
+{
+    static const double table[30] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+    int const n = (int)floor(df);
+
+    if (n < 1) {
+        return table[0];
+    }
+    if (n <= 30) {
+        return table[n - 1];
+    }
+
+    return 1.960 + 2.4 / n;
+}
+
+bool
+Stats::diff_ci(const vector<double>& a, const vector<double>& b,
+        double& delta, double& lo, double& hi)
+{
+    double const ma = mean(a);
+    double const mb = mean(b);
+
+    delta = lo = hi = 0;
+    if (a.size() < 2 || b.size() < 2 || ma == 0) {
+        return false;
+    }
+
+    double const va = stddev(a) * stddev(a) / a.size();
+    double const vb = stddev(b) * stddev(b) / b.size();
+    double const se = sqrt(va + vb);
+    double df = a.size() + b.size() - 2;
+    if (va + vb > 0) {
+        df = (va + vb) * (va + vb) /
+            (va * va / (a.size() - 1) + vb * vb / (b.size() - 1));
+    }
+    double const half = t_quantile(df) * se;
+
+    delta = (mb - ma) / ma;
+    lo = (mb - ma - half) / ma;
+    hi = (mb - ma + half) / ma;
+
+    return true;
+}
+
+string
+Host::cpu_model()
+{
+    ifstream in("/proc/cpuinfo");
+    string line;
+
+    while (getline(in, line)) {
+        if (line.compare(0, 10, "model name") == 0) {
+            size_t pos = line.find(':');
+            if (pos != string::npos) {
+                return line.substr(line.find_first_not_of(' ', pos + 1));
+            }
+        }
+    }
+
+    return "unknown";
+}
+
+string
+Host::commit()
+{
+    return GIT_COMMIT;
+}
+
+string
+Host::timestamp()
+{
+    char buf[32];
+    time_t now = time(NULL);
+
+    strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+    return buf;
+}
+
+void
+Host::reset_peak_rss()
+{
+    ofstream out("/proc/self/clear_refs");
+
+    out << "5" << endl;
+}
+
+double
+Host::peak_rss_kb()
+{
+    ifstream in("/proc/self/status");
+    string line;
+
+    while (getline(in, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) {
+            return atof(line.c_str() + 6);
+        }
+    }
+
+    return 0;
+}
+
+void
+Corpus::collect(const string& path, vector<string>& files)
+{
+    DIR* dir = opendir(path.c_str());
+    struct dirent* ent;
+    vector<string> found;
+
+    auto is_wav = [](const string& f) {
+        return f.size() > 4 && f.compare(f.size() - 4, 4, ".wav") == 0;
+    };
+
+    if (!dir) {
+        if (is_wav(path)) {
+            files.push_back(path);
+        }
+        return;
+    }
+    while ((ent = readdir(dir)) != NULL) {
+        string const name = ent->d_name;
+        if (ent->d_type == DT_DIR) {
+            if (name != "." && name != "..") {
+                collect(path + "/" + name, found);
+            }
+        } else if (ent->d_type == DT_REG && is_wav(name)) {
+            found.push_back(path + "/" + name);
+        }
+    }
+    closedir(dir);
+    sort(found.begin(), found.end());
+    files.insert(files.end(), found.begin(), found.end());
+}
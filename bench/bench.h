@@ -0,0 +1,113 @@
+/**
+ * @file        bench.h
+ * @version     1.0
+ * @brief       MP3enc_cpp benchmark harness header
+ * @date        Oct 18, 2026
+ * @author      Siwon Kang (kkangshawn@gmail.com)
+ */
+
+#ifndef _BENCH_H
+#define _BENCH_H
+
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @struct  JsonValue bench.h "bench.h"
+ * @brief   Minimal JSON document used to store and load benchmark baselines.
+ */
+struct JsonValue {
+    enum TYPE { J_NULL, J_BOOL, J_NUMBER, J_STRING, J_ARRAY, J_OBJECT };
+
+    JsonValue() : type(J_NULL), number(0) {}
+    JsonValue(double v) : type(J_NUMBER), number(v) {}
+    JsonValue(const std::string& v) : type(J_STRING), number(0), str(v) {}
+    JsonValue(const char* v) : type(J_STRING), number(0), str(v) {}
+    JsonValue(const std::vector<double>& v);
+
+    static JsonValue array() { JsonValue v; v.type = J_ARRAY; return v; }   /**< empty array */
+    static JsonValue object() { JsonValue v; v.type = J_OBJECT; return v; } /**< empty object */
+
+    /**
+     * @fn      const JsonValue& operator[](const std::string& key) const
+     * @brief   look up a member of an object.
+     * @return  the member, or a null value if missing
+     */
+    const JsonValue&    operator[](const std::string& key) const;
+    /**
+     * @fn      JsonValue& set(const std::string& key, const JsonValue& v)
+     * @brief   add or replace a member of an object.
+     * @return  the stored member
+     */
+    JsonValue&          set(const std::string& key, const JsonValue& v);
+    std::vector<double> numbers() const;    /**< elements of a numeric array */
+    void                dump(std::ostream& out, int indent = 0) const;
+
+    /**
+     * @fn      static bool parse(const std::string& text, JsonValue& out)
+     * @brief   parse a JSON document.
+     * @return  false if the text is not valid JSON
+     */
+    static bool         parse(const std::string& text, JsonValue& out);
+
+    TYPE                        type;
+    double                      number;     /**< J_NUMBER and J_BOOL */
+    std::string                 str;        /**< J_STRING */
+    std::vector<JsonValue>      items;      /**< J_ARRAY */
+    std::vector<std::pair<std::string, JsonValue> > members;    /**< J_OBJECT */
+};
+
+/**
+ * @class   Stats bench.h "bench.h"
+ * @brief   Statistics over repeated benchmark samples.
+ */
+class Stats {
+public:
+    static double   mean(const std::vector<double>& v);
+    static double   stddev(const std::vector<double>& v);   /**< sample standard deviation */
+    static double   percentile(std::vector<double> v, double p);    /**< nearest rank */
+    /**
+     * @fn      static bool diff_ci(const std::vector<double>& a, const std::vector<double>& b,
+     *                              double& delta, double& lo, double& hi)
+     * @brief   95% confidence interval of the change from a to b by Welch's t-test,
+     *          relative to the mean of a.
+     * @param [out] delta   (mean(b) - mean(a)) / mean(a)
+     * @param [out] lo      lower bound of delta
+     * @param [out] hi      upper bound of delta
+     * @return  false if either side has fewer than two samples
+     */
+    static bool     diff_ci(const std::vector<double>& a, const std::vector<double>& b,
+                            double& delta, double& lo, double& hi);
+private:
+    static double   t_quantile(double df);  /**< two-sided 95% quantile of Student's t */
+};
+
+/**
+ * @class   Host bench.h "bench.h"
+ * @brief   Information about the host and the build a benchmark runs on.
+ */
+class Host {
+public:
+    static std::string  cpu_model();
+    static std::string  commit();           /**< commit the benchmark was built from */
+    static std::string  timestamp();        /**< current UTC time in ISO 8601 */
+    static void         reset_peak_rss();   /**< restart peak RSS accounting of the process */
+    static double       peak_rss_kb();      /**< peak RSS since the last reset */
+};
+
+/**
+ * @class   Corpus bench.h "bench.h"
+ * @brief   Input set of a benchmark.
+ */
+class Corpus {
+public:
+    /**
+     * @fn      static void collect(const std::string& path, std::vector<std::string>& files)
+     * @brief   append wav files under path, or path itself if it is a wav file, in sorted order.
+     */
+    static void collect(const std::string& path, std::vector<std::string>& files);
+};
+
+#endif  /* _BENCH_H */
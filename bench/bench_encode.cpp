@@ -0,0 +1,364 @@
+/**
+ * @file        bench_encode.cpp
+ * @version     1.0
+ * @brief       MP3enc_cpp encode benchmark with baseline storage and regression comparison
+ * @date        Oct 18, 2026
+ * @author      Siwon Kang (kkangshawn@gmail.com)
+ */
+
+#include "../audio.h"
+#include "bench.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <unistd.h>
+using namespace std;
+
+/**
+ * @class   EncodeBench
+ * @brief   Encodes a corpus serially several times, grouped by input format, and records
+ *          throughput, per-stage time and peak RSS. Results can be saved as a JSON baseline
+ *          and compared against another baseline with confidence intervals.
+ */
+class EncodeBench : public Utils {
+public:
+    EncodeBench() : m_repeat(5), m_threshold(0.02) {}
+
+    bool parse(int argc, char** argv);
+    int  run();
+
+private:
+    static const int SCHEMA = 1;    /**< version of the baseline format */
+
+    /**
+     * @struct  Case
+     * @brief   Files sharing an input format and their samples, one per repeat.
+     */
+    struct Case {
+        vector<string>  files;
+        double          audio;
+        vector<double>  throughput;     /**< audio seconds encoded per second */
+        vector<double>  read;           /**< ms spent reading per audio second */
+        vector<double>  encode;         /**< ms spent encoding per audio second */
+        vector<double>  write;          /**< ms spent writing per audio second */
+        vector<double>  rss;            /**< peak RSS in KB */
+    };
+
+    bool        group(const string& scratch);
+    void        measure(const string& scratch);
+    JsonValue   to_json();
+    int         compare(const JsonValue& base, const JsonValue& cur);
+    static bool load(const string& path, JsonValue& v);
+
+    vector<string>      m_corpus;       /**< input wav files */
+    map<string, Case>   m_cases;        /**< cases by format name */
+    int                 m_repeat;       /**< runs per case */
+    double              m_threshold;    /**< smallest relative change reported as regression */
+    string              m_save;         /**< baseline file to write */
+    vector<string>      m_compare;      /**< baseline files to compare */
+};
+
+bool
+EncodeBench::parse(int argc, char** argv)
+{
+    for (int i = 1; i < argc; i++) {
+        if (!scmp(argv[i], "-n") && i + 1 < argc) {
+            m_repeat = atoi(argv[++i]);
+        } else if (!scmp(argv[i], "--save") && i + 1 < argc) {
+            m_save = argv[++i];
+        } else if (!scmp(argv[i], "--threshold") && i + 1 < argc) {
+            m_threshold = atof(argv[++i]) / 100.0;
+        } else if (!scmp(argv[i], "--compare") && i + 1 < argc) {
+            m_compare.push_back(argv[++i]);
+            if (i + 1 < argc && argv[i + 1][0] != '-' &&
+                    string(argv[i + 1]).rfind(".json") == string(argv[i + 1]).size() - 5) {
+                m_compare.push_back(argv[++i]);
+            }
+        } else if (argv[i][0] != '-') {
+            Corpus::collect(argv[i], m_corpus);
+        } else {
+            return false;
+        }
+    }
+    if (m_compare.size() == 2) {
+        return m_corpus.empty();
+    }
+
+    return !m_corpus.empty() && m_repeat > 0;
+}
+
+bool
+EncodeBench::group(const string& scratch)
+{
+    string const out = scratch + DELIMITER + "probe.mp3";
+    streambuf* saved = cout.rdbuf(nullptr);
+
+    for (const string& f : m_corpus) {
+        AudioData ad(f, out);
+        double const audio = ad.duration();
+        if (audio <= 0) {
+            cerr << "WARNING: skipping " << f << endl;
+            continue;
+        }
+        Case& c = m_cases[ad.format_name()];
+        c.files.push_back(f);
+        c.audio += audio;
+    }
+    cout.rdbuf(saved);
+    remove(out.c_str());
+
+    return !m_cases.empty();
+}
+
+void
+EncodeBench::measure(const string& scratch)
+{
+    string const out = scratch + DELIMITER + "out.mp3";
+
+    for (int n = 0; n < m_repeat; n++) {
+        for (auto& it : m_cases) {
+            Case& c = it.second;
+            AudioData::StageTimes st = { 0, 0, 0, 0 };
+            double audio = 0;
+
+            streambuf* saved = cout.rdbuf(nullptr);
+            Host::reset_peak_rss();
+            double const start = monotonic_time();
+            for (const string& f : c.files) {
+                AudioData ad(f, out);
+                audio += ad.duration();
+                ad.encode();
+                st.read += ad.stage_times().read;
+                st.encode += ad.stage_times().encode;
+                st.write += ad.stage_times().write;
+            }
+            double const wall = monotonic_time() - start;
+            c.rss.push_back(Host::peak_rss_kb());
+            cout.rdbuf(saved);
+
+            c.throughput.push_back(audio / wall);
+            c.read.push_back(st.read * 1000.0 / audio);
+            c.encode.push_back(st.encode * 1000.0 / audio);
+            c.write.push_back(st.write * 1000.0 / audio);
+            cerr << "run " << n + 1 << "/" << m_repeat << " " << it.first << ": "
+                 << fixed << setprecision(2) << audio / wall << "x realtime" << endl;
+        }
+    }
+    remove(out.c_str());
+}
+
+JsonValue
+EncodeBench::to_json()
+{
+    JsonValue root = JsonValue::object();
+    JsonValue host = JsonValue::object();
+    JsonValue cases = JsonValue::array();
+
+    host.set("cpu", Host::cpu_model());
+    host.set("cores", (double)sysconf(_SC_NPROCESSORS_ONLN));
+
+    root.set("schema", (double)SCHEMA);
+    root.set("tool", "bench_encode");
+    root.set("commit", Host::commit());
+    root.set("lame", get_lame_version());
+    root.set("date", Host::timestamp());
+    root.set("host", host);
+    root.set("repeat", (double)m_repeat);
+
+    for (const auto& it : m_cases) {
+        const Case& c = it.second;
+        JsonValue jc = JsonValue::object();
+        JsonValue metrics = JsonValue::object();
+        JsonValue files = JsonValue::array();
+
+        for (const string& f : c.files) {
+            files.items.push_back(f);
+        }
+        metrics.set("throughput_x", c.throughput);
+        metrics.set("read_ms_per_s", c.read);
+        metrics.set("encode_ms_per_s", c.encode);
+        metrics.set("write_ms_per_s", c.write);
+        metrics.set("peak_rss_kb", c.rss);
+
+        jc.set("name", it.first);
+        jc.set("audio_s", c.audio);
+        jc.set("files", files);
+        jc.set("metrics", metrics);
+        cases.items.push_back(jc);
+    }
+    root.set("cases", cases);
+
+    return root;
+}
+
+bool
+EncodeBench::load(const string& path, JsonValue& v)
+{
+    ifstream in(path);
+    stringstream text;
+
+    if (!in.is_open()) {
+        cerr << "ERROR: failed to open " << path << endl;
+        return false;
+    }
+    text << in.rdbuf();
+    if (!JsonValue::parse(text.str(), v)) {
+        cerr << "ERROR: " << path << " is not a valid baseline" << endl;
+        return false;
+    }
+    if (v["schema"].number != SCHEMA) {
+        cerr << "ERROR: " << path << " has baseline schema " << v["schema"].number
+             << ", expected " << SCHEMA << endl;
+        return false;
+    }
+
+    return true;
+}
+
+int
+EncodeBench::compare(const JsonValue& base, const JsonValue& cur)
+{
+    /* metrics and whether a larger value is better */
+    static const pair<const char*, bool> metrics[] = {
+        { "throughput_x", true },
+        { "read_ms_per_s", false },
+        { "encode_ms_per_s", false },
+        { "write_ms_per_s", false },
+        { "peak_rss_kb", false },
+    };
+    vector<string> regressions;
+
+    cout << "base: " << base["commit"].str << " (" << base["lame"].str << ") on "
+         << base["host"]["cpu"].str << endl;
+    cout << "new:  " << cur["commit"].str << " (" << cur["lame"].str << ") on "
+         << cur["host"]["cpu"].str << endl;
+    if (base["host"]["cpu"].str != cur["host"]["cpu"].str) {
+        cout << "WARNING: baselines come from different CPU models" << endl;
+    }
+    cout << endl << left << setw(26) << "case" << setw(18) << "metric" << right
+         << setw(12) << "base" << setw(12) << "new" << setw(9) << "delta"
+         << setw(22) << "95% CI" << "  verdict" << endl;
+
+    for (const JsonValue& bc : base["cases"].items) {
+        const JsonValue* cc = nullptr;
+        for (const JsonValue& c : cur["cases"].items) {
+            if (c["name"].str == bc["name"].str) {
+                cc = &c;
+            }
+        }
+        if (!cc) {
+            cout << left << setw(26) << bc["name"].str << "missing in new results" << endl;
+            continue;
+        }
+        for (const auto& m : metrics) {
+            vector<double> const a = bc["metrics"][m.first].numbers();
+            vector<double> const b = (*cc)["metrics"][m.first].numbers();
+            double delta, lo, hi;
+            string verdict;
+            ostringstream ci;
+
+            if (!Stats::diff_ci(a, b, delta, lo, hi)) {
+                verdict = "n/a (needs 2+ runs)";
+            } else {
+                double const worse_lo = m.second ? -hi : lo;
+                double const better_hi = m.second ? -lo : hi;
+                if (worse_lo > 0 && (m.second ? -delta : delta) >= m_threshold) {
+                    verdict = "REGRESSION";
+                    ostringstream r;
+                    r << bc["name"].str << ": " << m.first << " " << fixed << setprecision(1)
+                      << fabs(delta) * 100 << "% " << (m.second ? "slower" : "higher")
+                      << " (95% CI " << fabs(m.second ? hi : lo) * 100 << "% .. "
+                      << fabs(m.second ? lo : hi) * 100 << "%)";
+                    regressions.push_back(r.str());
+                } else if (better_hi < 0) {
+                    verdict = "improved";
+                } else {
+                    verdict = "~";
+                }
+                ci << fixed << setprecision(1) << "[" << lo * 100 << "%, " << hi * 100 << "%]";
+            }
+            cout << left << setw(26) << bc["name"].str << setw(18) << m.first << right
+                 << fixed << setprecision(3) << setw(12) << Stats::mean(a)
+                 << setw(12) << Stats::mean(b) << setprecision(1) << setw(8) << delta * 100
+                 << "%" << setw(22) << ci.str() << "  " << verdict << endl;
+        }
+    }
+
+    cout << endl;
+    for (const string& r : regressions) {
+        cout << "REGRESSION: " << r << endl;
+    }
+    if (regressions.empty()) {
+        cout << "no significant regression" << endl;
+    }
+
+    return regressions.empty() ? 0 : 2;
+}
+
+int
+EncodeBench::run()
+{
+    JsonValue base, cur;
+
+    if (m_compare.size() == 2) {
+        if (!load(m_compare[0], base) || !load(m_compare[1], cur)) {
+            return 1;
+        }
+        return compare(base, cur);
+    }
+    if (!m_compare.empty() && !load(m_compare[0], base)) {
+        return 1;
+    }
+
+    char tmpl[] = "/tmp/mp3enc_bench.XXXXXX";
+    if (!mkdtemp(tmpl)) {
+        cerr << "ERROR: failed to create scratch directory" << endl;
+        return 1;
+    }
+    if (!group(tmpl)) {
+        cerr << "ERROR: no encodable input in the corpus" << endl;
+        rmdir(tmpl);
+        return 1;
+    }
+    measure(tmpl);
+    rmdir(tmpl);
+    cur = to_json();
+
+    if (!m_save.empty()) {
+        ofstream out(m_save);
+        cur.dump(out);
+        out << endl;
+        if (out.fail()) {
+            cerr << "ERROR: failed to write " << m_save << endl;
+            return 1;
+        }
+        cerr << "baseline saved to " << m_save << endl;
+    }
+    if (!m_compare.empty()) {
+        return compare(base, cur);
+    }
+    if (m_save.empty()) {
+        cur.dump(cout);
+        cout << endl;
+    }
+
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    EncodeBench bench;
+
+    if (!bench.parse(argc, argv)) {
+        cout << "Usage:" << endl;
+        cout << "   bench_encode <corpus_dir | file.wav>... [-n <repeat>] [--save <baseline.json>]"
+                " [--compare <baseline.json>] [--threshold <percent>]" << endl;
+        cout << "   bench_encode --compare <base.json> <new.json> [--threshold <percent>]" << endl;
+        return 1;
+    }
+
+    return bench.run();
+}
@@ -0,0 +1,254 @@
+/**
+ * @file        bench_pcm.cpp
+ * @version     1.0
+ * @brief       MP3enc_cpp micro-benchmarks for the PCM input path
+ * @date        Oct 18, 2026
+ * @author      Siwon Kang (kkangshawn@gmail.com)
+ */
+
+#include "../audio.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+using namespace std;
+
+/**
+ * @class   PcmBench
+ * @brief   Drives the private PCM path of AudioData from in-memory sources and
+ *          reports ns per sample and GB/s for each case.
+ */
+class PcmBench {
+public:
+    explicit PcmBench(double seconds) : m_seconds(seconds), m_sink(0) {}
+
+    void run_all();
+
+private:
+    typedef chrono::steady_clock Clock;
+
+    void bench_unpack(int bits, bool is_float);
+    void bench_deinterleave(int channels);
+    void bench_pcm_buffer(int skip);
+    void bench_wave_header(int chunks);
+    void report(const string& name, const char* unit, double ns, double units, double bytes);
+    bool expired(Clock::time_point start) {
+        return chrono::duration<double>(Clock::now() - start).count() >= m_seconds;
+    }
+    static string make_pcm(size_t bytes, bool is_float);
+
+    double      m_seconds;  /**< minimum measuring time per case */
+    long long   m_sink;     /**< keeps results alive against the optimizer */
+};
+
+static const size_t SOURCE_BYTES = 4 << 20;
+
+string
+PcmBench::make_pcm(size_t bytes, bool is_float)
+{
+    string s(bytes, '\0');
+
+    srand(1);
+    if (is_float) {
+        float* f = (float*)&s[0];
+        for (size_t i = 0; i < bytes / sizeof(float); i++) {
+            f[i] = (float)rand() / RAND_MAX * 2.0f - 1.0f;
+        }
+    } else {
+        for (size_t i = 0; i < bytes; i++) {
+            s[i] = (char)rand();
+        }
+    }
+
+    return s;
+}
+
+void
+PcmBench::report(const string& name, const char* unit, double ns, double units, double bytes)
+{
+    cout << left << setw(32) << name << right
+         << setw(10) << fixed << setprecision(3) << ns / units << " ns/" << left << setw(8) << unit
+         << right << setw(9) << setprecision(3) << bytes / ns << " GB/s" << endl;
+}
+
+void
+PcmBench::bench_unpack(int bits, bool is_float)
+{
+    AudioData ad;
+    istringstream in(make_pcm(SOURCE_BYTES, is_float));
+    int buf[2 * AudioData::SAMPLE_SIZE];
+    int const bytes_per_sample = bits / 8;
+    double samples = 0;
+
+    ad.m_pcm_is_ieee_float = is_float ? 1 : 0;
+
+    Clock::time_point start = Clock::now();
+    while (!expired(start)) {
+        int n = ad.unpack_read_samples(&in, buf, 2 * AudioData::SAMPLE_SIZE, bytes_per_sample,
+                                        bits == 8 ? 1 : 0);
+        if (n < 2 * AudioData::SAMPLE_SIZE) {
+            in.clear();
+            in.seekg(0);
+        }
+        samples += n;
+        m_sink += buf[n > 0 ? n - 1 : 0];
+    }
+    double ns = chrono::duration<double, nano>(Clock::now() - start).count();
+
+    ostringstream name;
+    name << "unpack_read_samples/" << bits << (is_float ? "f" : "");
+    report(name.str(), "sample", ns, samples, samples * bytes_per_sample);
+}
+
+void
+PcmBench::bench_deinterleave(int channels)
+{
+    AudioData ad;
+    istringstream in(make_pcm(SOURCE_BYTES, false));
+    int buf[2][AudioData::SAMPLE_SIZE];
+    double samples = 0;
+
+    lame_set_num_channels(ad.m_gf, channels);
+    lame_set_in_samplerate(ad.m_gf, 44100);
+    lame_set_write_id3tag_automatic(ad.m_gf, 0);
+    if (lame_init_params(ad.m_gf) < 0) {
+        cerr << "ERROR: lame_init_params() error" << endl;
+        return;
+    }
+    ad.m_istream = &in;
+    ad.m_pcmbitwidth = 16;
+
+    Clock::time_point start = Clock::now();
+    while (!expired(start)) {
+        int n = ad.get_audio_common(ad.m_gf, buf);
+        if (n < lame_get_framesize(ad.m_gf)) {
+            in.clear();
+            in.seekg(0);
+        }
+        samples += n * channels;
+        m_sink += buf[0][0];
+    }
+    double ns = chrono::duration<double, nano>(Clock::now() - start).count();
+    ad.m_istream = nullptr;
+
+    ostringstream name;
+    name << "get_audio_common/" << channels << "ch";
+    report(name.str(), "sample", ns, samples, samples * 2);
+}
+
+void
+PcmBench::bench_pcm_buffer(int skip)
+{
+    AudioData ad;
+    int in[2][AudioData::SAMPLE_SIZE];
+    int out[2][AudioData::SAMPLE_SIZE];
+    double samples = 0;
+
+    for (int i = 0; i < AudioData::SAMPLE_SIZE; i++) {
+        in[0][i] = i;
+        in[1][i] = -i;
+    }
+    ad.init_pcm_buffer(ad.m_pcm32, sizeof(int));
+
+    Clock::time_point start = Clock::now();
+    while (!expired(start)) {
+        ad.m_pcm32.skip_start = skip;
+        int used = ad.add_pcm_buffer(ad.m_pcm32, in[0], in[1], AudioData::SAMPLE_SIZE);
+        int n = ad.take_pcm_buffer(ad.m_pcm32, out[0], out[1], used, AudioData::SAMPLE_SIZE);
+        samples += AudioData::SAMPLE_SIZE;
+        m_sink += n;
+    }
+    double ns = chrono::duration<double, nano>(Clock::now() - start).count();
+
+    ostringstream name;
+    name << "add_take_pcm_buffer/skip" << skip;
+    report(name.str(), "sample", ns, samples, samples * 2 * sizeof(int));
+}
+
+void
+PcmBench::bench_wave_header(int chunks)
+{
+    AudioData ad;
+    ostringstream hdr;
+    double headers = 0;
+
+    auto put32 = [&hdr](unsigned int v) { hdr.write((const char*)&v, 4); };
+    auto put16 = [&hdr](unsigned short v) { hdr.write((const char*)&v, 2); };
+
+    hdr << "RIFF";
+    put32(0);
+    hdr << "WAVE";
+    for (int i = 0; i < chunks; i++) {
+        hdr << "LIST";
+        put32(26);
+        hdr << string(26, 'x');
+    }
+    hdr << "fmt ";
+    put32(16);
+    put16(1);
+    put16(2);
+    put32(44100);
+    put32(44100 * 4);
+    put16(4);
+    put16(16);
+    hdr << "data";
+    put32(0);
+
+    string const bytes = hdr.str();
+    istringstream in(bytes);
+    ad.m_istream = &in;
+
+    Clock::time_point start = Clock::now();
+    while (!expired(start)) {
+        in.clear();
+        in.seekg(4);
+        m_sink += ad.parse_wave_header(ad.m_gf);
+        headers++;
+    }
+    double ns = chrono::duration<double, nano>(Clock::now() - start).count();
+    ad.m_istream = nullptr;
+
+    ostringstream name;
+    name << "parse_wave_header/" << chunks << "chunks";
+    report(name.str(), "header", ns, headers, headers * bytes.size());
+}
+
+void
+PcmBench::run_all()
+{
+    bench_unpack(8, false);
+    bench_unpack(16, false);
+    bench_unpack(24, false);
+    bench_unpack(32, false);
+    bench_unpack(32, true);
+    bench_deinterleave(1);
+    bench_deinterleave(2);
+    bench_pcm_buffer(0);
+    bench_pcm_buffer(529);
+    bench_wave_header(0);
+    bench_wave_header(18);
+
+    if (m_sink == 42) {
+        cout << endl;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    double seconds = 0.5;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+            seconds = atof(argv[++i]);
+        } else {
+            cout << "Usage: bench_pcm [-t <seconds per case>]" << endl;
+            return 1;
+        }
+    }
+
+    PcmBench(seconds).run_all();
+
+    return 0;
+}
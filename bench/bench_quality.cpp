@@ -0,0 +1,361 @@
+/**
+ * @file        bench_quality.cpp
+ * @version     1.0
+ * @brief       MP3enc_cpp quality preset speed/size/fidelity matrix benchmark
+ * @date        Oct 18, 2026
+ * @author      Siwon Kang (kkangshawn@gmail.com)
+ */
+
+#include "../audio.h"
+#include "bench.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <unistd.h>
+using namespace std;
+
+/**
+ * @class   QualityBench
+ * @brief   Encodes a corpus with every quality preset and a grid of LAME settings, decodes
+ *          the output with hip_decode and reports encode speed, size and SNR against
+ *          the source together with the Pareto-optimal settings.
+ */
+class QualityBench : public Utils {
+public:
+    QualityBench() : m_repeat(1), m_quality{ 2, 7 }, m_vbr{ 0, 2, 4, 6, 9 },
+                m_cbr{ 96, 128, 192, 256, 320 }, m_csv(false) {}
+
+    bool parse(int argc, char** argv);
+    int  run();
+
+private:
+    /**
+     * @struct  Source
+     * @brief   Input file with its pcm samples normalized to [-1, 1).
+     */
+    struct Source {
+        string          path;
+        int             rate;
+        int             channels;
+        double          audio;
+        vector<double>  pcm[2];
+    };
+
+    /**
+     * @struct  Result
+     * @brief   Measurement of one setting over the whole corpus.
+     */
+    struct Result {
+        AudioData::EncodeSettings settings;
+        string  name;
+        double  speed;      /**< audio seconds encoded per second */
+        double  kbps;       /**< average output bitrate */
+        double  snr;        /**< SNR in dB over the whole corpus */
+        double  worst;      /**< lowest SNR of a single file */
+        bool    pareto;     /**< not dominated by any other setting */
+    };
+
+    bool        load(const string& path, const string& scratch, Source& src);
+    Result      measure(const AudioData::EncodeSettings& s, const string& scratch);
+    double      decode_snr(const Source& src, const string& mp3, double& signal, double& noise);
+    static vector<int> parse_list(const char* arg);
+    void        print(vector<Result>& results);
+
+    vector<string>  m_corpus;   /**< input wav files */
+    vector<Source>  m_sources;  /**< decoded inputs */
+    int             m_repeat;   /**< encodes per file, the fastest one counts */
+    vector<int>     m_quality;  /**< lame_set_quality values combined with CBR bitrates */
+    vector<int>     m_vbr;      /**< VBR qualities */
+    vector<int>     m_cbr;      /**< CBR bitrates */
+    bool            m_csv;      /**< print CSV instead of a table */
+};
+
+vector<int>
+QualityBench::parse_list(const char* arg)
+{
+    vector<int> v;
+    stringstream ss(arg);
+    string item;
+
+    while (getline(ss, item, ',')) {
+        if (!item.empty()) {
+            v.push_back(atoi(item.c_str()));
+        }
+    }
+
+    return v;
+}
+
+bool
+QualityBench::parse(int argc, char** argv)
+{
+    for (int i = 1; i < argc; i++) {
+        if (!scmp(argv[i], "-n") && i + 1 < argc) {
+            m_repeat = atoi(argv[++i]);
+        } else if (!scmp(argv[i], "--quality") && i + 1 < argc) {
+            m_quality = parse_list(argv[++i]);
+        } else if (!scmp(argv[i], "--vbr") && i + 1 < argc) {
+            m_vbr = parse_list(argv[++i]);
+        } else if (!scmp(argv[i], "--cbr") && i + 1 < argc) {
+            m_cbr = parse_list(argv[++i]);
+        } else if (!scmp(argv[i], "--csv")) {
+            m_csv = true;
+        } else if (argv[i][0] != '-') {
+            Corpus::collect(argv[i], m_corpus);
+        } else {
+            return false;
+        }
+    }
+
+    return !m_corpus.empty() && m_repeat > 0;
+}
+
+bool
+QualityBench::load(const string& path, const string& scratch, Source& src)
+{
+    string const out = scratch + DELIMITER + "source.mp3";
+    AudioData ad(path, out);
+    int buf[2][AudioData::SAMPLE_SIZE];
+    int n;
+
+    remove(out.c_str());
+    if (!ad.m_init) {
+        return false;
+    }
+    src.path = path;
+    src.rate = lame_get_in_samplerate(ad.m_gf);
+    src.channels = lame_get_num_channels(ad.m_gf);
+    src.audio = ad.duration();
+    while ((n = ad.get_audio(ad.m_gf, buf)) > 0) {
+        for (int c = 0; c < src.channels; c++) {
+            for (int i = 0; i < n; i++) {
+                src.pcm[c].push_back(buf[c][i] / 2147483648.0);
+            }
+        }
+    }
+
+    return !src.pcm[0].empty();
+}
+
+double
+QualityBench::decode_snr(const Source& src, const string& mp3, double& signal, double& noise)
+{
+    ifstream in(mp3, ios::binary);
+    vector<unsigned char> data((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    vector<double> dec[2];
+    short l[AudioData::SAMPLE_SIZE * 4], r[AudioData::SAMPLE_SIZE * 4];
+    mp3data_struct info;
+    int delay = -1, padding = -1;
+    int rate = 0, channels = 0;
+
+    memset(&info, 0, sizeof(info));
+    hip_t hip = hip_decode_init();
+    size_t pos = 0;
+    while (pos <= data.size()) {
+        size_t const len = min((size_t)1024, data.size() - pos);
+        int n = hip_decode1_headersB(hip, data.data() + pos, len, l, r, &info, &delay, &padding);
+        pos += len;
+        while (n > 0) {
+            for (int i = 0; i < n; i++) {
+                dec[0].push_back(l[i] / 32768.0);
+                dec[1].push_back(r[i] / 32768.0);
+            }
+            n = hip_decode1_headersB(hip, NULL, 0, l, r, &info, &delay, &padding);
+        }
+        if (info.header_parsed) {
+            rate = info.samplerate;
+            channels = info.stereo;
+        }
+        if (len == 0) {
+            break;
+        }
+    }
+    hip_decode_exit(hip);
+    if (rate <= 0 || dec[0].empty()) {
+        return -INFINITY;
+    }
+
+    /* linear resampling back to the source rate if LAME resampled the input */
+    if (rate != src.rate) {
+        for (int c = 0; c < 2; c++) {
+            vector<double> res;
+            double const step = (double)rate / src.rate;
+            for (double x = 0; x + 1 < dec[c].size(); x += step) {
+                size_t const i = (size_t)x;
+                res.push_back(dec[c][i] + (dec[c][i + 1] - dec[c][i]) * (x - i));
+            }
+            dec[c].swap(res);
+        }
+    }
+
+    /* find the encoder and decoder delay by cross-correlation around the first second */
+    size_t const window = min((size_t)src.rate, src.pcm[0].size());
+    size_t const max_lag = min((size_t)4096, dec[0].size() > window ? dec[0].size() - window : 0);
+    size_t lag = 0;
+    double best = -INFINITY;
+    for (size_t k = 0; k <= max_lag; k++) {
+        double corr = 0;
+        for (size_t i = 0; i < window; i++) {
+            corr += src.pcm[0][i] * dec[0][i + k];
+        }
+        if (corr > best) {
+            best = corr;
+            lag = k;
+        }
+    }
+
+    double s = 0, e = 0;
+    for (int c = 0; c < src.channels; c++) {
+        int const dc = (channels == 1) ? 0 : c;
+        size_t const n = min(src.pcm[c].size(), dec[dc].size() - lag);
+        for (size_t i = 0; i < n; i++) {
+            double const d = src.pcm[c][i] - dec[dc][i + lag];
+            s += src.pcm[c][i] * src.pcm[c][i];
+            e += d * d;
+        }
+    }
+    signal += s;
+    noise += e;
+
+    return e > 0 ? 10 * log10(s / e) : INFINITY;
+}
+
+QualityBench::Result
+QualityBench::measure(const AudioData::EncodeSettings& settings, const string& scratch)
+{
+    string const out = scratch + DELIMITER + "out.mp3";
+    Result r = { settings, {}, 0, 0, 0, INFINITY, false };
+    double wall = 0, audio = 0, bytes = 0, signal = 0, noise = 0;
+
+    AudioData::set_settings(settings);
+    r.name = AudioData::settings_name();
+
+    for (const Source& src : m_sources) {
+        double fastest = INFINITY;
+        for (int n = 0; n < m_repeat; n++) {
+            streambuf* saved = cout.rdbuf(nullptr);
+            double const start = monotonic_time();
+            {
+                AudioData ad(src.path, out);
+                ad.encode();
+            }
+            fastest = min(fastest, monotonic_time() - start);
+            cout.rdbuf(saved);
+        }
+        wall += fastest;
+        audio += src.audio;
+        bytes += get_file_size(out.c_str());
+        r.worst = min(r.worst, decode_snr(src, out, signal, noise));
+    }
+    remove(out.c_str());
+
+    r.speed = audio / wall;
+    r.kbps = bytes * 8 / audio / 1000;
+    r.snr = noise > 0 ? 10 * log10(signal / noise) : INFINITY;
+    cerr << left << setw(14) << r.name << right << fixed << setprecision(2)
+         << r.speed << "x " << r.kbps << "kbps " << r.snr << "dB" << endl;
+
+    return r;
+}
+
+void
+QualityBench::print(vector<Result>& results)
+{
+    for (Result& a : results) {
+        a.pareto = true;
+        for (const Result& b : results) {
+            bool const no_worse = b.speed >= a.speed && b.kbps <= a.kbps && b.snr >= a.snr;
+            bool const better = b.speed > a.speed || b.kbps < a.kbps || b.snr > a.snr;
+            if (no_worse && better) {
+                a.pareto = false;
+                break;
+            }
+        }
+    }
+    sort(results.begin(), results.end(),
+            [](const Result& a, const Result& b) { return a.kbps < b.kbps; });
+
+    if (m_csv) {
+        cout << "settings,realtime_x,kbps,snr_db,worst_snr_db,pareto" << endl;
+        for (const Result& r : results) {
+            cout << r.name << ',' << fixed << setprecision(3) << r.speed << ',' << r.kbps << ','
+                 << r.snr << ',' << r.worst << ',' << (r.pareto ? 1 : 0) << endl;
+        }
+        return;
+    }
+    cout << left << setw(14) << "settings" << right << setw(12) << "realtime_x"
+         << setw(10) << "kbps" << setw(10) << "SNR dB" << setw(12) << "worst dB" << "  pareto" << endl;
+    for (const Result& r : results) {
+        cout << left << setw(14) << r.name << right << fixed << setprecision(2)
+             << setw(12) << r.speed << setw(10) << r.kbps << setw(10) << r.snr
+             << setw(12) << r.worst << "  " << (r.pareto ? "*" : "") << endl;
+    }
+}
+
+int
+QualityBench::run()
+{
+    char tmpl[] = "/tmp/mp3enc_bench.XXXXXX";
+    if (!mkdtemp(tmpl)) {
+        cerr << "ERROR: failed to create scratch directory" << endl;
+        return 1;
+    }
+
+    streambuf* saved = cout.rdbuf(nullptr);
+    for (const string& f : m_corpus) {
+        Source src;
+        if (load(f, tmpl, src)) {
+            m_sources.push_back(src);
+        } else {
+            cerr << "WARNING: skipping " << f << endl;
+        }
+    }
+    cout.rdbuf(saved);
+    if (m_sources.empty()) {
+        cerr << "ERROR: no encodable input in the corpus" << endl;
+        rmdir(tmpl);
+        return 1;
+    }
+
+    vector<AudioData::EncodeSettings> grid;
+    grid.push_back({ AudioData::QL_FAST, -1, -1, 0 });
+    grid.push_back({ AudioData::QL_STANDARD, -1, -1, 0 });
+    grid.push_back({ AudioData::QL_BEST, -1, -1, 0 });
+    for (int v : m_vbr) {
+        grid.push_back({ AudioData::QL_STANDARD, -1, v, 0 });
+    }
+    for (int b : m_cbr) {
+        for (int q : m_quality) {
+            grid.push_back({ AudioData::QL_STANDARD, q, -1, b });
+        }
+    }
+
+    AudioData::EncodeSettings const orig = AudioData::get_settings();
+    vector<Result> results;
+    for (const AudioData::EncodeSettings& s : grid) {
+        results.push_back(measure(s, tmpl));
+    }
+    AudioData::set_settings(orig);
+    rmdir(tmpl);
+
+    print(results);
+
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    QualityBench bench;
+
+    if (!bench.parse(argc, argv)) {
+        cout << "Usage: bench_quality <corpus_dir | file.wav>... [-n <repeat>] [--quality <q,...>]"
+                " [--vbr <q,...>] [--cbr <kbps,...>] [--csv]" << endl;
+        return 1;
+    }
+
+    return bench.run();
+}
@@ -0,0 +1,215 @@
+/**
+ * @file        bench_scale.cpp
+ * @version     1.0
+ * @brief       MP3enc_cpp thread-scaling sweep benchmark
+ * @date        Oct 18, 2026
+ * @author      Siwon Kang (kkangshawn@gmail.com)
+ */
+
+#include "../pool.h"
+#include "bench.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <unistd.h>
+using namespace std;
+
+/**
+ * @class   ScaleBench
+ * @brief   Encodes a fixed corpus at 1, 2, 4, ... N workers and emits throughput,
+ *          per-core efficiency and job latency percentiles as CSV.
+ */
+class ScaleBench : public Utils {
+public:
+    ScaleBench() : m_max_workers(WorkerPool::default_workers()), m_repeat(3),
+                m_hot(true), m_cold(true), m_scratch{} {}
+
+    bool parse(int argc, char** argv);
+    int  run(ostream& out);
+
+private:
+    /**
+     * @struct  Run
+     * @brief   Result of one encode of the whole corpus.
+     */
+    struct Run {
+        size_t  workers;
+        double  wall;
+        double  audio;
+        double  bytes;
+        size_t  failed;
+        double  p50;
+        double  p99;
+    };
+
+    void    warm();
+    void    drop();
+    Run     encode(size_t workers);
+
+    vector<string>  m_corpus;       /**< input wav files */
+    size_t          m_max_workers;  /**< largest worker count of the sweep */
+    int             m_repeat;       /**< runs per worker count */
+    bool            m_hot;          /**< run with inputs in the page cache */
+    bool            m_cold;         /**< run with inputs evicted from the page cache */
+    string          m_scratch;      /**< directory for outputs */
+};
+
+bool
+ScaleBench::parse(int argc, char** argv)
+{
+    for (int i = 1; i < argc; i++) {
+        if (!scmp(argv[i], "-j") && i + 1 < argc) {
+            m_max_workers = atoi(argv[++i]);
+        } else if (!scmp(argv[i], "-n") && i + 1 < argc) {
+            m_repeat = atoi(argv[++i]);
+        } else if (!scmp(argv[i], "--hot")) {
+            m_cold = false;
+        } else if (!scmp(argv[i], "--cold")) {
+            m_hot = false;
+        } else if (argv[i][0] != '-') {
+            Corpus::collect(argv[i], m_corpus);
+        } else {
+            return false;
+        }
+    }
+
+    return !m_corpus.empty() && m_max_workers > 0 && m_repeat > 0;
+}
+
+void
+ScaleBench::warm()
+{
+    vector<char> buf(1 << 20);
+
+    for (const string& f : m_corpus) {
+        ifstream in(f, ios::binary);
+        while (in.read(buf.data(), buf.size()).gcount() > 0) {
+        }
+    }
+}
+
+void
+ScaleBench::drop()
+{
+    for (const string& f : m_corpus) {
+        if (!drop_file_cache(f.c_str())) {
+            cerr << "WARNING: failed to drop page cache of " << f << endl;
+        }
+    }
+}
+
+ScaleBench::Run
+ScaleBench::encode(size_t workers)
+{
+    vector<Job*> jobs;
+    vector<double> latency;
+    Run r = { workers, 0, 0, 0, 0, 0, 0 };
+
+    for (size_t i = 0; i < m_corpus.size(); i++) {
+        ostringstream out;
+        out << m_scratch << DELIMITER << i << ".mp3";
+        jobs.push_back(new Job(i, m_corpus[i], out.str()));
+    }
+
+    /* encoder progress goes to cout; keep it out of the CSV */
+    streambuf* saved = cout.rdbuf(nullptr);
+    double const start = monotonic_time();
+    {
+        WorkerPool pool(workers);
+        pool.start();
+        for (Job* j : jobs) {
+            pool.submit(j);
+        }
+        pool.finish();
+    }
+    r.wall = monotonic_time() - start;
+    cout.rdbuf(saved);
+
+    for (Job* j : jobs) {
+        if (j->state == Job::JS_DONE) {
+            r.audio += j->audioSeconds;
+            r.bytes += get_file_size(j->inPath.c_str());
+            latency.push_back(j->latency() * 1000.0);
+        } else {
+            r.failed++;
+        }
+        remove(j->outPath.c_str());
+        delete j;
+    }
+    r.p50 = Stats::percentile(latency, 50);
+    r.p99 = Stats::percentile(latency, 99);
+
+    return r;
+}
+
+int
+ScaleBench::run(ostream& out)
+{
+    char tmpl[] = "/tmp/mp3enc_bench.XXXXXX";
+    if (!mkdtemp(tmpl)) {
+        cerr << "ERROR: failed to create scratch directory" << endl;
+        return 1;
+    }
+    m_scratch = tmpl;
+
+    vector<size_t> counts;
+    for (size_t w = 1; w < m_max_workers; w *= 2) {
+        counts.push_back(w);
+    }
+    counts.push_back(m_max_workers);
+
+    out << "cache,workers,run,wall_s,jobs,failed,audio_s,realtime_x,input_mb_s,"
+           "efficiency,p50_ms,p99_ms" << endl;
+
+    for (int cold = 0; cold < 2; cold++) {
+        if ((cold && !m_cold) || (!cold && !m_hot)) {
+            continue;
+        }
+        double base = 0;
+        for (size_t w : counts) {
+            vector<Run> runs;
+            if (!cold) {
+                warm();
+            }
+            for (int n = 0; n < m_repeat; n++) {
+                if (cold) {
+                    drop();
+                }
+                runs.push_back(encode(w));
+            }
+            if (w == counts.front()) {
+                for (const Run& r : runs) {
+                    base += r.audio / r.wall / w / runs.size();
+                }
+            }
+            for (size_t n = 0; n < runs.size(); n++) {
+                const Run& r = runs[n];
+                double const speed = r.audio / r.wall;
+                out << (cold ? "cold" : "hot") << ',' << w << ',' << n << ','
+                    << fixed << setprecision(4) << r.wall << ',' << m_corpus.size() << ','
+                    << r.failed << ',' << r.audio << ',' << speed << ','
+                    << r.bytes / r.wall / 1e6 << ',' << (base > 0 ? speed / w / base : 0) << ','
+                    << r.p50 << ',' << r.p99 << endl;
+            }
+        }
+    }
+    rmdir(m_scratch.c_str());
+
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    ScaleBench bench;
+
+    if (!bench.parse(argc, argv)) {
+        cout << "Usage: bench_scale <corpus_dir | file.wav>... [-j <max workers>] [-n <repeat>]"
+                " [--hot | --cold]" << endl;
+        return 1;
+    }
+
+    return bench.run(cout);
+}
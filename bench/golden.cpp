@@ -0,0 +1,376 @@
+/**
+ * @file        golden.cpp
+ * @version     1.0
+ * @brief       MP3enc_cpp bit-exact golden output harness
+ * @date        Oct 18, 2026
+ * @author      Siwon Kang (kkangshawn@gmail.com)
+ */
+
+#include "../pool.h"
+#include "../audio.h"
+#include "../hints.h"
+#include "../reader.h"
+#include "bench.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <unistd.h>
+using namespace std;
+
+/**
+ * @class   Golden
+ * @brief   Encodes a fixed corpus with every quality preset and compares digests of the
+ *          outputs against stored golden digests. Every execution mode has to produce
+ *          output identical to the serial one.
+ */
+class Golden : public Utils {
+public:
+    Golden() : m_update(false) {}
+
+    bool parse(int argc, char** argv);
+    int  run();
+
+private:
+    /**
+     * @struct  Mode
+     * @brief   A way of running the encoder that has to produce identical output.
+     */
+    struct Mode {
+        const char* name;
+        size_t      workers;
+        size_t      batch;      /**< largest input batched in bytes, 0 to disable */
+        bool        central;    /**< inputs read by the Reader */
+        bool        stream;     /**< inputs and outputs kept out of the page cache */
+        bool        warm;       /**< workers keep their encoder context between jobs */
+    };
+
+    typedef map<string, string> Digests;    /**< "<preset> <input>" to digest */
+
+    void    synthesize(const string& dir);
+    void    write_wav(const string& path, int format, int bits, int channels, int rate,
+                    bool extensible, bool extra_chunk);
+    void    encode(const Mode& mode, const string& preset, Digests& d);
+    bool    load(Digests& d);
+    bool    save(const Digests& d);
+    static string digest(const string& path);
+
+    vector<pair<string, string> >   m_corpus;   /**< input name and path */
+    vector<string>                  m_synth;    /**< synthesized inputs to clean up */
+    string                          m_golden;   /**< file with golden digests */
+    string                          m_scratch;  /**< directory for synthesized inputs and outputs */
+    bool                            m_update;   /**< rewrite the golden digests */
+};
+
+string
+Golden::digest(const string& path)
+{
+    ifstream in(path, ios::binary);
+    uint64_t h = 0xcbf29ce484222325ULL;     /* FNV-1a */
+    char buf[65536];
+    streamsize n;
+
+    if (!in.is_open()) {
+        return "missing";
+    }
+    while ((n = in.read(buf, sizeof(buf)).gcount()) > 0) {
+        for (streamsize i = 0; i < n; i++) {
+            h ^= (unsigned char)buf[i];
+            h *= 0x100000001b3ULL;
+        }
+    }
+    ostringstream s;
+    s << hex << setw(16) << setfill('0') << h;
+
+    return s.str();
+}
+
+void
+Golden::write_wav(const string& path, int format, int bits, int channels, int rate,
+        bool extensible, bool extra_chunk)
+{
+    ofstream out(path, ios::binary);
+    int const frames = rate * 2;
+    int const bytes = bits / 8;
+    unsigned int const data_size = frames * channels * bytes;
+    unsigned int seed = 12345;
+
+    auto put32 = [&out](unsigned int v) { out.write((const char*)&v, 4); };
+    auto put16 = [&out](unsigned short v) { out.write((const char*)&v, 2); };
+
+    out << "RIFF";
+    put32(0);
+    out << "WAVE";
+    if (extra_chunk) {
+        out << "LIST";
+        put32(5);
+        out << "INFO" << '\0' << '\0';
+    }
+    out << "fmt ";
+    put32(extensible ? 40 : 16);
+    put16(extensible ? 0xFFFE : format);
+    put16(channels);
+    put32(rate);
+    put32(rate * channels * bytes);
+    put16(channels * bytes);
+    put16(bits);
+    if (extensible) {
+        put16(22);
+        put16(bits);
+        put32(channels == 2 ? 3 : 4);
+        put16(format);
+        out.write("\x00\x00\x00\x00\x10\x00\x80\x00\x00\xaa\x00\x38\x9b\x71", 14);
+    }
+    out << "data";
+    put32(data_size);
+
+    for (int i = 0; i < frames; i++) {
+        for (int c = 0; c < channels; c++) {
+            seed = seed * 1103515245 + 12345;
+            double const noise = ((seed >> 16) & 0x7fff) / 32768.0 - 0.5;
+            double const v = 0.5 * sin(2 * M_PI * (440.0 + 110 * c) * i / rate) +
+                0.25 * sin(2 * M_PI * 3000.0 * i / rate) + 0.05 * noise;
+            if (format == 3) {
+                float const f = (float)v;
+                out.write((const char*)&f, 4);
+            } else if (bits == 8) {
+                out.put((char)(unsigned char)(128 + v * 127));
+            } else {
+                long long const s = (long long)(v * ((1LL << (bits - 1)) - 1));
+                for (int b = 0; b < bytes; b++) {
+                    out.put((char)((s >> (8 * b)) & 0xff));
+                }
+            }
+        }
+    }
+}
+
+void
+Golden::synthesize(const string& dir)
+{
+    static const struct {
+        const char* name;
+        int format, bits, channels, rate;
+        bool extensible, extra_chunk;
+    } cases[] = {
+        { "pcm8_mono_22050.wav", 1, 8, 1, 22050, false, false },
+        { "pcm16_stereo_44100.wav", 1, 16, 2, 44100, false, false },
+        { "pcm16_mono_list_chunk.wav", 1, 16, 1, 32000, false, true },
+        { "pcm24_stereo_48000.wav", 1, 24, 2, 48000, false, false },
+        { "pcm24_extensible.wav", 1, 24, 2, 44100, true, false },
+        { "pcm32_stereo_44100.wav", 1, 32, 2, 44100, false, false },
+        { "float_stereo_44100.wav", 3, 32, 2, 44100, false, false },
+    };
+
+    for (const auto& c : cases) {
+        string const path = dir + DELIMITER + c.name;
+        write_wav(path, c.format, c.bits, c.channels, c.rate, c.extensible, c.extra_chunk);
+        m_corpus.push_back(make_pair(string("synth/") + c.name, path));
+        m_synth.push_back(path);
+    }
+}
+
+bool
+Golden::parse(int argc, char** argv)
+{
+    vector<string> files;
+
+    for (int i = 1; i < argc; i++) {
+        if (!scmp(argv[i], "--update")) {
+            m_update = true;
+        } else if (!scmp(argv[i], "--golden") && i + 1 < argc) {
+            m_golden = argv[++i];
+        } else if (argv[i][0] != '-') {
+            Corpus::collect(argv[i], files);
+        } else {
+            return false;
+        }
+    }
+    for (const string& f : files) {
+        m_corpus.push_back(make_pair(f, f));
+    }
+
+    return !m_golden.empty();
+}
+
+void
+Golden::encode(const Mode& mode, const string& preset, Digests& d)
+{
+    vector<Job*> jobs;
+
+    for (size_t i = 0; i < m_corpus.size(); i++) {
+        ostringstream out;
+        out << m_scratch << DELIMITER << mode.name << "_" << i << ".mp3";
+        jobs.push_back(new Job(i, m_corpus[i].second, out.str()));
+    }
+
+    streambuf* saved = cout.rdbuf(nullptr);
+    streambuf* saved_err = cerr.rdbuf(nullptr);
+    size_t const hold = OutputWriter::get_hold_limit();
+    if (mode.batch) {
+        /* as --batch does */
+        OutputWriter::set_hold_limit(max(hold, mode.batch));
+    }
+    StreamHints::set_enabled(mode.stream);
+    if (mode.central) {
+        /* small chunks so that every input takes several reads */
+        Reader::instance().configure(64 << 10, 4, 256 << 10);
+        Reader::instance().start();
+    }
+    {
+        WorkerPool pool(mode.workers);
+        pool.set_batching(mode.batch, 16);
+        pool.set_prefetch(mode.central ? 2 : 0);
+        pool.set_warm(mode.warm);
+        pool.start();
+        for (Job* j : jobs) {
+            pool.submit(j);
+        }
+        pool.finish();
+    }
+    Reader::instance().stop();
+    StreamHints::set_enabled(false);
+    OutputWriter::set_hold_limit(hold);
+    cout.rdbuf(saved);
+    cerr.rdbuf(saved_err);
+
+    for (Job* j : jobs) {
+        d[preset + " " + m_corpus[j->id].first] =
+            (j->state == Job::JS_DONE) ? digest(j->outPath) : "failed";
+        remove(j->outPath.c_str());
+        delete j;
+    }
+}
+
+bool
+Golden::load(Digests& d)
+{
+    ifstream in(m_golden);
+    string preset, name, hash;
+
+    if (!in.is_open()) {
+        cerr << "ERROR: no golden digests in " << m_golden << ", run with --update first" << endl;
+        return false;
+    }
+    while (in >> preset >> name >> hash) {
+        if (preset[0] != '#') {
+            d[preset + " " + name] = hash;
+        } else {
+            getline(in, hash);
+        }
+    }
+
+    return true;
+}
+
+bool
+Golden::save(const Digests& d)
+{
+    ofstream out(m_golden);
+
+    out << "# MP3enc_cpp golden output digests (FNV-1a 64 of the mp3 file), LAME "
+        << get_lame_version() << endl;
+    for (const auto& it : d) {
+        out << it.first << " " << it.second << endl;
+    }
+
+    return !out.fail();
+}
+
+int
+Golden::run()
+{
+    static const char* presets[] = { "fast", "standard", "best" };
+    static const AudioData::QUALITY_LEVEL levels[] = {
+        AudioData::QL_FAST, AudioData::QL_STANDARD, AudioData::QL_BEST
+    };
+    Mode const modes[] = {
+        { "serial", 1, 0, false, false, false },
+        { "parallel", max((size_t)4, WorkerPool::default_workers()), 0, false, false, false },
+        /* every input of the corpus batched, buffers reused across formats */
+        { "batch", 2, 4 << 20, false, false, false },
+        { "central", 4, 0, true, false, false },
+        { "stream", 4, 0, false, true, false },
+        /* as --daemon runs its workers */
+        { "warm", 2, 0, false, false, true },
+    };
+    vector<Digests> results(sizeof(modes) / sizeof(modes[0]));
+    int failures = 0;
+
+    char tmpl[] = "/tmp/mp3enc_golden.XXXXXX";
+    if (!mkdtemp(tmpl)) {
+        cerr << "ERROR: failed to create scratch directory" << endl;
+        return 1;
+    }
+    m_scratch = tmpl;
+    synthesize(m_scratch);
+
+    for (size_t p = 0; p < sizeof(presets) / sizeof(presets[0]); p++) {
+        AudioData::set_quality(levels[p]);
+        for (size_t m = 0; m < results.size(); m++) {
+            encode(modes[m], presets[p], results[m]);
+        }
+    }
+    for (const string& f : m_synth) {
+        remove(f.c_str());
+    }
+    rmdir(m_scratch.c_str());
+
+    const Digests& serial = results[0];
+    for (size_t m = 1; m < results.size(); m++) {
+        for (const auto& it : serial) {
+            if (results[m][it.first] != it.second) {
+                cout << "MISMATCH " << modes[m].name << " vs serial: " << it.first << endl;
+                failures++;
+            }
+        }
+    }
+
+    if (m_update) {
+        if (!save(serial)) {
+            cerr << "ERROR: failed to write " << m_golden << endl;
+            return 1;
+        }
+        cout << serial.size() << " golden digests written to " << m_golden << endl;
+        return failures ? 1 : 0;
+    }
+
+    Digests golden;
+    if (!load(golden)) {
+        return 1;
+    }
+    for (const auto& it : serial) {
+        auto g = golden.find(it.first);
+        if (g == golden.end()) {
+            cout << "NEW      " << it.first << " " << it.second << endl;
+            failures++;
+        } else if (g->second != it.second) {
+            cout << "CHANGED  " << it.first << " " << g->second << " -> " << it.second << endl;
+            failures++;
+        }
+    }
+    for (const auto& it : golden) {
+        if (serial.find(it.first) == serial.end()) {
+            cout << "MISSING  " << it.first << endl;
+            failures++;
+        }
+    }
+    cout << serial.size() << " outputs x " << results.size() << " modes checked, "
+         << failures << " failure(s)" << endl;
+
+    return failures ? 1 : 0;
+}
+
+int main(int argc, char** argv)
+{
+    Golden golden;
+
+    if (!golden.parse(argc, argv)) {
+        cout << "Usage: golden --golden <digests.txt> [--update] <corpus_dir | file.wav>..." << endl;
+        return 1;
+    }
+
+    return golden.run();
+}
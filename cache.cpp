@@ -0,0 +1,366 @@
+/**
+ * @file        cache.cpp
+ * @version     1.0
+ * @brief       MP3enc_cpp persistent encode cache source
+ * @date        Oct 18, 2026
+ * @author      Siwon Kang (kkangshawn@gmail.com)
+ */
+
+#include "cache.h"
+#include "audio.h"
+#include "dedupe.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+#if defined __linux
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#elif defined _WIN32
+#include <direct.h>
+#endif
+using namespace std;
+
+static const char CACHE_MAGIC[8] = { 'M', 'P', '3', 'E', 'C', 'I', 'X', '2' };
+static const size_t CACHE_MIN_CAPACITY = 1024;
+static const unsigned long long CACHE_TOMBSTONE = ~0ULL;
+
+static double
+regular_size(const string& path)
+{
+    struct stat st;
+
+    if (stat(path.c_str(), &st) != 0 || (st.st_mode & S_IFMT) != S_IFREG) {
+        return -1;
+    }
+
+    return (double)st.st_size;
+}
+
+static size_t
+slot(const Cache::Key& k, size_t capacity)
+{
+    unsigned long long h = k.content.hash ^ (k.settings * 0x9e3779b97f4a7c15ULL);
+
+    h ^= h >> 31;
+
+    return (size_t)(h & (capacity - 1));
+}
+
+static bool
+same(const Cache::Key& a, const Cache::Key& b)
+{
+    return a.content.hash == b.content.hash && a.content.check == b.content.check &&
+        a.content.length == b.content.length && a.content.format == b.content.format &&
+        a.settings == b.settings;
+}
+
+bool
+Cache::open(const string& dir, size_t limit)
+{
+    string const settings = AudioData::settings_name() + " " + get_lame_version();
+    string const index = dir + "/index";
+    double size = 0;
+
+    m_dir = dir;
+    m_limit = limit;
+    m_settings = 0xcbf29ce484222325ULL;
+    for (unsigned char c : settings) {
+        m_settings = (m_settings ^ c) * 0x100000001b3ULL;
+    }
+#if defined __linux
+    mkdir(dir.c_str(), 0777);
+    m_fd = ::open(index.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+    if (m_fd < 0) {
+        cerr << "ERROR: could not open cache index " << index << endl;
+        return false;
+    }
+    if (flock(m_fd, LOCK_EX | LOCK_NB) != 0) {
+        cerr << "WARNING: cache " << dir << " is used by another run, encoding without it" << endl;
+        ::close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+    struct stat st;
+    if (fstat(m_fd, &st) == 0) {
+        size = (double)st.st_size;
+    }
+#elif defined _WIN32
+    _mkdir(dir.c_str());
+    ifstream in(index, ios::binary | ios::ate);
+    if (in.is_open()) {
+        size = (double)in.tellg();
+        in.seekg(0);
+    }
+#endif
+
+    if (size == 0) {
+        if (!map(CACHE_MIN_CAPACITY)) {
+            cerr << "ERROR: could not create cache index " << index << endl;
+            close();
+            return false;
+        }
+        memset(m_map, 0, m_mapped);
+        memcpy(header()->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        header()->capacity = CACHE_MIN_CAPACITY;
+        return true;
+    }
+    size_t const capacity = size < sizeof(Header) ? 0 : ((size_t)size - sizeof(Header)) / sizeof(Record);
+    bool const sized = capacity && !(capacity & (capacity - 1)) &&
+        sizeof(Header) + capacity * sizeof(Record) == (size_t)size;
+    if (!sized || !map(capacity)) {
+        cerr << "ERROR: " << index << " is not a cache index of this encoder" << endl;
+        close();
+        return false;
+    }
+#if defined _WIN32
+    in.read(m_map, m_mapped);
+#endif
+    if (memcmp(header()->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) || header()->capacity != capacity) {
+        cerr << "ERROR: " << index << " is not a cache index of this encoder" << endl;
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void
+Cache::close()
+{
+#if defined __linux
+    if (m_map) {
+        munmap(m_map, m_mapped);
+    }
+    if (m_fd >= 0) {
+        ::close(m_fd);
+    }
+#elif defined _WIN32
+    if (m_map) {
+        ofstream out(m_dir + "/index", ios::binary | ios::trunc);
+        out.write(m_map, m_mapped);
+    }
+    m_buffer.clear();
+#endif
+    m_fd = -1;
+    m_map = nullptr;
+    m_mapped = 0;
+}
+
+bool
+Cache::map(size_t capacity)
+{
+    size_t const len = sizeof(Header) + capacity * sizeof(Record);
+
+#if defined __linux
+    if (m_map) {
+        munmap(m_map, m_mapped);
+        m_map = nullptr;
+    }
+    if (ftruncate(m_fd, len) != 0) {
+        return false;
+    }
+    void* p = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (p == MAP_FAILED) {
+        return false;
+    }
+    m_map = (char*)p;
+#elif defined _WIN32
+    m_buffer.resize(len);
+    m_map = m_buffer.data();
+#endif
+    m_mapped = len;
+
+    return true;
+}
+
+bool
+Cache::rehash(size_t capacity)
+{
+    Header const h = *header();
+    vector<Record> live;
+
+    for (size_t i = 0; i < h.capacity; i++) {
+        if (records()[i].tick && records()[i].tick != CACHE_TOMBSTONE) {
+            live.push_back(records()[i]);
+        }
+    }
+    if (!map(capacity)) {
+        return false;
+    }
+    memset(m_map, 0, m_mapped);
+    *header() = h;
+    header()->capacity = capacity;
+    header()->used = 0;
+    header()->tombstones = 0;
+    for (const Record& r : live) {
+        *insert(r.key) = r;
+    }
+
+    return true;
+}
+
+Cache::Record*
+Cache::find(const Key& k)
+{
+    size_t const capacity = (size_t)header()->capacity;
+    Record* r = records();
+
+    for (size_t i = slot(k, capacity), n = 0; n < capacity; i = (i + 1) & (capacity - 1), n++) {
+        if (!r[i].tick) {
+            return nullptr;
+        }
+        if (r[i].tick != CACHE_TOMBSTONE && same(r[i].key, k)) {
+            return &r[i];
+        }
+    }
+
+    return nullptr;
+}
+
+Cache::Record*
+Cache::insert(const Key& k)
+{
+    /* keep probe chains short: at most half of the slots live or erased */
+    if ((header()->used + header()->tombstones + 1) * 2 > header()->capacity) {
+        size_t capacity = CACHE_MIN_CAPACITY;
+        while (capacity < (header()->used + 1) * 4) {
+            capacity <<= 1;
+        }
+        if (!rehash(capacity)) {
+            return nullptr;
+        }
+    }
+    size_t const capacity = (size_t)header()->capacity;
+    Record* r = records();
+    size_t i = slot(k, capacity);
+    while (r[i].tick && r[i].tick != CACHE_TOMBSTONE) {
+        i = (i + 1) & (capacity - 1);
+    }
+    if (r[i].tick == CACHE_TOMBSTONE) {
+        header()->tombstones--;
+    }
+    header()->used++;
+    r[i].key = k;
+    r[i].size = 0;
+    r[i].tick = ++header()->tick;
+
+    return &r[i];
+}
+
+void
+Cache::erase(Record* r)
+{
+    header()->bytes -= r->size;
+    header()->used--;
+    header()->tombstones++;
+    r->tick = CACHE_TOMBSTONE;
+}
+
+void
+Cache::evict(size_t need)
+{
+    while (header()->used && header()->bytes + need > m_limit) {
+        Record* oldest = nullptr;
+        for (size_t i = 0; i < header()->capacity; i++) {
+            Record* r = &records()[i];
+            if (r->tick && r->tick != CACHE_TOMBSTONE && (!oldest || r->tick < oldest->tick)) {
+                oldest = r;
+            }
+        }
+        remove(object(oldest->key).c_str());
+        erase(oldest);
+        m_evicted++;
+    }
+}
+
+string
+Cache::object(const Key& k) const
+{
+    char name[96];
+
+    snprintf(name, sizeof(name), "%016llx%016llx%016llx%016llx%016llx.mp3", k.content.hash, k.content.check,
+            k.content.length, k.content.format, k.settings);
+
+    return m_dir + "/" + name;
+}
+
+bool
+Cache::key(const string& in, Key& k)
+{
+    /* a pipe can be read only once */
+    if (regular_size(in) <= 0 || !Dedupe::digest(in, k.content)) {
+        return false;
+    }
+    k.settings = m_settings;
+
+    return true;
+}
+
+bool
+Cache::fetch(const Key& k, const string& output)
+{
+    Record* r = is_open() ? find(k) : nullptr;
+    Dedupe::MODE how;
+
+    if (r && Dedupe::place(object(k), output, Dedupe::DD_REFLINK, how)) {
+        r->tick = ++header()->tick;
+        m_hits++;
+        return true;
+    }
+    if (r) {
+        /* removed behind the index */
+        erase(r);
+    }
+    m_misses++;
+
+    return false;
+}
+
+void
+Cache::store(const Key& k, const string& output)
+{
+    double const size = regular_size(output);
+    Dedupe::MODE how;
+
+    if (!is_open() || size <= 0 || size > m_limit) {
+        return;
+    }
+    Record* r = find(k);
+    if (r) {
+        r->tick = ++header()->tick;
+        return;
+    }
+    evict((size_t)size);
+    if (!Dedupe::place(output, object(k), Dedupe::DD_REFLINK, how)) {
+        cerr << "WARNING: could not store " << output << " in cache " << m_dir << endl;
+        return;
+    }
+    r = insert(k);
+    if (!r) {
+        remove(object(k).c_str());
+        return;
+    }
+    r->size = (unsigned long long)size;
+    header()->bytes += r->size;
+    m_stored++;
+}
+
+string
+Cache::report()
+{
+    ostringstream msg;
+
+    msg << "Cache: " << m_hits << " hit(s), " << m_misses << " miss(es), " << m_stored << " stored, " <<
+        m_evicted << " evicted";
+    if (is_open()) {
+        msg << "; " << header()->used << " output(s), " << (header()->bytes >> 20) << " of " <<
+            (m_limit >> 20) << " MB";
+    }
+
+    return msg.str();
+}
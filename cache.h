@@ -0,0 +1,132 @@
+/**
+ * @file        cache.h
+ * @version     1.0
+ * @brief       MP3enc_cpp persistent encode cache header
+ * @date        Oct 18, 2026
+ * @author      Siwon Kang (kkangshawn@gmail.com)
+ */
+
+#ifndef _CACHE_H
+#define _CACHE_H
+
+#include "common.h"
+#include "dedupe.h"
+#include "utils.h"
+
+#include <string>
+#include <vector>
+
+/**
+ * @class   Cache cache.h "cache.h"
+ * @brief   Outputs of previous runs kept in a directory and found again by content, enabled by --cache.
+ *          An output is keyed by two independent hashes of its input's fmt and data chunks, the
+ *          length of the data and the format, and the hash of the encoder settings and LAME
+ *          version, so renamed or moved inputs still hit. As the input is not compared byte by
+ *          byte with what was encoded, a hit needs all of them to match.
+ *          The index is a file of fixed size records, an open addressing hash table mapped into
+ *          memory, so a lookup reads one or two records and never lists the directory.
+ *          Each record holds the tick of its last use; the least recently used outputs are
+ *          evicted to keep the cache within its size. One run uses a cache at a time.
+ */
+class Cache : public Utils, DEBUG {
+public:
+    /**
+     * @struct  Key
+     * @brief   What an output was encoded from.
+     */
+    struct Key {
+        Dedupe::Digest      content;    /**< audio content of the input */
+        unsigned long long  settings;   /**< hash of the encoder settings and version */
+    };
+
+    Cache() : m_dir{}, m_limit(0), m_settings(0), m_fd(-1), m_map(nullptr), m_mapped(0), m_buffer{},
+                m_hits(0), m_misses(0), m_stored(0), m_evicted(0) {}
+    virtual ~Cache() { close(); }
+
+    /**
+     * @fn      bool open(const std::string& dir, size_t limit)
+     * @brief   open the cache in dir, creating it if missing.
+     * @param [in]  limit   size of the outputs kept, in bytes
+     * @return  false if the cache could not be used
+     */
+    bool            open(const std::string& dir, size_t limit);
+    /**
+     * @fn      void close()
+     * @brief   write the index back and release the cache.
+     */
+    void            close();
+    bool            is_open() const { return m_map != nullptr; }
+    /**
+     * @fn      bool key(const std::string& in, Key& k)
+     * @brief   compute the key of the output of an input with the current settings.
+     * @return  false if the input is not a regular file or could not be read
+     */
+    bool            key(const std::string& in, Key& k);
+    /**
+     * @fn      bool fetch(const Key& k, const std::string& output)
+     * @brief   make the output from the cache.
+     * @return  true on a hit
+     */
+    bool            fetch(const Key& k, const std::string& output);
+    /**
+     * @fn      void store(const Key& k, const std::string& output)
+     * @brief   add an encoded output to the cache, evicting the least recently used outputs.
+     */
+    void            store(const Key& k, const std::string& output);
+    /**
+     * @fn      std::string report()
+     * @brief   summarize the hits and misses of the run and the content of the cache.
+     */
+    std::string     report();
+
+private:
+    /**
+     * @struct  Header
+     * @brief   Start of the index file.
+     */
+    struct Header {
+        char                magic[8];
+        unsigned long long  capacity;   /**< records, a power of 2 */
+        unsigned long long  used;       /**< live records */
+        unsigned long long  tombstones; /**< erased records still on probe chains */
+        unsigned long long  bytes;      /**< size of the outputs kept */
+        unsigned long long  tick;       /**< last use given out */
+        unsigned long long  reserved[2];
+    };
+    /**
+     * @struct  Record
+     * @brief   An output kept, or an empty slot if tick is 0.
+     */
+    struct Record {
+        Key                 key;
+        unsigned long long  size;       /**< size of the output in bytes */
+        unsigned long long  tick;       /**< last use, 0 if empty, CACHE_TOMBSTONE if erased */
+    };
+
+    Cache(const Cache&);
+    Cache& operator=(const Cache&);
+
+    Header*         header() const { return (Header*)m_map; }
+    Record*         records() const { return (Record*)(m_map + sizeof(Header)); }
+    bool            map(size_t capacity);
+    bool            rehash(size_t capacity);
+    Record*         find(const Key& k);
+    Record*         insert(const Key& k);
+    void            erase(Record* r);
+    void            evict(size_t need);
+    std::string     object(const Key& k) const;
+
+    std::string         m_dir;      /**< cache directory */
+    size_t              m_limit;    /**< size of the outputs kept, in bytes */
+    unsigned long long  m_settings; /**< hash of the current settings */
+    int                 m_fd;       /**< index file, locked while the cache is open */
+    char*               m_map;      /**< index in memory */
+    size_t              m_mapped;   /**< length of the index */
+    std::vector<char>   m_buffer;   /**< index where it is not mapped */
+    size_t              m_hits;     /**< outputs made from the cache */
+    size_t              m_misses;   /**< outputs not found */
+    size_t              m_stored;   /**< outputs added */
+    size_t              m_evicted;  /**< outputs evicted */
+};
+
+#endif  /* _CACHE_H */
@@ -0,0 +1,52 @@
+/**
+ * @file        cancel.cpp
+ * @version     1.0
+ * @brief       MP3enc_cpp cooperative cancellation source
+ * @date        Oct 18, 2026
+ * @author      Siwon Kang (kkangshawn@gmail.com)
+ */
+
+#include "cancel.h"
+
+#include <cstring>
+
+volatile sig_atomic_t Cancel::state = Cancel::CS_NONE;
+volatile sig_atomic_t Cancel::signo = 0;
+double Cancel::deadline_sec = 10.0;
+
+void
+Cancel::install()
+{
+#if defined __linux
+    struct sigaction sa;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = handler;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+#else
+    std::signal(SIGINT, handler);
+    std::signal(SIGTERM, handler);
+#endif
+}
+
+void
+Cancel::request(int sig)
+{
+    if (!signo) {
+        signo = sig;
+    }
+    state = (state == CS_NONE) ? CS_REQUESTED : CS_ABORTED;
+}
+
+void
+Cancel::handler(int sig)
+{
+#if !defined __linux
+    /* signal() resets the disposition on Windows */
+    std::signal(sig, handler);
+#endif
+    request(sig);
+}
@@ -0,0 +1,56 @@
+/**
+ * @file        cancel.h
+ * @version     1.0
+ * @brief       MP3enc_cpp cooperative cancellation header
+ * @date        Oct 18, 2026
+ * @author      Siwon Kang (kkangshawn@gmail.com)
+ */
+
+#ifndef _CANCEL_H
+#define _CANCEL_H
+
+#include <csignal>
+
+/**
+ * @class   Cancel cancel.h "cancel.h"
+ * @brief   Process wide cancellation state set from SIGINT/SIGTERM.
+ *          The first signal requests cancellation: queued jobs are dropped and running
+ *          jobs may finish until the deadline. A second signal, or the deadline passing,
+ *          aborts the running jobs, which then remove their outputs.
+ *          Only flags are touched in the signal handler; workers poll them.
+ */
+class Cancel {
+public:
+    /**
+     * @fn      static void install()
+     * @brief   install the handler for SIGINT and SIGTERM.
+     */
+    static void     install();
+    /**
+     * @fn      static void request(int sig)
+     * @brief   request cancellation as if sig was received. Called from the signal handler.
+     */
+    static void     request(int sig);
+    /**
+     * @fn      static void abort()
+     * @brief   abort the running jobs.
+     */
+    static void     abort() { state = CS_ABORTED; }
+    static bool     requested() { return state != CS_NONE; }    /**< no new job shall start */
+    static bool     aborted() { return state == CS_ABORTED; }   /**< running jobs shall stop */
+    static int      signal() { return signo; }                  /**< signal received, 0 if none */
+
+    static void     set_deadline(double seconds) { deadline_sec = seconds; }
+    static double   deadline() { return deadline_sec; }         /**< seconds running jobs may take */
+
+private:
+    enum STATE { CS_NONE, CS_REQUESTED, CS_ABORTED };
+
+    static void     handler(int sig);
+
+    static volatile sig_atomic_t    state;
+    static volatile sig_atomic_t    signo;
+    static double                   deadline_sec;
+};
+
+#endif  /* _CANCEL_H */
@@ -0,0 +1,426 @@
+/**
+ * @file        daemon.cpp
+ * @version     1.0
+ * @brief       MP3enc_cpp encode daemon source
+ * @date        Oct 18, 2026
+ * @author      Siwon Kang (kkangshawn@gmail.com)
+ */
+
+#include "daemon.h"
+#include "cancel.h"
+#include "pool.h"
+
+#include <climits>
+#include <cstring>
+#include <cstdlib>
+#include <sstream>
+#if defined __linux
+#include <arpa/inet.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+/* largest message accepted, a command line with two paths */
+static const size_t DAEMON_MAX_FRAME = 1 << 20;
+
+static vector<string>
+split(const string& line)
+{
+    vector<string> fields;
+    size_t pos = 0;
+
+    for (;;) {
+        size_t const tab = line.find('\t', pos);
+        fields.push_back(line.substr(pos, tab == string::npos ? string::npos : tab - pos));
+        if (tab == string::npos) {
+            return fields;
+        }
+        pos = tab + 1;
+    }
+}
+
+#if defined __linux
+static bool
+address(const string& path, struct sockaddr_un& addr)
+{
+    if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+        cerr << "ERROR: invalid socket path " << path << endl;
+        return false;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path.c_str(), path.size());
+
+    return true;
+}
+#endif
+
+Daemon::~Daemon()
+{
+#if defined __linux
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        unlink(m_path.c_str());
+    }
+#endif
+    for (map<size_t, Request*>::iterator it = m_requests.begin(); it != m_requests.end(); ++it) {
+        delete it->second;
+    }
+}
+
+bool
+Daemon::listen(const string& path)
+{
+#if defined __linux
+    struct sockaddr_un addr;
+
+    if (!address(path, addr)) {
+        return false;
+    }
+    int const probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    bool const served = probe >= 0 && connect(probe, (struct sockaddr*)&addr, sizeof(addr)) == 0;
+    if (probe >= 0) {
+        ::close(probe);
+    }
+    if (served) {
+        cerr << "ERROR: " << path << " is served by another daemon" << endl;
+        return false;
+    }
+    unlink(path.c_str());
+    m_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (m_fd < 0 || bind(m_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || ::listen(m_fd, 64) != 0) {
+        cerr << "ERROR: could not listen on " << path << endl;
+        if (m_fd >= 0) {
+            ::close(m_fd);
+            m_fd = -1;
+        }
+        return false;
+    }
+    m_path = path;
+
+    return true;
+#else
+    cerr << "ERROR: --daemon is not supported on this system, " << path << " not served" << endl;
+    return false;
+#endif
+}
+
+void
+Daemon::serve(WorkerPool& pool, vector<Job*>& v)
+{
+    m_pool = &pool;
+#if defined __linux
+    cout << "Serving requests on " << m_path << endl;
+    while (m_fd >= 0 && !Cancel::requested()) {
+        struct pollfd pfd = { m_fd, POLLIN, 0 };
+        if (poll(&pfd, 1, 500) > 0) {
+            int const fd = accept4(m_fd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (fd >= 0) {
+                Connection* c = new Connection(this, fd);
+                Lock l(m_lock);
+                m_connections.push_back(c);
+                c->start();
+            }
+        }
+        reap();
+    }
+    {
+        Lock l(m_lock);
+        for (Connection* c : m_connections) {
+            shutdown(c->fd, SHUT_RDWR);
+        }
+    }
+    for (Connection* c : m_connections) {
+        c->join();
+        ::close(c->fd);
+        delete c;
+    }
+    m_connections.clear();
+    cout << "Served " << m_next << " request(s), " << m_jobs << " job(s)" << endl;
+#endif
+    for (map<size_t, Request*>::iterator it = m_requests.begin(); it != m_requests.end(); ++it) {
+        v.insert(v.end(), it->second->jobs.begin(), it->second->jobs.end());
+        delete it->second;
+    }
+    m_requests.clear();
+}
+
+void
+Daemon::reap()
+{
+    vector<Connection*> gone;
+    vector<Job*> finished;
+
+    {
+        Lock l(m_lock);
+        for (vector<Connection*>::iterator it = m_connections.begin(); it != m_connections.end();) {
+            if ((*it)->finished) {
+                gone.push_back(*it);
+                it = m_connections.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        for (map<size_t, Request*>::iterator it = m_requests.begin(); it != m_requests.end();) {
+            Request* r = it->second;
+            vector<size_t> const count = r->closed && !r->users ? m_pool->states(r->jobs) : vector<size_t>();
+            if (count.empty() || count[Job::JS_QUEUED] || count[Job::JS_RUNNING]) {
+                ++it;
+                continue;
+            }
+            finished.insert(finished.end(), r->jobs.begin(), r->jobs.end());
+            delete r;
+            it = m_requests.erase(it);
+        }
+    }
+    for (Connection* c : gone) {
+        c->join();
+#if defined __linux
+        ::close(c->fd);
+#endif
+        delete c;
+    }
+    for (Job* j : finished) {
+        delete j;
+    }
+}
+
+void
+Daemon::handle(Connection& c)
+{
+    vector<size_t> mine;
+    string msg;
+
+    while (recv_frame(c.fd, msg)) {
+        if (!send_frame(c.fd, execute(msg, mine))) {
+            break;
+        }
+    }
+
+    Lock l(m_lock);
+    for (size_t id : mine) {
+        map<size_t, Request*>::iterator it = m_requests.find(id);
+        if (it != m_requests.end()) {
+            it->second->closed = true;
+        }
+    }
+    c.finished = true;
+}
+
+string
+Daemon::execute(const string& command, vector<size_t>& mine)
+{
+    vector<string> const f = split(command);
+    ostringstream reply;
+
+    if (f[0] == "SUBMIT" && (f.size() == 3 || f.size() == 5)) {
+        int priority = Job::JP_NORMAL;
+        double const deadline = f.size() == 5 ? atof(f[4].c_str()) : 0;
+        if (f.size() == 5) {
+            for (priority = Job::JP_INTERACTIVE; priority < Job::JP_COUNT; priority++) {
+                if (f[3] == Job::priority_name(priority)) {
+                    break;
+                }
+            }
+        }
+        if (priority == Job::JP_COUNT || deadline < 0) {
+            return "ERR\tunknown class or bad deadline";
+        }
+        Request* r = new Request();
+        r->closed = false;
+        r->users = 0;
+        {
+            Lock s(m_submit_lock);
+            m_submit(f[1], f[2], (Job::PRIORITY)priority, deadline, r->jobs);
+        }
+        Lock l(m_lock);
+        size_t const id = m_next++;
+        m_requests[id] = r;
+        m_jobs += r->jobs.size();
+        mine.push_back(id);
+        reply << "OK\t" << id << '\t' << r->jobs.size();
+    } else if ((f[0] == "STATUS" || f[0] == "WAIT" || f[0] == "CANCEL") && f.size() == 2) {
+        Request* r = acquire(strtoul(f[1].c_str(), nullptr, 10));
+        if (!r) {
+            return "ERR\tunknown request " + f[1];
+        }
+        while (f[0] == "WAIT" && !m_pool->wait(r->jobs, 0.5)) {
+            if (Cancel::requested()) {
+                release(r);
+                return "ERR\tshutting down";
+            }
+        }
+        if (f[0] == "CANCEL") {
+            reply << "OK\t" << m_pool->cancel(r->jobs);
+        } else {
+            reply << status(r);
+        }
+        release(r);
+    } else if (f[0] == "STATS" && f.size() == 1) {
+        Lock l(m_lock);
+        reply << "OK\t" << m_requests.size() << '\t' << m_jobs << '\t' << m_pool->dispatch_report() << '\t' <<
+            m_pool->priority_report();
+    } else {
+        reply << "ERR\tunknown command " << f[0];
+    }
+
+    return reply.str();
+}
+
+Daemon::Request*
+Daemon::acquire(size_t id)
+{
+    Lock l(m_lock);
+    map<size_t, Request*>::iterator it = m_requests.find(id);
+
+    if (it == m_requests.end()) {
+        return nullptr;
+    }
+    it->second->users++;
+
+    return it->second;
+}
+
+void
+Daemon::release(Request* r)
+{
+    Lock l(m_lock);
+
+    r->users--;
+}
+
+string
+Daemon::status(const Request* r)
+{
+    vector<size_t> const count = m_pool->states(r->jobs);
+    ostringstream msg;
+
+    msg << "OK\t" << count[Job::JS_QUEUED] << '\t' << count[Job::JS_RUNNING] << '\t' << count[Job::JS_DONE] <<
+        '\t' << count[Job::JS_FAILED] << '\t' << count[Job::JS_CANCELED];
+
+    return msg.str();
+}
+
+bool
+Daemon::send_frame(int fd, const string& msg)
+{
+#if defined __linux
+    uint32_t const len = htonl((uint32_t)msg.size());
+    string const frame = string((const char*)&len, sizeof(len)) + msg;
+    size_t sent = 0;
+
+    while (sent < frame.size()) {
+        ssize_t const n = send(fd, frame.data() + sent, frame.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return false;
+        }
+        sent += n;
+    }
+
+    return true;
+#else
+    (void)fd;
+    (void)msg;
+    return false;
+#endif
+}
+
+bool
+Daemon::recv_frame(int fd, string& msg)
+{
+#if defined __linux
+    uint32_t len;
+    size_t got = 0;
+
+    while (got < sizeof(len)) {
+        ssize_t const n = recv(fd, (char*)&len + got, sizeof(len) - got, 0);
+        if (n <= 0) {
+            return false;
+        }
+        got += n;
+    }
+    len = ntohl(len);
+    if (len > DAEMON_MAX_FRAME) {
+        return false;
+    }
+    msg.resize(len);
+    got = 0;
+    while (got < len) {
+        ssize_t const n = recv(fd, &msg[got], len - got, 0);
+        if (n <= 0) {
+            return false;
+        }
+        got += n;
+    }
+
+    return true;
+#else
+    (void)fd;
+    (void)msg;
+    return false;
+#endif
+}
+
+bool
+Daemon::client(const string& path, const string& in, const string& out, Job::PRIORITY priority, double deadline)
+{
+#if defined __linux
+    struct sockaddr_un addr;
+    char cwd[PATH_MAX];
+    string reply;
+
+    if (!address(path, addr)) {
+        return false;
+    }
+    int const fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        cerr << "ERROR: could not connect to a daemon on " << path << endl;
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        return false;
+    }
+    /* the daemon resolves paths against its own working directory */
+    string const base = getcwd(cwd, sizeof(cwd)) ? string(cwd) + "/" : string();
+    string const input = in.empty() || in[0] == '/' ? in : base + in;
+    string const output = out.empty() || out[0] == '/' ? out : base + out;
+
+    ostringstream submit;
+    submit << "SUBMIT\t" << input << '\t' << output << '\t' << Job::priority_name(priority) << '\t' << deadline;
+
+    vector<string> f;
+    if (send_frame(fd, submit.str()) && recv_frame(fd, reply)) {
+        f = split(reply);
+    }
+    if (f.size() != 3 || f[0] != "OK") {
+        cerr << "ERROR: " << input << " not submitted: " << (f.size() > 1 ? f[1] : "no reply") << endl;
+        ::close(fd);
+        return false;
+    }
+    cout << "Request " << f[1] << ": " << f[2] << " job(s) submitted to " << path << endl;
+
+    string const id = f[1];
+    f.clear();
+    if (send_frame(fd, "WAIT\t" + id) && recv_frame(fd, reply)) {
+        f = split(reply);
+    }
+    ::close(fd);
+    if (f.size() != 6 || f[0] != "OK") {
+        cerr << "ERROR: request " << id << " not finished: " << (f.size() > 1 ? f[1] : "no reply") << endl;
+        return false;
+    }
+    cout << "Request " << id << ": " << f[3] << " done, " << f[4] << " failed, " << f[5] << " canceled" << endl;
+
+    return f[4] == "0" && f[5] == "0";
+#else
+    (void)in;
+    (void)out;
+    (void)priority;
+    (void)deadline;
+    cerr << "ERROR: --submit is not supported on this system, " << path << " not used" << endl;
+    return false;
+#endif
+}
@@ -0,0 +1,125 @@
+/**
+ * @file        daemon.h
+ * @version     1.0
+ * @brief       MP3enc_cpp encode daemon header
+ * @date        Oct 18, 2026
+ * @author      Siwon Kang (kkangshawn@gmail.com)
+ */
+
+#ifndef _DAEMON_H
+#define _DAEMON_H
+
+#include "common.h"
+#include "utils.h"
+#include "thread.h"
+#include "job.h"
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+class WorkerPool;
+
+/**
+ * @class   Daemon daemon.h "daemon.h"
+ * @brief   Serves encode requests on a Unix domain socket with --daemon, keeping the worker threads
+ *          running between requests. Each worker keeps its encoder context, with the capacity of its
+ *          PCM and output buffers, from one job to the next (see WorkerPool::set_warm()).
+ *          Every message is a 4-byte length in network byte order followed by a tab separated line:
+ *              SUBMIT <in> <out> [<class> <deadline>]
+ *                                  -> OK <request> <jobs>      encode a file or directory, in a
+ *                                                              priority class and within a deadline
+ *                                                              in seconds, 0 for none
+ *              STATUS <request>    -> OK <queued> <running> <done> <failed> <canceled>
+ *              WAIT <request>      -> OK ...                   as STATUS once all jobs finished
+ *              CANCEL <request>    -> OK <withdrawn>           withdraw jobs not started yet
+ *              STATS               -> OK <requests> <jobs> <dispatch report> <priority report>
+ *          or ERR <message>. A connection is served by a thread of its own, so WAIT blocks only
+ *          its client. A request is forgotten once it finished and its client disconnected.
+ *          Linux only.
+ */
+class Daemon : public Utils, DEBUG {
+public:
+    /**
+     * @brief   Enumerates the jobs of an input path and submits them to the pool.
+     */
+    typedef std::function<void(const std::string& in, const std::string& out, Job::PRIORITY priority,
+        double deadline, std::vector<Job*>& v)> Submit;
+
+    explicit Daemon(Submit submit) : m_submit(submit), m_pool(nullptr), m_path{}, m_fd(-1), m_connections{},
+                m_requests{}, m_next(0), m_jobs(0) {}
+    virtual ~Daemon();
+
+    /**
+     * @fn      bool listen(const std::string& path)
+     * @brief   create the socket. A socket left by a daemon that is gone is replaced.
+     * @return  false if another daemon serves it or it cannot be created
+     */
+    bool            listen(const std::string& path);
+    /**
+     * @fn      void serve(WorkerPool& pool, std::vector<Job*>& v)
+     * @brief   serve clients until SIGINT or SIGTERM.
+     * @param [out] v   jobs of the requests not forgotten yet, owned by the caller from then on
+     */
+    void            serve(WorkerPool& pool, std::vector<Job*>& v);
+    /**
+     * @fn      static bool client(const std::string& path, const std::string& in, const std::string& out,
+     *                  Job::PRIORITY priority, double deadline)
+     * @brief   submit an input path to a daemon and wait for it, as --submit does.
+     * @return  true if every job of the request is done
+     */
+    static bool     client(const std::string& path, const std::string& in, const std::string& out,
+                        Job::PRIORITY priority, double deadline);
+
+private:
+    /**
+     * @struct  Request
+     * @brief   The jobs of one SUBMIT.
+     */
+    struct Request {
+        std::vector<Job*>   jobs;
+        bool                closed;     /**< its client disconnected */
+        size_t              users;      /**< commands using it right now */
+    };
+    /**
+     * @class   Connection
+     * @brief   Thread serving one client.
+     */
+    class Connection : public Thread {
+    public:
+        Connection(Daemon* daemon, int fd) : fd(fd), finished(false), m_daemon(daemon) {}
+
+        int         fd;         /**< socket of the client */
+        bool        finished;   /**< the client is gone, protected by m_lock of the daemon */
+    private:
+        void    run() { m_daemon->handle(*this); }
+
+        Daemon*     m_daemon;
+    };
+
+    Daemon(const Daemon&);
+    Daemon& operator=(const Daemon&);
+
+    void            handle(Connection& c);
+    std::string     execute(const std::string& command, std::vector<size_t>& mine);
+    Request*        acquire(size_t id);
+    void            release(Request* r);
+    std::string     status(const Request* r);
+    void            reap();
+    static bool     send_frame(int fd, const std::string& msg);
+    static bool     recv_frame(int fd, std::string& msg);
+
+    Submit                          m_submit;   /**< enumerates the jobs of a SUBMIT */
+    WorkerPool*                     m_pool;     /**< pool the jobs run in, set by serve() */
+    std::string                     m_path;     /**< socket path */
+    int                             m_fd;       /**< listening socket, -1 if none */
+    std::vector<Connection*>        m_connections;  /**< clients being served */
+    std::map<size_t, Request*>      m_requests; /**< requests by number */
+    size_t                          m_next;     /**< number of the next request */
+    size_t                          m_jobs;     /**< jobs submitted */
+    Mutex                           m_lock;     /**< protects the members above */
+    Mutex                           m_submit_lock;  /**< serializes m_submit */
+};
+
+#endif  /* _DAEMON_H */
@@ -0,0 +1,303 @@
+/**
+ * @file        dedupe.cpp
+ * @version     1.0
+ * @brief       MP3enc_cpp duplicate input detection source
+ * @date        Oct 18, 2026
+ * @author      Siwon Kang (kkangshawn@gmail.com)
+ */
+
+#include "dedupe.h"
+#include "audio.h"
+#include "writer.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#if defined __linux
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#elif defined _WIN32
+#include <Windows.h>
+#include <process.h>
+#define getpid _getpid
+#endif
+using namespace std;
+
+/* bytes read at once while hashing and comparing */
+static const size_t DEDUPE_BLOCK = 1 << 16;
+
+static unsigned int
+le32(const unsigned char* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+Dedupe::Ranges
+Dedupe::content(const string& path)
+{
+    ifstream in(path, ios::binary | ios::ate);
+    double const size = in.is_open() ? (double)in.tellg() : 0;
+    unsigned char h[12];
+    Ranges r;
+
+    in.seekg(0);
+    if (!in.read((char*)h, sizeof(h)) || memcmp(h, "RIFF", 4) || memcmp(h + 8, "WAVE", 4)) {
+        r.push_back(make_pair((size_t)0, (size_t)max(size, 0.0)));
+        return r;
+    }
+    /* the encoded audio depends on the format and the samples only, not on other chunks */
+    size_t offset = sizeof(h);
+    bool data = false;
+    while (!data && in.read((char*)h, 8)) {
+        size_t const len = le32(h + 4);
+        offset += 8;
+        if (!memcmp(h, "fmt ", 4) || !memcmp(h, "data", 4)) {
+            data = !memcmp(h, "data", 4);
+            r.push_back(make_pair(offset, (size_t)min((double)len, size - offset)));
+        }
+        offset += len + (len & 1);
+        in.seekg(offset);
+    }
+    if (!data) {
+        r.clear();
+        r.push_back(make_pair((size_t)0, (size_t)max(size, 0.0)));
+    }
+
+    return r;
+}
+
+bool
+Dedupe::digest(const string& path, Digest& d)
+{
+    ifstream in(path, ios::binary);
+    vector<unsigned char> buf(DEDUPE_BLOCK);
+    Ranges const ranges = content(path);
+
+    if (!in.is_open()) {
+        return false;
+    }
+    /* 64-bit multiply and xorshift over words, enough to tell inputs apart before comparing */
+    d.hash = 0xcbf29ce484222325ULL;
+    /* a second multiplier and shift, so that a collision of both is out of reach */
+    d.check = 0x84222325cbf29ce4ULL;
+    d.length = ranges.back().second;
+    d.format = 0;
+    for (size_t k = 0; k < ranges.size(); k++) {
+        size_t left = ranges[k].second;
+        d.hash = (d.hash ^ left) * 0x9e3779b97f4a7c15ULL;
+        d.check = (d.check ^ left) * 0xff51afd7ed558ccdULL;
+        in.seekg(ranges[k].first);
+        while (left > 0) {
+            size_t const n = min(left, buf.size());
+            if (!in.read((char*)buf.data(), n)) {
+                return false;
+            }
+            if (k == 0 && ranges.size() > 1 && left == ranges[k].second) {
+                memcpy(&d.format, buf.data(), min(n, sizeof(d.format)));
+            }
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                unsigned long long w;
+                memcpy(&w, &buf[i], 8);
+                d.hash = (d.hash ^ w) * 0x9e3779b97f4a7c15ULL;
+                d.hash ^= d.hash >> 29;
+                d.check = (d.check ^ w) * 0xff51afd7ed558ccdULL;
+                d.check ^= d.check >> 33;
+            }
+            for (; i < n; i++) {
+                d.hash = (d.hash ^ buf[i]) * 0x100000001b3ULL;
+                d.check = (d.check ^ buf[i]) * 0xc4ceb9fe1a85ec53ULL;
+            }
+            left -= n;
+        }
+    }
+
+    return true;
+}
+
+bool
+Dedupe::hash(const string& path, unsigned long long& h)
+{
+    Digest d;
+
+    if (!digest(path, d)) {
+        return false;
+    }
+    h = d.hash;
+
+    return true;
+}
+
+bool
+Dedupe::same(const string& a, const string& b)
+{
+    ifstream ia(a, ios::binary);
+    ifstream ib(b, ios::binary);
+    Ranges const ra = content(a);
+    Ranges const rb = content(b);
+    vector<char> ba(DEDUPE_BLOCK);
+    vector<char> bb(DEDUPE_BLOCK);
+
+    if (!ia.is_open() || !ib.is_open() || ra.size() != rb.size()) {
+        return false;
+    }
+    for (size_t k = 0; k < ra.size(); k++) {
+        size_t left = ra[k].second;
+        if (left != rb[k].second) {
+            return false;
+        }
+        ia.seekg(ra[k].first);
+        ib.seekg(rb[k].first);
+        while (left > 0) {
+            size_t const n = min(left, ba.size());
+            if (!ia.read(ba.data(), n) || !ib.read(bb.data(), n) || memcmp(ba.data(), bb.data(), n)) {
+                return false;
+            }
+            left -= n;
+        }
+    }
+
+    return true;
+}
+
+bool
+Dedupe::add(const string& in, const string& out)
+{
+    double const size = get_file_size(in.c_str());
+    Input cur = { in, AudioData::output_name(in, out), 0, false };
+
+    /* pipes have no size and can be read only once */
+    if (size <= 0) {
+        return false;
+    }
+    vector<Input>& bucket = m_sizes[size];
+    if (bucket.empty()) {
+        bucket.push_back(cur);
+        return false;
+    }
+    cur.hashed = hash(in, cur.hash);
+    m_hashed += cur.hashed;
+    for (Input& i : bucket) {
+        if (!cur.hashed) {
+            break;
+        }
+        if (!i.hashed) {
+            i.hashed = hash(i.path, i.hash);
+            m_hashed += i.hashed;
+        }
+        if (i.hashed && i.hash == cur.hash && i.output != cur.output && same(i.path, in)) {
+            DEBUG::INFO((in + " duplicates " + i.path).c_str());
+            m_duplicates.push_back(make_pair(i.output, cur.output));
+            return true;
+        }
+    }
+    bucket.push_back(cur);
+
+    return false;
+}
+
+bool
+Dedupe::place(const string& from, const string& to, MODE mode, MODE& made)
+{
+    ostringstream tmp;
+    size_t const slash = to.find_last_of("/\\");
+
+    /* hidden name in the same directory so that rename() stays atomic, as OutputWriter does */
+    tmp << (slash == string::npos ? "" : to.substr(0, slash + 1)) << "." <<
+        (slash == string::npos ? to : to.substr(slash + 1)) << "." << getpid() << ".dedupe.tmp";
+    string const t = tmp.str();
+
+    if (mode == DD_LINK) {
+#if defined __linux
+        bool const linked = link(from.c_str(), t.c_str()) == 0;
+#elif defined _WIN32
+        bool const linked = CreateHardLinkA(t.c_str(), from.c_str(), NULL) != 0;
+        remove(to.c_str());
+#endif
+        if (linked && rename(t.c_str(), to.c_str()) == 0) {
+            made = DD_LINK;
+            return true;
+        }
+        remove(t.c_str());
+    }
+#if defined __linux
+    if (mode == DD_REFLINK) {
+        int const src = open(from.c_str(), O_RDONLY | O_CLOEXEC);
+        int const dst = src < 0 ? -1 : open(t.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+        bool const cloned = dst >= 0 && ioctl(dst, FICLONE, src) == 0;
+        if (dst >= 0) {
+            close(dst);
+        }
+        if (src >= 0) {
+            close(src);
+        }
+        if (cloned && rename(t.c_str(), to.c_str()) == 0) {
+            made = DD_REFLINK;
+            return true;
+        }
+        remove(t.c_str());
+    }
+#endif
+
+    /* another file system, or no link support: copy under the sync policy of the outputs */
+    ifstream in(from, ios::binary | ios::ate);
+    OutputWriter w;
+    vector<char> buf(DEDUPE_BLOCK);
+    if (!in.is_open() || !w.open(to)) {
+        return false;
+    }
+    w.reserve((size_t)in.tellg());
+    in.seekg(0);
+    while (in) {
+        in.read(buf.data(), buf.size());
+        if (in.gcount() > 0 && !w.write(buf.data(), (size_t)in.gcount())) {
+            return false;
+        }
+    }
+    if (in.bad() || !w.commit()) {
+        return false;
+    }
+    made = DD_COPY;
+
+    return true;
+}
+
+vector<string>
+Dedupe::produce(const unordered_map<string, bool>& done)
+{
+    vector<string> made;
+    MODE how;
+
+    for (const pair<string, string>& d : m_duplicates) {
+        unordered_map<string, bool>::const_iterator it = done.find(d.first);
+        if (it == done.end() || !it->second) {
+            cerr << "ERROR: " << d.second << " not made, encoding its duplicate " << d.first << " failed" << endl;
+            m_failed++;
+        } else if (!place(d.first, d.second, m_mode, how)) {
+            cerr << "ERROR: failed to make " << d.second << " from " << d.first << endl;
+            m_failed++;
+        } else {
+            m_linked += how == DD_LINK;
+            m_reflinked += how == DD_REFLINK;
+            m_copied += how == DD_COPY;
+            cout << "Duplicate " << d.second << " made from " << d.first << endl;
+            made.push_back(d.second);
+        }
+    }
+
+    return made;
+}
+
+string
+Dedupe::report()
+{
+    ostringstream msg;
+
+    msg << "Dedupe: " << m_duplicates.size() << " duplicate input(s), " << m_hashed << " input(s) hashed; " <<
+        m_linked << " linked, " << m_reflinked << " reflinked, " << m_copied << " copied, " << m_failed << " failed";
+
+    return msg.str();
+}
@@ -0,0 +1,119 @@
+/**
+ * @file        dedupe.h
+ * @version     1.0
+ * @brief       MP3enc_cpp duplicate input detection header
+ * @date        Oct 18, 2026
+ * @author      Siwon Kang (kkangshawn@gmail.com)
+ */
+
+#ifndef _DEDUPE_H
+#define _DEDUPE_H
+
+#include "common.h"
+#include "utils.h"
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @class   Dedupe dedupe.h "dedupe.h"
+ * @brief   Encodes each distinct audio content of a batch once.
+ *          Inputs are bucketed by file size during the walk, so only inputs sharing their
+ *          size with another are read. Those are hashed over their fmt and data chunks, and
+ *          an input whose hash matches an earlier one is compared byte by byte before it is
+ *          taken as a duplicate. The output of a duplicate is made from the output of the
+ *          first input once the batch is encoded, by hardlink, reflink or copy.
+ */
+class Dedupe : public Utils, DEBUG {
+public:
+    /**
+     * @brief   How the output of a duplicate is made. LINK and REFLINK fall back to COPY
+     *          where the file system does not support them. NONE encodes every input.
+     */
+    enum MODE { DD_NONE, DD_LINK, DD_REFLINK, DD_COPY };
+
+    explicit Dedupe(MODE mode) : m_mode(mode), m_sizes{}, m_duplicates{}, m_hashed(0), m_linked(0),
+                m_reflinked(0), m_copied(0), m_failed(0) {}
+
+    /**
+     * @fn      bool add(const std::string& in, const std::string& out)
+     * @brief   register an input of the batch with its output path.
+     * @return  true if it duplicates an earlier input and shall not be encoded
+     */
+    bool            add(const std::string& in, const std::string& out);
+    /**
+     * @fn      std::vector<std::string> produce(const std::unordered_map<std::string, bool>& done)
+     * @brief   make the outputs of the duplicates whose first input was encoded successfully.
+     *          Shall be called once the outputs of the jobs are in place.
+     * @param [in]  done    outputs of the batch, true if encoded successfully
+     * @return  outputs made
+     */
+    std::vector<std::string> produce(const std::unordered_map<std::string, bool>& done);
+    /**
+     * @fn      std::string report()
+     * @brief   summarize the duplicates found and how their outputs were made.
+     */
+    std::string     report();
+
+    /**
+     * @struct  Digest
+     * @brief   What tells the audio content of an input apart without the input at hand.
+     */
+    struct Digest {
+        unsigned long long  hash;       /**< content hash, as hash() */
+        unsigned long long  check;      /**< content hash independent of hash */
+        unsigned long long  length;     /**< bytes of the data chunk, of the whole file if not wav */
+        unsigned long long  format;     /**< format tag, channels and sample rate of the fmt chunk */
+    };
+
+    /**
+     * @fn      static bool digest(const std::string& path, Digest& d)
+     * @brief   hash the audio content of an input twice, independently, and note its length
+     *          and format, enough to find its output again in a later run.
+     * @return  false if the file could not be read
+     */
+    static bool     digest(const std::string& path, Digest& d);
+    /**
+     * @fn      static bool hash(const std::string& path, unsigned long long& h)
+     * @brief   hash the audio content of an input: the fmt and data chunks of a wav file,
+     *          the whole file otherwise.
+     * @return  false if the file could not be read
+     */
+    static bool     hash(const std::string& path, unsigned long long& h);
+    /**
+     * @fn      static bool place(const std::string& from, const std::string& to, MODE mode, MODE& made)
+     * @brief   replace a file atomically with a hardlink, a reflink or a copy of another,
+     *          falling back to a copy.
+     * @param [out] made    how the file was made
+     */
+    static bool     place(const std::string& from, const std::string& to, MODE mode, MODE& made);
+
+private:
+    /**
+     * @struct  Input
+     * @brief   An input encoded by the batch.
+     */
+    struct Input {
+        std::string         path;
+        std::string         output;
+        unsigned long long  hash;       /**< content hash, valid if hashed */
+        bool                hashed;
+    };
+    typedef std::vector<std::pair<size_t, size_t> > Ranges;    /**< offsets and lengths of content */
+
+    static Ranges   content(const std::string& path);
+    static bool     same(const std::string& a, const std::string& b);
+
+    MODE            m_mode;         /**< how outputs of duplicates are made */
+    std::unordered_map<double, std::vector<Input> > m_sizes;   /**< distinct inputs by file size */
+    std::vector<std::pair<std::string, std::string> > m_duplicates;    /**< output of the first input, output */
+    size_t          m_hashed;       /**< inputs hashed */
+    size_t          m_linked;       /**< outputs hardlinked */
+    size_t          m_reflinked;    /**< outputs reflinked */
+    size_t          m_copied;       /**< outputs copied */
+    size_t          m_failed;       /**< outputs that could not be made */
+};
+
+#endif  /* _DEDUPE_H */
@@ -0,0 +1,344 @@
+/**
+ * @file        governor.cpp
+ * @version     1.0
+ * @brief       MP3enc_cpp resource governor source
+ * @date        Oct 18, 2026
+ * @author      Siwon Kang (kkangshawn@gmail.com)
+ */
+
+#include "governor.h"
+#include "cancel.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#if defined __linux
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined _WIN32
+#include <Windows.h>
+#endif
+using namespace std;
+
+volatile sig_atomic_t Governor::reload_requested = 0;
+
+static const double GOVERNOR_TICK = 0.05;      /* seconds between CPU accounting */
+static const double BUCKET_BURST = 0.25;       /* seconds of rate a bucket may save up */
+static const double CONTROL_POLL = 1.0;        /* seconds between control file checks */
+
+static double
+cpu_time()
+{
+#if defined __linux
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec * 1e-9;
+#elif defined _WIN32
+    FILETIME c, e, k, u;
+    GetProcessTimes(GetCurrentProcess(), &c, &e, &k, &u);
+    ULARGE_INTEGER kt, ut;
+    kt.LowPart = k.dwLowDateTime;
+    kt.HighPart = k.dwHighDateTime;
+    ut.LowPart = u.dwLowDateTime;
+    ut.HighPart = u.dwHighDateTime;
+    return (double)(kt.QuadPart + ut.QuadPart) * 1e-7;
+#else
+    return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+static long
+thread_id()
+{
+#if defined __linux
+    return (long)syscall(SYS_gettid);
+#else
+    return 0;
+#endif
+}
+
+Governor&
+Governor::instance()
+{
+    static Governor governor;
+
+    return governor;
+}
+
+bool
+Governor::set(const string& key, const string& value)
+{
+    char* end = nullptr;
+    double const v = strtod(value.c_str(), &end);
+    bool const number = !value.empty() && *end == '\0';
+    Lock l(m_lock);
+
+    if (key == "cpu") {
+        if (!number || v < 0) {
+            return false;
+        }
+        m_cpu = v;
+    } else if (key == "nice") {
+        if (!number || v < -20 || v > 19) {
+            return false;
+        }
+        m_nice = (int)v;
+        for (long tid : m_threads) {
+            apply(tid);
+        }
+    } else if (key == "ionice") {
+        size_t const colon = value.find(':');
+        string const cls = value.substr(0, colon);
+        int const level = (colon == string::npos) ? 4 : atoi(value.c_str() + colon + 1);
+        if (level < 0 || level > 7) {
+            return false;
+        }
+        if (cls == "none") {
+            m_ioclass = 0;
+        } else if (cls == "rt") {
+            m_ioclass = 1;
+        } else if (cls == "be") {
+            m_ioclass = 2;
+        } else if (cls == "idle") {
+            m_ioclass = 3;
+        } else {
+            return false;
+        }
+        m_iolevel = (m_ioclass == 1 || m_ioclass == 2) ? level : 0;
+        for (long tid : m_threads) {
+            apply(tid);
+        }
+    } else if (key == "read-rate" || key == "write-rate") {
+        if (!number || v < 0) {
+            return false;
+        }
+        Bucket& b = (key == "read-rate") ? m_read : m_write;
+        b.rate = v * (1 << 20);
+        b.tokens = b.rate * BUCKET_BURST;
+        b.last = monotonic_time();
+    } else {
+        return false;
+    }
+
+    m_enabled = m_cpu > 0 || m_read.rate > 0 || m_write.rate > 0;
+    if (m_cpu <= 0 && m_paused) {
+        m_paused = false;
+        m_cond.broadcast();
+    }
+
+    return true;
+}
+
+bool
+Governor::load(const string& file)
+{
+    ifstream in(file);
+    string line;
+    int n = 0;
+    bool ret = true;
+
+    if (!in.is_open()) {
+        cerr << "ERROR: could not read control file " << file << endl;
+        return false;
+    }
+    while (getline(in, line)) {
+        n++;
+        line = line.substr(0, line.find('#'));
+        replace(line.begin(), line.end(), '=', ' ');
+
+        istringstream ss(line);
+        string key, value;
+        if (!(ss >> key)) {
+            continue;
+        }
+        if (!(ss >> value) || !set(key, value)) {
+            cerr << "ERROR: " << file << ":" << n << ": invalid setting \"" << line << "\"" << endl;
+            ret = false;
+        }
+    }
+
+    return ret;
+}
+
+void
+Governor::start(const string& control)
+{
+    m_control = control;
+    if (!m_control.empty()) {
+        reload();
+#if defined __linux
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = hangup;
+        sa.sa_flags = SA_RESTART;
+        sigemptyset(&sa.sa_mask);
+        sigaction(SIGHUP, &sa, NULL);
+#endif
+    }
+
+    Lock l(m_lock);
+    if (!m_running && (m_cpu > 0 || !m_control.empty())) {
+        m_running = true;
+        m_stop = false;
+        Thread::start();
+    }
+}
+
+void
+Governor::stop()
+{
+    {
+        Lock l(m_lock);
+        if (!m_running) {
+            return;
+        }
+        m_stop = true;
+        m_cond.broadcast();
+    }
+    join();
+
+    Lock l(m_lock);
+    m_running = false;
+}
+
+void
+Governor::enter()
+{
+    long const tid = thread_id();
+    Lock l(m_lock);
+
+    m_threads.push_back(tid);
+    apply(tid);
+}
+
+void
+Governor::leave()
+{
+    long const tid = thread_id();
+    Lock l(m_lock);
+
+    m_threads.erase(remove(m_threads.begin(), m_threads.end(), tid), m_threads.end());
+}
+
+double
+Governor::pace(size_t read, size_t written)
+{
+    if (!m_enabled) {
+        return 0;
+    }
+
+    double const start = monotonic_time();
+    Lock l(m_lock);
+
+    while (m_paused && !Cancel::aborted()) {
+        m_cond.wait_for(m_lock, GOVERNOR_TICK);
+    }
+    double const until = monotonic_time() + max(consume(m_read, read), consume(m_write, written));
+    double now;
+    while ((now = monotonic_time()) < until && !Cancel::aborted()) {
+        m_cond.wait_for(m_lock, until - now);
+    }
+
+    return monotonic_time() - start;
+}
+
+double
+Governor::consume(Bucket& b, size_t bytes)
+{
+    if (b.rate <= 0) {
+        return 0;
+    }
+    double const now = monotonic_time();
+    b.tokens = min(b.tokens + (now - b.last) * b.rate, b.rate * BUCKET_BURST);
+    b.last = now;
+    b.tokens -= bytes;
+
+    return b.tokens < 0 ? -b.tokens / b.rate : 0;
+}
+
+void
+Governor::apply(long tid)
+{
+#if defined __linux
+    if (m_nice != NICE_KEEP && setpriority(PRIO_PROCESS, (id_t)tid, m_nice) != 0) {
+        cerr << "WARNING: failed to set nice value " << m_nice << ": " << strerror(errno) << endl;
+    }
+    /* IOPRIO_WHO_PROCESS with a thread id applies to that thread only */
+    if (m_ioclass >= 0 && syscall(SYS_ioprio_set, 1, (int)tid, (m_ioclass << 13) | m_iolevel) != 0) {
+        cerr << "WARNING: failed to set I/O priority: " << strerror(errno) << endl;
+    }
+#else
+    (void)tid;
+    if (m_nice != NICE_KEEP || m_ioclass >= 0) {
+        DEBUG::WARN("nice and ionice are only supported on Linux");
+    }
+#endif
+}
+
+void
+Governor::reload()
+{
+    struct stat st;
+    double const mtime = (stat(m_control.c_str(), &st) == 0) ? (double)st.st_mtime : 0;
+
+    if (!reload_requested && mtime == m_mtime) {
+        return;
+    }
+    reload_requested = 0;
+    m_mtime = mtime;
+    DEBUG::INFO("loading control file");
+    load(m_control);
+}
+
+void
+Governor::run()
+{
+    double wall = monotonic_time();
+    double cpu = cpu_time();
+    double credit = 0;
+    double next_reload = wall + CONTROL_POLL;
+
+    m_lock.lock();
+    while (!m_stop) {
+        m_cond.wait_for(m_lock, GOVERNOR_TICK);
+
+        double const now = monotonic_time();
+        double const used = cpu_time();
+        bool paused = false;
+        if (m_cpu > 0) {
+            /* earn the share of wall time, spend the CPU time used by the whole process */
+            double const share = m_cpu / 100;
+            credit = min(credit + (now - wall) * share - (used - cpu), GOVERNOR_TICK * share);
+            paused = (credit < 0);
+        } else {
+            credit = 0;
+        }
+        if (m_paused && !paused) {
+            m_cond.broadcast();
+        }
+        m_paused = paused;
+        wall = now;
+        cpu = used;
+
+        if (!m_control.empty() && (reload_requested || now >= next_reload)) {
+            next_reload = now + CONTROL_POLL;
+            m_lock.unlock();
+            reload();
+            m_lock.lock();
+        }
+    }
+    m_paused = false;
+    m_cond.broadcast();
+    m_lock.unlock();
+}
+
+void
+Governor::hangup(int sig)
+{
+    (void)sig;
+    reload_requested = 1;
+}
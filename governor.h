@@ -0,0 +1,115 @@
+/**
+ * @file        governor.h
+ * @version     1.0
+ * @brief       MP3enc_cpp resource governor header
+ * @date        Oct 18, 2026
+ * @author      Siwon Kang (kkangshawn@gmail.com)
+ */
+
+#ifndef _GOVERNOR_H
+#define _GOVERNOR_H
+
+#include "common.h"
+#include "utils.h"
+#include "thread.h"
+
+#include <atomic>
+#include <csignal>
+#include <string>
+#include <vector>
+
+/**
+ * @class   Governor governor.h "governor.h"
+ * @brief   Process wide limits on the resources used by the encoding workers.
+ *          - cpu: percent of one processor, enforced by pausing workers between blocks
+ *          - nice, ionice: scheduling classes applied to every worker thread
+ *          - read-rate, write-rate: token buckets on the bytes read and written by all jobs
+ *          Limits are set from the command line and may be changed at runtime through a
+ *          control file of "key value" lines, which is reloaded when it changes or on SIGHUP.
+ */
+class Governor : public Thread, Utils, DEBUG {
+public:
+    static Governor&    instance();     /**< the process wide governor */
+
+    /**
+     * @fn      bool set(const std::string& key, const std::string& value)
+     * @brief   set a limit: "cpu" in percent, "nice" as a nice value, "ionice" as
+     *          idle, be[:level], rt[:level] or none, "read-rate" and "write-rate" in MB/s.
+     *          A value of 0 removes cpu and rate limits.
+     * @return  false if the key or value is invalid
+     */
+    bool    set(const std::string& key, const std::string& value);
+    /**
+     * @fn      bool load(const std::string& file)
+     * @brief   apply every "key value" or "key=value" line of a control file. '#' starts a comment.
+     * @return  false if the file could not be read or has an invalid line
+     */
+    bool    load(const std::string& file);
+    /**
+     * @fn      void start(const std::string& control)
+     * @brief   start governing if any limit is set or a control file is given.
+     * @param [in]  control     control file to watch, empty for none
+     */
+    void    start(const std::string& control);
+    /**
+     * @fn      void stop()
+     * @brief   stop the governor thread and release paused workers.
+     */
+    void    stop();
+    /**
+     * @fn      void enter()
+     * @brief   apply the scheduling classes to the calling worker thread and keep
+     *          them applied when they change. Paired with leave().
+     */
+    void    enter();
+    void    leave();        /**< forget the calling worker thread */
+    /**
+     * @fn      double pace(size_t read, size_t written)
+     * @brief   account the bytes of one block and wait while the limits are exceeded.
+     *          Called by the encoding loop between blocks.
+     * @return  seconds spent waiting
+     */
+    double  pace(size_t read, size_t written);
+
+private:
+    /**
+     * @struct  Bucket
+     * @brief   Token bucket allowing rate bytes per second with a burst of a quarter second.
+     *          Tokens go negative to admit large blocks; the debt is waited out.
+     */
+    struct Bucket {
+        double  rate;       /**< bytes per second, 0 for no limit */
+        double  tokens;     /**< bytes available */
+        double  last;       /**< time of the last refill */
+    };
+
+    static const int NICE_KEEP = 100;   /**< m_nice value to leave the nice value as is */
+
+    Governor() : m_cpu(0), m_nice(NICE_KEEP), m_ioclass(-1), m_iolevel(0), m_read{ 0, 0, 0 }, m_write{ 0, 0, 0 },
+                m_enabled(false), m_paused(false), m_stop(false), m_running(false), m_mtime(0) {}
+    void    run();
+    void    apply(long tid);
+    void    reload();
+    double  consume(Bucket& b, size_t bytes);
+    static void hangup(int sig);
+
+    double                  m_cpu;      /**< percent of one processor, 0 for no limit */
+    int                     m_nice;     /**< nice value of worker threads, NICE_KEEP to keep */
+    int                     m_ioclass;  /**< I/O scheduling class, -1 to keep */
+    int                     m_iolevel;  /**< priority level within m_ioclass */
+    Bucket                  m_read;     /**< bytes read */
+    Bucket                  m_write;    /**< bytes written */
+    std::vector<long>       m_threads;  /**< attached worker threads */
+    std::string             m_control;  /**< control file */
+    std::atomic<bool>       m_enabled;  /**< any limit may apply */
+    std::atomic<bool>       m_paused;   /**< workers shall wait for CPU credit */
+    bool                    m_stop;     /**< the governor thread shall exit */
+    bool                    m_running;  /**< the governor thread is started */
+    double                  m_mtime;    /**< modification time of the loaded control file */
+    Mutex                   m_lock;     /**< protects the members above */
+    Condition               m_cond;     /**< wakes up paused workers and the governor thread */
+
+    static volatile sig_atomic_t    reload_requested;
+};
+
+#endif  /* _GOVERNOR_H */
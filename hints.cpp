@@ -0,0 +1,135 @@
+/**
+ * @file        hints.cpp
+ * @version     1.0
+ * @brief       MP3enc_cpp page cache hints source
+ * @date        Oct 18, 2026
+ * @author      Siwon Kang (kkangshawn@gmail.com)
+ */
+
+#include "hints.h"
+
+#include <algorithm>
+#if defined __linux
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+/* bytes read ahead of the cursor, renewed when half of it is consumed */
+static const size_t READ_AHEAD = 4 << 20;
+/* bytes kept behind the cursor for the short seeks back of segment encoding */
+static const size_t KEEP_BEHIND = 1 << 20;
+
+bool StreamHints::streaming = false;
+
+void
+StreamHints::open(const string& path, size_t pos)
+{
+    close();
+    if (!streaming) {
+        return;
+    }
+#if defined __linux
+    struct stat st;
+
+    /* opening a pipe once more would block or steal its data */
+    if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+        return;
+    }
+    m_fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (m_fd < 0) {
+        return;
+    }
+    sequential(m_fd);
+    m_ahead = m_dropped = pos;
+    advance(pos);
+#else
+    (void)path;
+    (void)pos;
+#endif
+}
+
+void
+StreamHints::advance(size_t pos)
+{
+    if (m_fd < 0) {
+        return;
+    }
+#if defined __linux
+    if (pos + READ_AHEAD / 2 > m_ahead) {
+        size_t const from = max(pos, m_ahead);
+        readahead(m_fd, (off64_t)from, pos + READ_AHEAD - from);
+        m_ahead = pos + READ_AHEAD;
+    }
+    if (pos > m_dropped + KEEP_BEHIND * 2) {
+        size_t const to = pos - KEEP_BEHIND;
+        drop(m_fd, m_dropped, to - m_dropped);
+        m_dropped = to;
+    }
+#endif
+}
+
+void
+StreamHints::close()
+{
+    if (m_fd < 0) {
+        return;
+    }
+#if defined __linux
+    drop(m_fd, 0, 0);
+    ::close(m_fd);
+#endif
+    m_fd = -1;
+}
+
+void
+StreamHints::sequential(int fd)
+{
+#if defined __linux
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#else
+    (void)fd;
+#endif
+}
+
+void
+StreamHints::drop(int fd, size_t offset, size_t len)
+{
+#if defined __linux
+    posix_fadvise(fd, (off_t)offset, (off_t)len, POSIX_FADV_DONTNEED);
+#else
+    (void)fd;
+    (void)offset;
+    (void)len;
+#endif
+}
+
+void
+StreamHints::write_behind(int fd, size_t offset, size_t len)
+{
+#if defined __linux
+    sync_file_range(fd, (off64_t)offset, (off64_t)len, SYNC_FILE_RANGE_WRITE);
+    if (offset > 0) {
+        /* written back by the previous call in the meantime, normally without waiting */
+        sync_file_range(fd, 0, (off64_t)offset,
+                SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+        posix_fadvise(fd, 0, (off_t)offset, POSIX_FADV_DONTNEED);
+    }
+#else
+    (void)fd;
+    (void)offset;
+    (void)len;
+#endif
+}
+
+void
+StreamHints::drop_written(int fd)
+{
+#if defined __linux
+    sync_file_range(fd, 0, 0, SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+#else
+    (void)fd;
+#endif
+}
@@ -0,0 +1,84 @@
+/**
+ * @file        hints.h
+ * @version     1.0
+ * @brief       MP3enc_cpp page cache hints header
+ * @date        Oct 18, 2026
+ * @author      Siwon Kang (kkangshawn@gmail.com)
+ */
+
+#ifndef _HINTS_H
+#define _HINTS_H
+
+#include "common.h"
+#include "utils.h"
+
+#include <string>
+
+/**
+ * @class   StreamHints hints.h "hints.h"
+ * @brief   Page cache hints for data read or written exactly once, enabled by --stream.
+ *          An input is declared sequential, read ahead of its cursor with readahead() and
+ *          dropped behind it with POSIX_FADV_DONTNEED, so a huge batch does not evict the
+ *          page cache of other processes. Outputs are written back with sync_file_range()
+ *          while they are written and dropped once complete. No-op on other systems.
+ */
+class StreamHints : public Utils, DEBUG {
+public:
+    StreamHints() : m_fd(-1), m_ahead(0), m_dropped(0) {}
+    virtual ~StreamHints() { close(); }
+
+    static void     set_enabled(bool enabled) { streaming = enabled; }
+    static bool     enabled() { return streaming; }
+
+    /**
+     * @fn      void open(const std::string& path, size_t pos)
+     * @brief   start hinting a regular input file read sequentially from pos.
+     *          The file is opened once more for the hints; pipes are ignored.
+     */
+    void            open(const std::string& path, size_t pos);
+    /**
+     * @fn      void advance(size_t pos)
+     * @brief   tell the cursor of the reader, to read ahead of it and drop what lies behind.
+     */
+    void            advance(size_t pos);
+    /**
+     * @fn      void close()
+     * @brief   drop the whole input from the page cache and stop hinting.
+     */
+    void            close();
+    bool            is_open() const { return m_fd >= 0; }
+
+    /**
+     * @fn      static void sequential(int fd)
+     * @brief   declare a file read sequentially from start to end.
+     */
+    static void     sequential(int fd);
+    /**
+     * @fn      static void drop(int fd, size_t offset, size_t len)
+     * @brief   drop a range of an input already read, len 0 to the end of the file.
+     */
+    static void     drop(int fd, size_t offset, size_t len);
+    /**
+     * @fn      static void write_behind(int fd, size_t offset, size_t len)
+     * @brief   start writing back a range just written and drop the range written before it
+     *          once it is on disk, so dirty pages of an output never pile up.
+     */
+    static void     write_behind(int fd, size_t offset, size_t len);
+    /**
+     * @fn      static void drop_written(int fd)
+     * @brief   write back a complete output and drop it from the page cache.
+     */
+    static void     drop_written(int fd);
+
+private:
+    StreamHints(const StreamHints&);
+    StreamHints& operator=(const StreamHints&);
+
+    int             m_fd;           /**< file descriptor of the hinted input, -1 if none */
+    size_t          m_ahead;        /**< end of the range read ahead so far */
+    size_t          m_dropped;      /**< end of the range dropped so far */
+
+    static bool     streaming;      /**< --stream is set */
+};
+
+#endif  /* _HINTS_H */
@@ -0,0 +1,100 @@
+/**
+ * @file        job.h
+ * @version     1.0
+ * @brief       MP3enc_cpp encoding job header
+ * @date        Oct 18, 2026
+ * @author      Siwon Kang (kkangshawn@gmail.com)
+ */
+
+#ifndef _JOB_H
+#define _JOB_H
+
+#include "storage.h"
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+struct SegmentSet;
+
+/**
+ * @struct  Job job.h "job.h"
+ * @brief   A unit of work for WorkerPool: one input file encoded to one output file,
+ *          or one segment of an input file split by Planner across several jobs.
+ *          Timestamps are taken from Utils::monotonic_time().
+ */
+struct Job {
+    enum STATE { JS_QUEUED, JS_RUNNING, JS_DONE, JS_FAILED, JS_CANCELED };
+    enum PRIORITY { JP_INTERACTIVE, JP_NORMAL, JP_BULK, JP_COUNT };
+
+    Job(size_t id, std::string in, std::string out) : id(id), inPath(in), outPath(out),
+                state(JS_QUEUED), priority(JP_NORMAL), deadline(0), queued(0), started(0), finished(0), audioSeconds(0), inputBytes(0),
+                memEstimate(0), memUsed(0), predicted(0), segment(0), first(0), samples(0),
+                split(nullptr), setup(0), handoff(0), device(nullptr) {}
+
+    double  latency() const { return finished - started; }  /**< seconds spent in a worker */
+    double  wait() const { return started - queued; }       /**< seconds spent in the queue */
+    static const char* priority_name(int p) {
+        static const char* names[] = { "interactive", "normal", "bulk" };
+        return (p >= JP_INTERACTIVE && p < JP_COUNT) ? names[p] : "unknown";
+    }
+
+    size_t      id;             /**< sequence number in order of submission */
+    std::string inPath;         /**< input wav file */
+    std::string outPath;        /**< output mp3 file, derived from inPath if empty */
+    STATE       state;          /**< current state */
+    PRIORITY    priority;       /**< class the job is scheduled in */
+    double      deadline;       /**< time it shall be finished by, 0 if none */
+    double      queued;         /**< time when submitted */
+    double      started;        /**< time when a worker picked it up */
+    double      finished;       /**< time when the worker finished it */
+    double      audioSeconds;   /**< duration of the input audio */
+    double      inputBytes;     /**< size of the input file when submitted, -1 if unknown */
+    size_t      memEstimate;    /**< working set reserved against the memory budget */
+    size_t      memUsed;        /**< working set actually allocated */
+    double      predicted;      /**< cost planned by Planner in seconds of audio, 0 if not planned */
+    size_t      segment;        /**< index of the segment in split */
+    unsigned long first;        /**< first sample of the segment */
+    unsigned long samples;      /**< samples of the segment, 0 to encode the whole file */
+    SegmentSet* split;          /**< segments of the same input file, nullptr if encoded whole */
+    double      setup;          /**< seconds in a worker outside reading, encoding and writing */
+    double      handoff;        /**< seconds the worker took to start it once both were ready */
+    Storage::Device* device;    /**< device of the input, nullptr if unknown */
+};
+
+/**
+ * @struct  SegmentSet job.h "job.h"
+ * @brief   The segments of one input file. Each job encodes its segment into parts and
+ *          the job finishing last joins them into the output file.
+ */
+struct SegmentSet {
+    explicit SegmentSet(size_t count) : parts(count), pending(count), failed(false) {}
+
+    std::vector<std::vector<unsigned char> > parts;    /**< mp3 frames of each segment */
+    size_t      pending;        /**< segments not finished yet, protected by the lock of the pool */
+    bool        failed;         /**< a segment failed, protected by the lock of the pool */
+};
+
+/**
+ * @struct  Heartbeat job.h "job.h"
+ * @brief   Stage and time of the last progress made by a worker, updated lock free
+ *          by the encoding thread and read by the watchdog.
+ */
+struct Heartbeat {
+    enum STAGE { HB_IDLE, HB_OPENING, HB_READING, HB_ENCODING, HB_WRITING, HB_TAGGING };
+
+    Heartbeat() : stage(HB_IDLE), time(0), audio(0), abandoned(false) {}
+
+    void    beat(STAGE s, double t) { stage = s; time = t; }  /**< record progress */
+    static const char* name(int s) {
+        static const char* names[] = { "idle", "opening", "reading", "encoding", "writing", "tagging" };
+        return (s >= HB_IDLE && s <= HB_TAGGING) ? names[s] : "unknown";
+    }
+
+    std::atomic<int>    stage;  /**< current STAGE */
+    std::atomic<double> time;   /**< monotonic time of the last beat */
+    std::atomic<double> audio;  /**< seconds of audio encoded by the worker so far */
+    std::atomic<bool>   abandoned;  /**< the job was given up and shall stop at the next block */
+};
+
+#endif  /* _JOB_H */
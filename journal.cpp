@@ -0,0 +1,332 @@
+/**
+ * @file        journal.cpp
+ * @version     1.0
+ * @brief       MP3enc_cpp batch journal source
+ * @date        Oct 18, 2026
+ * @author      Siwon Kang (kkangshawn@gmail.com)
+ */
+
+#include "journal.h"
+#include "audio.h"
+#include "manifest.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#if defined __linux
+#include <dirent.h>
+#include <unistd.h>
+#elif defined _WIN32
+#include <Windows.h>
+#include <io.h>
+#include <process.h>
+#define getpid _getpid
+#endif
+using namespace std;
+
+static const char* const JOURNAL_HEADER = "# MP3enc_cpp journal 1";
+/* events buffered before the flusher thread is woken up early */
+static const size_t JOURNAL_BATCH = 64 << 10;
+
+Journal&
+Journal::instance()
+{
+    static Journal journal;
+
+    return journal;
+}
+
+bool
+Journal::open(const string& path, bool resume)
+{
+    Lock l(m_lock);
+
+    m_path = path;
+    m_entries.clear();
+    m_index.clear();
+    m_pids.clear();
+    m_since = (long long)time(nullptr);
+    m_committed = m_rejected = 0;
+    if (resume && !replay()) {
+        return false;
+    }
+    m_file = fopen(path.c_str(), resume ? "ab" : "wb");
+    if (!m_file) {
+        return false;
+    }
+    /* the events of this run shall not continue a line cut short */
+#if defined __linux
+    bool const cut = resume && ftruncate(fileno(m_file), m_length) != 0;
+#elif defined _WIN32
+    bool const cut = resume && _chsize_s(_fileno(m_file), m_length) != 0;
+#endif
+    if (cut) {
+        fclose(m_file);
+        m_file = nullptr;
+        return false;
+    }
+    ostringstream run;
+    if (!resume) {
+        run << JOURNAL_HEADER << '\n';
+    }
+    run << "P\t" << getpid() << '\t' << (long long)time(nullptr) << '\n';
+    m_buffer = run.str();
+    m_stop = false;
+    start();
+
+    return true;
+}
+
+void
+Journal::close()
+{
+    {
+        Lock l(m_lock);
+        if (!m_file) {
+            return;
+        }
+        m_stop = true;
+        m_cond.signal();
+    }
+    join();
+    write();
+    Lock l(m_lock);
+    fclose(m_file);
+    m_file = nullptr;
+}
+
+bool
+Journal::replay()
+{
+    ifstream in(m_path, ios::binary | ios::ate);
+    string text;
+
+    if (!in.is_open()) {
+        cerr << "ERROR: could not read journal " << m_path << endl;
+        return false;
+    }
+    text.resize((size_t)in.tellg());
+    in.seekg(0);
+    in.read(&text[0], text.size());
+    if (text.compare(0, strlen(JOURNAL_HEADER), JOURNAL_HEADER) != 0) {
+        cerr << "ERROR: " << m_path << " is not a journal of this encoder" << endl;
+        return false;
+    }
+    /* a line cut short by a crash is ignored */
+    size_t pos = text.find('\n');
+    size_t const end = text.rfind('\n') + 1;
+    m_length = end;
+    while (pos != string::npos && pos + 1 < end) {
+        size_t const next = text.find('\n', pos + 1);
+        string const line = text.substr(pos + 1, next - pos - 1);
+        char const type = line.empty() ? 0 : line[0];
+        size_t const tab = line.find('\t', 2);
+        pos = next;
+        if (type == 'J' && tab != string::npos) {
+            size_t const n = strtoul(line.c_str() + 2, nullptr, 10);
+            size_t const sep = line.find('\t', tab + 1);
+            if (sep == string::npos || n != m_entries.size()) {
+                continue;
+            }
+            Entry const e = { line.substr(tab + 1, sep - tab - 1), line.substr(sep + 1), false };
+            m_index[AudioData::output_name(e.in, e.output)] = n;
+            m_entries.push_back(e);
+        } else if (type == 'D') {
+            size_t const n = strtoul(line.c_str() + 2, nullptr, 10);
+            if (n < m_entries.size()) {
+                m_entries[n].done = true;
+            }
+        } else if (type == 'P' && tab != string::npos) {
+            long long const since = atoll(line.c_str() + tab + 1);
+            m_pids.push_back(line.substr(2, tab - 2));
+            if (m_pids.size() == 1) {
+                m_since = since;
+            }
+        }
+    }
+
+    return true;
+}
+
+vector<pair<string, string> >
+Journal::pending()
+{
+    vector<pair<string, string> > jobs;
+    vector<string> partial;
+    Lock l(m_lock);
+
+    for (Entry& e : m_entries) {
+        string const output = AudioData::output_name(e.in, e.output);
+        if (e.done) {
+            double size;
+            long long mtime;
+            unsigned char head[3] = { 0, 0, 0 };
+            ifstream out(output, ios::binary);
+            out.read((char*)head, sizeof(head));
+            /* an mp3 starts with an ID3 tag or a frame sync */
+            bool const mp3 = !memcmp(head, "ID3", 3) || (head[0] == 0xff && (head[1] & 0xe0) == 0xe0);
+            if (Manifest::stamp(output, size, mtime) && size > 0 && mtime >= m_since * 1000000000LL && mp3) {
+                m_committed++;
+                continue;
+            }
+            cerr << "WARNING: " << output << " was committed but is missing or invalid, encoding again" << endl;
+            e.done = false;
+            m_rejected++;
+        }
+        partial.push_back(output);
+        jobs.push_back(make_pair(e.in, e.output));
+    }
+    discard(partial);
+
+    return jobs;
+}
+
+void
+Journal::discard(const vector<string>& outputs)
+{
+    unordered_map<string, vector<string> > dirs;
+
+    /* temporary outputs are named .<name>.<pid>.<...>.tmp, see OutputWriter::open() */
+    for (const string& output : outputs) {
+        size_t const slash = output.find_last_of("/\\");
+        string const dir = slash == string::npos ? "." : output.substr(0, slash);
+        string const name = slash == string::npos ? output : output.substr(slash + 1);
+        for (const string& pid : m_pids) {
+            dirs[dir].push_back("." + name + "." + pid + ".");
+        }
+    }
+    for (unordered_map<string, vector<string> >::const_iterator it = dirs.begin(); it != dirs.end(); ++it) {
+        vector<string> names;
+#if defined __linux
+        DIR* dir = opendir(it->first.c_str());
+        struct dirent* ent;
+        while (dir && (ent = readdir(dir)) != NULL) {
+            names.push_back(ent->d_name);
+        }
+        if (dir) {
+            closedir(dir);
+        }
+#elif defined _WIN32
+        WIN32_FIND_DATAA data;
+        HANDLE hFind = FindFirstFileA((it->first + "\\.*.tmp").c_str(), &data);
+        if (hFind != INVALID_HANDLE_VALUE) {
+            do {
+                names.push_back(data.cFileName);
+            } while (FindNextFileA(hFind, &data));
+            FindClose(hFind);
+        }
+#endif
+        for (const string& name : names) {
+            if (name.size() < 5 || name.compare(name.size() - 4, 4, ".tmp") != 0) {
+                continue;
+            }
+            for (const string& prefix : it->second) {
+                if (name.compare(0, prefix.size(), prefix) == 0) {
+                    string const path = it->first + DELIMITER + name;
+                    DEBUG::INFO(("removing partial output " + path).c_str());
+                    remove(path.c_str());
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void
+Journal::add(const string& in, const string& output)
+{
+    string const name = AudioData::output_name(in, output);
+    Lock l(m_lock);
+
+    if (!m_file || m_index.count(name)) {
+        return;
+    }
+    ostringstream line;
+    line << "J\t" << m_entries.size() << '\t' << in << '\t' << output << '\n';
+    m_index[name] = m_entries.size();
+    Entry const e = { in, output, false };
+    m_entries.push_back(e);
+    m_buffer += line.str();
+}
+
+void
+Journal::started(const string& output)
+{
+    Lock l(m_lock);
+    unordered_map<string, size_t>::const_iterator it = m_index.find(output);
+
+    if (m_file && it != m_index.end()) {
+        record('S', it->second);
+    }
+}
+
+void
+Journal::done(const string& output)
+{
+    Lock l(m_lock);
+    unordered_map<string, size_t>::const_iterator it = m_index.find(output);
+
+    if (m_file && it != m_index.end()) {
+        m_entries[it->second].done = true;
+        record('D', it->second);
+    }
+}
+
+void
+Journal::record(char type, size_t entry)
+{
+    char line[32];
+
+    snprintf(line, sizeof(line), "%c\t%zu\n", type, entry);
+    m_buffer += line;
+    if (m_buffer.size() >= JOURNAL_BATCH) {
+        m_cond.signal();
+    }
+}
+
+void
+Journal::run()
+{
+    Lock l(m_lock);
+
+    while (!m_stop) {
+        m_cond.wait_for(m_lock, 0.1);
+        if (!m_buffer.empty()) {
+            m_lock.unlock();
+            write();
+            m_lock.lock();
+        }
+    }
+}
+
+void
+Journal::write()
+{
+    Lock w(m_write_lock);
+    string batch;
+
+    {
+        Lock l(m_lock);
+        batch.swap(m_buffer);
+    }
+    if (batch.empty()) {
+        return;
+    }
+    if (fwrite(batch.data(), 1, batch.size(), m_file) != batch.size() || fflush(m_file) != 0) {
+        cerr << "WARNING: could not append to journal " << m_path << endl;
+    }
+}
+
+string
+Journal::report()
+{
+    ostringstream msg;
+    Lock l(m_lock);
+
+    msg << "Journal: " << m_entries.size() << " output(s), " << m_committed << " committed by earlier runs, " <<
+        m_rejected << " rejected on verification";
+
+    return msg.str();
+}
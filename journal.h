@@ -0,0 +1,105 @@
+/**
+ * @file        journal.h
+ * @version     1.0
+ * @brief       MP3enc_cpp batch journal header
+ * @date        Oct 18, 2026
+ * @author      Siwon Kang (kkangshawn@gmail.com)
+ */
+
+#ifndef _JOURNAL_H
+#define _JOURNAL_H
+
+#include "common.h"
+#include "utils.h"
+#include "thread.h"
+
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @class   Journal journal.h "journal.h"
+ * @brief   Append-only record of a batch, written with --journal and replayed by --resume.
+ *          One tab separated line per event:
+ *              P <pid> <time>          a run started
+ *              J <entry> <in> <output> an output was enumerated
+ *              S <entry>               its encoding started
+ *              D <entry>               it was committed under its final name
+ *          Events are buffered and appended by a flusher thread at most every 100ms, so
+ *          workers never wait on the file. A lost tail only makes a resumed run encode again.
+ */
+class Journal : public Thread, Utils, DEBUG {
+public:
+    static Journal& instance();     /**< the process wide journal */
+
+    /**
+     * @fn      bool open(const std::string& path, bool resume)
+     * @brief   start a new journal, or replay an existing one and append to it.
+     * @return  false if the file could not be written, or read when resuming
+     */
+    bool            open(const std::string& path, bool resume);
+    /**
+     * @fn      void close()
+     * @brief   append what is buffered and stop the flusher thread.
+     */
+    void            close();
+    bool            is_open() const { return m_file != nullptr; }
+
+    /**
+     * @fn      std::vector<std::pair<std::string, std::string> > pending()
+     * @brief   list the inputs and outputs a resumed run shall encode: those not committed,
+     *          and those committed whose output is missing, older than the batch or not an mp3.
+     *          Temporary files left by earlier runs next to them are removed.
+     */
+    std::vector<std::pair<std::string, std::string> > pending();
+    /**
+     * @fn      void add(const std::string& in, const std::string& output)
+     * @brief   record an output of the batch, unless it is recorded already.
+     */
+    void            add(const std::string& in, const std::string& output);
+    void            started(const std::string& output);     /**< record that an output is being encoded */
+    void            done(const std::string& output);        /**< record that an output is committed */
+    /**
+     * @fn      std::string report()
+     * @brief   summarize what the replay found.
+     */
+    std::string     report();
+
+private:
+    /**
+     * @struct  Entry
+     * @brief   An output of the batch.
+     */
+    struct Entry {
+        std::string     in;
+        std::string     output;     /**< output path given to the job */
+        bool            done;       /**< committed */
+    };
+
+    Journal() : m_path{}, m_file(nullptr), m_entries{}, m_index{}, m_pids{}, m_since(0), m_length(0), m_buffer{},
+                m_stop(false), m_committed(0), m_rejected(0) {}
+    void            run();
+    bool            replay();
+    void            record(char type, size_t entry);
+    void            write();
+    void            discard(const std::vector<std::string>& outputs);
+
+    std::string                 m_path;     /**< journal file */
+    FILE*                       m_file;     /**< journal opened for append */
+    std::vector<Entry>          m_entries;  /**< outputs by entry number */
+    std::unordered_map<std::string, size_t> m_index;    /**< entry numbers by output name */
+    std::vector<std::string>    m_pids;     /**< processes of earlier runs */
+    long long                   m_since;    /**< start of the first run, seconds since the epoch */
+    size_t                      m_length;   /**< length of the replayed journal up to its last full line */
+    std::string                 m_buffer;   /**< events not written yet */
+    bool                        m_stop;     /**< the flusher thread shall exit */
+    size_t                      m_committed;    /**< entries found committed by the replay */
+    size_t                      m_rejected;     /**< committed entries whose output failed verification */
+    Mutex                       m_lock;     /**< protects the members above */
+    Condition                   m_cond;     /**< wakes up the flusher thread */
+    Mutex                       m_write_lock;   /**< serializes write() */
+};
+
+#endif  /* _JOURNAL_H */
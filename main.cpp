@@ -7,13 +7,23 @@
  */
 
 #include "main.h"
+#include "cancel.h"
+#include "governor.h"
+#include "journal.h"
+#include "reader.h"
+#include "trace.h"
 
+#include <algorithm>
 #include <vector>
+#include <cstdint>
+#include <cstdlib>
 #include <time.h>
+#include <sys/stat.h>
 #if defined __linux
 #include <dirent.h>
 #elif defined _WIN32
 #include <Windows.h>
+#include <direct.h>
 #endif
 using namespace std;
 
@@ -27,12 +37,80 @@ MP3enc::showUsage()
     cout << "   MP3enc_cpp <input_directory | input_filename [-o <output_filename>]> [OPTIONS]" << endl;
     cout << endl << "Options:" << endl;
     cout << "     -h            Show help" << endl;
+    cout << "     -j <num>      Number of encoding threads (default: processors allowed by affinity and cgroup quota)" << endl;
+    cout << "     --adaptive <sec> Tune the number of busy threads up to -j every <sec> from the measured throughput" << endl;
+    cout << "     --trace <file> Write scheduling events to <file> as JSON lines" << endl;
+    cout << "     --plan        Read all the inputs first, split long files across threads when it shortens the batch" << endl;
+    cout << "     --pin <mode>  Bind encoding threads to processors" << endl;
+    cout << "         cpu          one processor per thread, filling one NUMA node after another" << endl;
+    cout << "         node         all the processors of one NUMA node per thread" << endl;
     cout << "     -r            Search subdirectories recursively" << endl;
     cout << "     -q <mode>     Set quality level" << endl;
     cout << "         fast         fast encoding with small file size" << endl;
     cout << "         standard     standard quality - default" << endl;
     cout << "         best         best quality" << endl;
     cout << "     -v            Verbose detail" << endl;
+    cout << "     --cpu <percent> Limit CPU use to <percent> of one processor by pausing workers" << endl;
+    cout << "     --nice <n>    Nice value of encoding threads" << endl;
+    cout << "     --ionice <class> I/O scheduling class of encoding threads: idle, be[:level], rt[:level], none" << endl;
+    cout << "     --read-rate <MB/s>  Limit bytes read per second by all jobs" << endl;
+    cout << "     --write-rate <MB/s> Limit bytes written per second by all jobs" << endl;
+    cout << "     --control <file> Read the limits above from <file> of \"key value\" lines, e.g. \"cpu 150\"." << endl;
+    cout << "                   The file is reloaded when it changes or on SIGHUP" << endl;
+    cout << "     --max-memory <MB> Start jobs only while their estimated memory fits in <MB>" << endl;
+    cout << "     --batch <KB>  Encode inputs up to <KB> back to back in one thread, reusing its buffers." << endl;
+    cout << "                   Their outputs are held in memory until a single write" << endl;
+    cout << "     --batch-jobs <num> Most inputs in a batch (default: 16)" << endl;
+    cout << "     --io <mode>   How inputs are read" << endl;
+    cout << "         direct       by every encoding thread - default" << endl;
+    cout << "         central      in large chunks by one reader thread, prefetching the next inputs" << endl;
+    cout << "     --prefetch <num> Inputs queued next prefetched by the reader thread (default: 2)" << endl;
+    cout << "     --read-chunk <KB> Size of a read of the reader thread (default: 1024)" << endl;
+    cout << "     --hdd-io <num> I/O in flight on each rotational disk, 0 for no limit (default: 2)" << endl;
+    cout << "     --ssd-io <num> I/O in flight on each other device (default: its queue depth)" << endl;
+    cout << "     --output-root <dir> Spread outputs over the given directories by input path, keeping" << endl;
+    cout << "                   their paths relative to the input directory. May be repeated" << endl;
+    cout << "     --stream      Keep inputs and outputs out of the page cache: read ahead of the encoder," << endl;
+    cout << "                   drop what was read and write back outputs as they are written" << endl;
+    cout << "     --incremental Skip inputs whose output exists and is newer than the input" << endl;
+    cout << "     --manifest <file> Record the input and settings of every output in <file>; with" << endl;
+    cout << "                   --incremental, also re-encode outputs of changed inputs or settings" << endl;
+    cout << "     --watch       Keep encoding wav files as they arrive in the input directory," << endl;
+    cout << "                   and its subdirectories with -r, until interrupted" << endl;
+    cout << "     --settle <ms> Time an arriving wav file shall stay untouched before it is" << endl;
+    cout << "                   encoded with --watch (default: 500)" << endl;
+    cout << "     --daemon <socket> Serve encode requests on the Unix socket <socket> until interrupted," << endl;
+    cout << "                   keeping the encoding threads running between requests" << endl;
+    cout << "     --submit <socket> Encode the input path with the daemon serving <socket> and wait for it" << endl;
+    cout << "     --priority <class> Class the inputs are scheduled in, earlier classes first" << endl;
+    cout << "         interactive  ahead of all the others, e.g. a single file someone waits for" << endl;
+    cout << "         normal       default" << endl;
+    cout << "         bulk         behind the others until it waited the aging time, e.g. a backfill" << endl;
+    cout << "     --deadline <sec> Time after submission the inputs shall be encoded by. Inputs of a" << endl;
+    cout << "                   class are scheduled earliest deadline first" << endl;
+    cout << "     --aging <sec> Time a bulk input waits before it is scheduled as normal, 0 never (default: 60)" << endl;
+    cout << "     --journal <file> Record the outputs of the batch and their completion in <file>" << endl;
+    cout << "     --resume <file> Encode only what the batch of journal <file> left incomplete," << endl;
+    cout << "                   without walking the input path" << endl;
+    cout << "     --cache <dir> Keep outputs in <dir> by content and settings, and make outputs of" << endl;
+    cout << "                   inputs encoded before from there" << endl;
+    cout << "     --cache-size <MB> Size of the outputs kept in the cache (default: 1024)" << endl;
+    cout << "     --dedupe <mode> Encode identical inputs once and make the other outputs by" << endl;
+    cout << "         link         hardlink to the first output" << endl;
+    cout << "         reflink      copy-on-write clone of the first output" << endl;
+    cout << "         copy         copy of the first output" << endl;
+    cout << "     --buffer <KB> Size of the output write buffer (default: 1024)" << endl;
+    cout << "     --hold <KB>   Keep outputs estimated up to <KB> in memory until a single write" << endl;
+    cout << "     --cancel-timeout <sec> Time running jobs may take to finish after SIGINT/SIGTERM (default: 10)" << endl;
+    cout << "     --watchdog <x> Report jobs running <x> times longer than expected, with the stage of every worker" << endl;
+    cout << "     --watchdog-min <sec> Never report jobs running less than <sec> (default: 30)" << endl;
+    cout << "     --abandon     Give up reported jobs and continue the batch with a new worker" << endl;
+    cout << "     --sync <mode> Durability of outputs, written to a temporary file and renamed when done" << endl;
+    cout << "         none         rename only, survives a crash of the encoder - default" << endl;
+    cout << "         file         sync every output and its directory before and after renaming" << endl;
+    cout << "         group        sync outputs in groups, see --sync-files and --sync-ms" << endl;
+    cout << "     --sync-files <num> Sync a group once <num> outputs are pending (default: 32)" << endl;
+    cout << "     --sync-ms <ms>  Sync a group once its oldest output waited <ms> (default: 1000)" << endl;
     cout << endl << "Example:" << endl;
     cout << "   MP3enc_cpp input.wav -o output.mp3" << endl;
     cout << "   MP3enc_cpp wav_dir";
@@ -41,7 +119,147 @@ MP3enc::showUsage()
 }
 
 void
-MP3enc::checkPath(string path, vector<AudioData*>& v)
+MP3enc::addJob(const string& in, const Target& t, vector<Job*>& v)
+{
+    if (Cancel::requested()) {
+        return;
+    }
+    string const output = (t.out.empty() && !m_opt.outputRoots.empty()) ? outputUnderRoot(in) : t.out;
+    /* the manifest needs the stamp of every input, only --incremental skips */
+    bool const fresh = (m_opt.incremental || !m_opt.manifest.empty()) && upToDate(in, output);
+    if (m_opt.incremental && fresh) {
+        m_skipped++;
+        return;
+    }
+    if (Journal::instance().is_open()) {
+        Journal::instance().add(in, output);
+    }
+    Cache::Key key;
+    if (m_cache && m_cache->key(in, key)) {
+        string const name = AudioData::output_name(in, output);
+        if (m_cache->fetch(key, name)) {
+            cout << "Encoding " << name << " done, from cache" << endl;
+            m_cached.push_back(name);
+            if (Journal::instance().is_open()) {
+                Journal::instance().done(name);
+            }
+            return;
+        }
+        m_keys[name] = key;
+    }
+    if (m_dedupe && m_dedupe->add(in, output)) {
+        return;
+    }
+    Job* job = new Job(retired() + v.size(), in, output);
+
+    job->priority = t.priority;
+    if (t.deadline > 0) {
+        job->deadline = monotonic_time() + t.deadline;
+    }
+    v.push_back(job);
+    if (m_planner) {
+        m_planner->add(job);
+    } else {
+        m_pool->submit(job);
+    }
+}
+
+bool
+MP3enc::upToDate(const string& in, const string& out)
+{
+    string const output = AudioData::output_name(in, out);
+    Manifest::Entry e = { 0, 0, AudioData::settings_name() + " " + get_lame_version() };
+    double size;
+    long long mtime;
+
+    if (!Manifest::stamp(in, e.size, e.mtime)) {
+        return false;
+    }
+    if (!m_opt.manifest.empty()) {
+        m_stamps[output] = e;
+    }
+    if (!Manifest::stamp(output, size, mtime) || size <= 0 || mtime < e.mtime) {
+        return false;
+    }
+
+    return m_opt.manifest.empty() || m_manifest.matches(output, e);
+}
+
+unordered_map<string, bool>
+MP3enc::completed(const vector<Job*>& v)
+{
+    unordered_map<string, bool> done;
+
+    /* an output split into segments is complete when every segment is */
+    for (const Job* j : v) {
+        string const output = AudioData::output_name(j->inPath, j->outPath);
+        unordered_map<string, bool>::iterator it = done.find(output);
+        bool const ok = j->state == Job::JS_DONE;
+        if (it == done.end()) {
+            done[output] = ok;
+        } else {
+            it->second = it->second && ok;
+        }
+    }
+
+    return done;
+}
+
+void
+MP3enc::updateManifest(const unordered_map<string, bool>& done, const vector<string>& made)
+{
+    for (unordered_map<string, bool>::const_iterator it = done.begin(); it != done.end(); ++it) {
+        unordered_map<string, Manifest::Entry>::const_iterator e = m_stamps.find(it->first);
+        if (it->second && e != m_stamps.end()) {
+            m_manifest.set(it->first, e->second);
+        }
+    }
+    for (const string& output : made) {
+        unordered_map<string, Manifest::Entry>::const_iterator e = m_stamps.find(output);
+        if (e != m_stamps.end()) {
+            m_manifest.set(output, e->second);
+        }
+    }
+    if (!m_manifest.save()) {
+        cerr << "ERROR: could not write manifest " << m_opt.manifest << endl;
+    }
+}
+
+string
+MP3enc::outputUnderRoot(const string& in)
+{
+    string base = m_opt.inPath;
+    string relative;
+    uint64_t h = 14695981039346656037ULL;
+
+    if (!base.empty() && base.back() == DELIMITER) {
+        base.pop_back();
+    }
+    if (in.size() > base.size() + 1 && in.compare(0, base.size(), base) == 0 && in[base.size()] == DELIMITER) {
+        relative = in.substr(base.size() + 1);
+    } else {
+        relative = in.substr(in.find_last_of(DELIMITER) + 1);
+    }
+    /* FNV-1a of the relative path, so an input keeps its root however the tree changes */
+    for (char c : relative) {
+        h = (h ^ (unsigned char)c) * 1099511628211ULL;
+    }
+    string out = m_opt.outputRoots[h % m_opt.outputRoots.size()] + DELIMITER + relative;
+
+    for (size_t pos = out.find(DELIMITER, 1); pos != string::npos; pos = out.find(DELIMITER, pos + 1)) {
+        string const dir = out.substr(0, pos);
+#if defined __linux
+        mkdir(dir.c_str(), 0777);
+#elif defined _WIN32
+        _mkdir(dir.c_str());
+#endif
+    }
+
+    return out;
+}
+
+void
+MP3enc::checkPath(string path, Target& t, vector<Job*>& v)
 {
     if (path.size() < 1) {
         cerr << "ERROR: Input file is null" << endl;
@@ -63,9 +281,7 @@ MP3enc::checkPath(string path, vector<AudioData*>& v)
             cerr << "ERROR: Failed to find " << path << endl;
             return;
         }
-        AudioData adata(path, m_opt.outPath);
-        adata.start();
-        adata.join();
+        addJob(path, t, v);
         return;
     }
 
@@ -74,18 +290,16 @@ MP3enc::checkPath(string path, vector<AudioData*>& v)
         switch (dir_ent->d_type) {
         case DT_DIR:
             if (m_opt.recursive && scmp(dir_ent->d_name, ".") && scmp(dir_ent->d_name, "..")) {
-                checkPath(fullPath, v);
+                checkPath(fullPath, t, v);
             }
             break;
         case DT_REG:
             if (is_wav(dir_ent->d_name)) {
-                if (!m_opt.outPath.empty()) {
-                    m_opt.outPath.clear();
+                if (!t.out.empty()) {
+                    t.out.clear();
                     DEBUG::WARN("Output filename(-o) option is ignored in case of decoding directory");
                 }
-                AudioData* adata = new AudioData(fullPath, m_opt.outPath);
-                adata->start();
-                v.push_back(adata);
+                addJob(fullPath, t, v);
             }
             break;
         case DT_LNK:
@@ -109,9 +323,7 @@ MP3enc::checkPath(string path, vector<AudioData*>& v)
     if (data.dwFileAttributes == FILE_ATTRIBUTE_ARCHIVE ||
             data.dwFileAttributes == FILE_ATTRIBUTE_NORMAL)
     {
-        AudioData* adata = new AudioData(path, m_opt.outPath);
-        adata->start();
-        v.push_back(adata);
+        addJob(path, t, v);
         return;
     }
     else if (data.dwFileAttributes == FILE_ATTRIBUTE_DIRECTORY)
@@ -125,20 +337,18 @@ MP3enc::checkPath(string path, vector<AudioData*>& v)
             if ((data.dwFileAttributes == FILE_ATTRIBUTE_ARCHIVE ||
                         data.dwFileAttributes == FILE_ATTRIBUTE_NORMAL) && is_wav(data.cFileName))
             {
-                if (!m_opt.outPath.empty())
+                if (!t.out.empty())
                 {
-                    m_opt.outPath.clear();
+                    t.out.clear();
                     DEBUG::WARN("Output filename(-o) option is ignored in case of decoding directory");
                 }
-                AudioData* adata = new AudioData(fullPath, m_opt.outPath);
-                adata->start();
-                v.push_back(adata);
+                addJob(fullPath, t, v);
             }
             else if (data.dwFileAttributes == FILE_ATTRIBUTE_DIRECTORY &&
                 m_opt.recursive &&
                 scmp(data.cFileName, ".") && scmp(data.cFileName, ".."))
             {
-                checkPath(fullPath, v);
+                checkPath(fullPath, t, v);
             }
         } while (FindNextFileA(hFind, &data));
     }
@@ -170,6 +380,13 @@ MP3enc::parseOption(int argc, char** argv)
             }
             m_opt.outPath = argv[i + 1];
             i++;
+        } else if (!scmp(argv[i], "-j")) {
+            i++;
+            if (i >= argc || atoi(argv[i]) < 1) {
+                cerr << "ERROR: -j needs the number of threads" << endl;
+                return false;
+            }
+            m_opt.workers = atoi(argv[i]);
         } else if (!scmp(argv[i], "-r")) {
             m_opt.recursive = true;
         } else if (!scmp(argv[i], "-q")) {
@@ -192,6 +409,263 @@ MP3enc::parseOption(int argc, char** argv)
                 m_instance->showUsage();
                 return false;
             }
+        } else if (!scmp(argv[i], "--batch") || !scmp(argv[i], "--batch-jobs")) {
+            bool const jobs = !scmp(argv[i], "--batch-jobs");
+            i++;
+            if (i >= argc || atoi(argv[i]) < 1) {
+                cerr << "ERROR: " << argv[i - 1] << " needs a number" << endl;
+                return false;
+            }
+            if (jobs) {
+                m_opt.batchJobs = atoi(argv[i]);
+            } else {
+                m_opt.batch = atoi(argv[i]);
+            }
+        } else if (!scmp(argv[i], "--io")) {
+            i++;
+            if (i >= argc) {
+                cerr << "ERROR: --io needs a mode. Please see below usage:" << endl;
+                m_instance->showUsage();
+                return false;
+            }
+            if (!scmp(argv[i], "direct")) {
+                m_opt.centralIo = false;
+            } else if (!scmp(argv[i], "central")) {
+                m_opt.centralIo = true;
+            } else {
+                cerr << "ERROR: Wrong mode for io. Please see below usage:" << endl;
+                m_instance->showUsage();
+                return false;
+            }
+        } else if (!scmp(argv[i], "--hdd-io") || !scmp(argv[i], "--ssd-io")) {
+            bool const ssd = !scmp(argv[i], "--ssd-io");
+            i++;
+            if (i >= argc || atoi(argv[i]) < 0) {
+                cerr << "ERROR: " << argv[i - 1] << " needs a number" << endl;
+                return false;
+            }
+            if (ssd) {
+                m_opt.ssdIo = atoi(argv[i]);
+            } else {
+                m_opt.hddIo = atoi(argv[i]);
+            }
+        } else if (!scmp(argv[i], "--incremental")) {
+            m_opt.incremental = true;
+        } else if (!scmp(argv[i], "--manifest")) {
+            i++;
+            if (i >= argc) {
+                cerr << "ERROR: --manifest needs a file" << endl;
+                return false;
+            }
+            m_opt.manifest = argv[i];
+        } else if (!scmp(argv[i], "--watch")) {
+            m_opt.watch = true;
+        } else if (!scmp(argv[i], "--settle")) {
+            i++;
+            if (i >= argc || atoi(argv[i]) < 0) {
+                cerr << "ERROR: --settle needs a number" << endl;
+                return false;
+            }
+            m_opt.settleMs = atoi(argv[i]);
+        } else if (!scmp(argv[i], "--daemon") || !scmp(argv[i], "--submit")) {
+            bool const submit = !scmp(argv[i], "--submit");
+            i++;
+            if (i >= argc) {
+                cerr << "ERROR: " << argv[i - 1] << " needs a socket" << endl;
+                return false;
+            }
+            (submit ? m_opt.submit : m_opt.daemon) = argv[i];
+        } else if (!scmp(argv[i], "--priority")) {
+            i++;
+            int p = Job::JP_INTERACTIVE;
+            while (i < argc && p < Job::JP_COUNT && scmp(argv[i], Job::priority_name(p))) {
+                p++;
+            }
+            if (i >= argc || p == Job::JP_COUNT) {
+                cerr << "ERROR: Wrong class for priority. Please see below usage:" << endl;
+                m_instance->showUsage();
+                return false;
+            }
+            m_opt.priority = (Job::PRIORITY)p;
+        } else if (!scmp(argv[i], "--deadline") || !scmp(argv[i], "--aging")) {
+            bool const aging = !scmp(argv[i], "--aging");
+            i++;
+            if (i >= argc || atof(argv[i]) < 0) {
+                cerr << "ERROR: " << argv[i - 1] << " needs a time in seconds" << endl;
+                return false;
+            }
+            (aging ? m_opt.aging : m_opt.deadline) = atof(argv[i]);
+        } else if (!scmp(argv[i], "--journal") || !scmp(argv[i], "--resume")) {
+            m_opt.resume = !scmp(argv[i], "--resume");
+            i++;
+            if (i >= argc) {
+                cerr << "ERROR: " << argv[i - 1] << " needs a file" << endl;
+                return false;
+            }
+            m_opt.journal = argv[i];
+        } else if (!scmp(argv[i], "--cache")) {
+            i++;
+            if (i >= argc) {
+                cerr << "ERROR: --cache needs a directory" << endl;
+                return false;
+            }
+            m_opt.cache = argv[i];
+        } else if (!scmp(argv[i], "--cache-size")) {
+            i++;
+            if (i >= argc || atoi(argv[i]) <= 0) {
+                cerr << "ERROR: --cache-size needs a size in MB" << endl;
+                return false;
+            }
+            m_opt.cacheSize = atoi(argv[i]);
+        } else if (!scmp(argv[i], "--dedupe")) {
+            i++;
+            if (i < argc && !scmp(argv[i], "link")) {
+                m_opt.dedupe = Dedupe::DD_LINK;
+            } else if (i < argc && !scmp(argv[i], "reflink")) {
+                m_opt.dedupe = Dedupe::DD_REFLINK;
+            } else if (i < argc && !scmp(argv[i], "copy")) {
+                m_opt.dedupe = Dedupe::DD_COPY;
+            } else {
+                cerr << "ERROR: --dedupe needs link, reflink or copy" << endl;
+                return false;
+            }
+        } else if (!scmp(argv[i], "--stream")) {
+            StreamHints::set_enabled(true);
+        } else if (!scmp(argv[i], "--output-root")) {
+            i++;
+            if (i >= argc) {
+                cerr << "ERROR: --output-root needs a directory" << endl;
+                return false;
+            }
+            string root = argv[i];
+            if (root.size() > 1 && root.back() == DELIMITER) {
+                root.pop_back();
+            }
+            m_opt.outputRoots.push_back(root);
+        } else if (!scmp(argv[i], "--prefetch") || !scmp(argv[i], "--read-chunk")) {
+            bool const chunk = !scmp(argv[i], "--read-chunk");
+            i++;
+            if (i >= argc || atoi(argv[i]) < (chunk ? 1 : 0)) {
+                cerr << "ERROR: " << argv[i - 1] << " needs a number" << endl;
+                return false;
+            }
+            if (chunk) {
+                m_opt.readChunk = atoi(argv[i]);
+            } else {
+                m_opt.prefetch = atoi(argv[i]);
+            }
+        } else if (!scmp(argv[i], "--buffer") || !scmp(argv[i], "--hold")) {
+            bool const hold = !scmp(argv[i], "--hold");
+            i++;
+            if (i >= argc || atoi(argv[i]) < (hold ? 0 : 1)) {
+                cerr << "ERROR: " << argv[i - 1] << " needs size in KB" << endl;
+                return false;
+            }
+            if (hold) {
+                OutputWriter::set_hold_limit((size_t)atoi(argv[i]) << 10);
+            } else {
+                OutputWriter::set_buffer_size((size_t)atoi(argv[i]) << 10);
+            }
+        } else if (!scmp(argv[i], "--cpu") || !scmp(argv[i], "--nice") || !scmp(argv[i], "--ionice") ||
+                !scmp(argv[i], "--read-rate") || !scmp(argv[i], "--write-rate")) {
+            i++;
+            if (i >= argc || !Governor::instance().set(argv[i - 1] + 2, argv[i])) {
+                cerr << "ERROR: Wrong value for " << argv[i - 1] << ". Please see below usage:" << endl;
+                m_instance->showUsage();
+                return false;
+            }
+        } else if (!scmp(argv[i], "--control")) {
+            i++;
+            if (i >= argc) {
+                cerr << "ERROR: --control needs a file" << endl;
+                return false;
+            }
+            m_opt.control = argv[i];
+        } else if (!scmp(argv[i], "--adaptive")) {
+            i++;
+            if (i >= argc || atof(argv[i]) <= 0) {
+                cerr << "ERROR: --adaptive needs a window in seconds" << endl;
+                return false;
+            }
+            m_opt.adaptive = atof(argv[i]);
+        } else if (!scmp(argv[i], "--trace")) {
+            i++;
+            if (i >= argc) {
+                cerr << "ERROR: --trace needs a file" << endl;
+                return false;
+            }
+            m_opt.trace = argv[i];
+        } else if (!scmp(argv[i], "--plan")) {
+            m_opt.plan = true;
+        } else if (!scmp(argv[i], "--pin")) {
+            i++;
+            if (i < argc && !scmp(argv[i], "cpu")) {
+                m_opt.pin = Topology::PIN_CPU;
+            } else if (i < argc && !scmp(argv[i], "node")) {
+                m_opt.pin = Topology::PIN_NODE;
+            } else {
+                cerr << "ERROR: Wrong mode for --pin. Please see below usage:" << endl;
+                m_instance->showUsage();
+                return false;
+            }
+        } else if (!scmp(argv[i], "--max-memory")) {
+            i++;
+            if (i >= argc || atoi(argv[i]) < 1) {
+                cerr << "ERROR: --max-memory needs size in MB" << endl;
+                return false;
+            }
+            m_opt.maxMemory = atoi(argv[i]);
+        } else if (!scmp(argv[i], "--cancel-timeout")) {
+            i++;
+            if (i >= argc || atof(argv[i]) < 0) {
+                cerr << "ERROR: --cancel-timeout needs time in seconds" << endl;
+                return false;
+            }
+            Cancel::set_deadline(atof(argv[i]));
+        } else if (!scmp(argv[i], "--watchdog") || !scmp(argv[i], "--watchdog-min")) {
+            bool const min = !scmp(argv[i], "--watchdog-min");
+            i++;
+            if (i >= argc || atof(argv[i]) < 0) {
+                cerr << "ERROR: " << argv[i - 1] << " needs a number" << endl;
+                return false;
+            }
+            if (min) {
+                m_opt.watchdogMin = atof(argv[i]);
+            } else {
+                m_opt.watchdog = atof(argv[i]);
+            }
+        } else if (!scmp(argv[i], "--abandon")) {
+            m_opt.abandon = true;
+        } else if (!scmp(argv[i], "--sync")) {
+            i++;
+            if (i >= argc) {
+                cerr << "ERROR: --sync needs a mode. Please see below usage:" << endl;
+                m_instance->showUsage();
+                return false;
+            }
+            if (!scmp(argv[i], "none")) {
+                m_opt.sync = OutputWriter::SYNC_NONE;
+            } else if (!scmp(argv[i], "file")) {
+                m_opt.sync = OutputWriter::SYNC_FILE;
+            } else if (!scmp(argv[i], "group")) {
+                m_opt.sync = OutputWriter::SYNC_GROUP;
+            } else {
+                cerr << "ERROR: Wrong mode for sync. Please see below usage:" << endl;
+                m_instance->showUsage();
+                return false;
+            }
+        } else if (!scmp(argv[i], "--sync-files") || !scmp(argv[i], "--sync-ms")) {
+            bool const ms = !scmp(argv[i], "--sync-ms");
+            i++;
+            if (i >= argc || atoi(argv[i]) < (ms ? 0 : 1)) {
+                cerr << "ERROR: " << argv[i - 1] << " needs a number" << endl;
+                return false;
+            }
+            if (ms) {
+                m_opt.syncMs = atoi(argv[i]);
+            } else {
+                m_opt.syncFiles = atoi(argv[i]);
+            }
         } else if (!scmp(argv[i], "-v")) {
             m_opt.verbose = true;
             DEBUG::SET();
@@ -199,16 +673,293 @@ MP3enc::parseOption(int argc, char** argv)
             m_opt.inPath = argv[i];
         }
     }
-    vector<AudioData*> filelist = {};
-    checkPath(m_opt.inPath, filelist);
-    for (AudioData* d : filelist) {
-        d->join();
-        delete d;
+    if (!m_opt.submit.empty()) {
+        return Daemon::client(m_opt.submit, m_opt.inPath, m_opt.outPath, m_opt.priority, m_opt.deadline);
+    }
+    if (!m_opt.workers) {
+        m_opt.workers = WorkerPool::default_workers();
+    }
+    if (m_opt.watch && m_opt.plan) {
+        cerr << "ERROR: --plan needs the whole batch up front and cannot be used with --watch" << endl;
+        return false;
+    }
+    if (m_opt.watch && (!m_opt.journal.empty() || m_opt.dedupe != Dedupe::DD_NONE || !m_opt.cache.empty() ||
+            !m_opt.manifest.empty())) {
+        /* these finish their work at the end of a batch, which a watch reaches only when interrupted */
+        cerr << "ERROR: --watch cannot be used with --journal, --resume, --dedupe, --cache or --manifest" << endl;
+        return false;
+    }
+    if (!m_opt.daemon.empty() && (m_opt.plan || m_opt.watch || !m_opt.journal.empty() ||
+            m_opt.dedupe != Dedupe::DD_NONE || !m_opt.cache.empty() || !m_opt.manifest.empty())) {
+        /* these finish their work at the end of a batch, which a daemon never reaches */
+        cerr << "ERROR: --daemon cannot be used with --plan, --watch, --journal, --resume, --dedupe, "
+            "--cache or --manifest" << endl;
+        return false;
+    }
+    if (m_opt.verbose) {
+        string msg = Topology::instance().describe();
+        DEBUG::INFO(msg.c_str());
+    }
+    OutputWriter::set_sync_policy(m_opt.sync, m_opt.syncFiles, m_opt.syncMs / 1000.0);
+    if (m_opt.batch) {
+        /* an output is smaller than its input, so batched outputs need one write and no LAME-tag seek */
+        OutputWriter::set_hold_limit(max(OutputWriter::get_hold_limit(), m_opt.batch << 10));
+    }
+    if (!m_opt.trace.empty() && !Trace::instance().open(m_opt.trace)) {
+        cerr << "ERROR: could not write trace file " << m_opt.trace << endl;
+        return false;
+    }
+    if (!m_opt.manifest.empty() && !m_manifest.load(m_opt.manifest)) {
+        cerr << "ERROR: could not read manifest " << m_opt.manifest << endl;
+        return false;
+    }
+    if (!m_opt.journal.empty() && !Journal::instance().open(m_opt.journal, m_opt.resume)) {
+        cerr << "ERROR: could not open journal " << m_opt.journal << endl;
+        return false;
+    }
+    /* watch before the first walk so that no input arriving in between is missed */
+    Watcher watcher(m_opt.recursive, m_opt.settleMs / 1000.0);
+    if (m_opt.watch && !watcher.open(m_opt.inPath)) {
+        return false;
+    }
+    Daemon daemon([this](const string& in, const string& out, Job::PRIORITY priority, double deadline,
+            vector<Job*>& v) {
+        Target t = { out, priority, deadline };
+        checkPath(in, t, v);
+    });
+    if (!m_opt.daemon.empty() && !daemon.listen(m_opt.daemon)) {
+        return false;
+    }
+    Cancel::install();
+    Governor::instance().start(m_opt.control);
+    Storage::instance().configure(m_opt.hddIo, m_opt.ssdIo);
+    if (m_opt.centralIo) {
+        /* a few chunks ahead of each encoder, the first 4 chunks of each prefetched input */
+        Reader::instance().configure(m_opt.readChunk << 10, 4, m_opt.prefetch ? (m_opt.readChunk << 12) : 0);
+        Reader::instance().start();
+    }
+    m_pool = new WorkerPool(m_opt.workers);
+    m_pool->set_watchdog(m_opt.watchdog, m_opt.watchdogMin, m_opt.abandon);
+    m_pool->set_memory_budget(m_opt.maxMemory << 20);
+    m_pool->set_pinning(m_opt.pin);
+    m_pool->set_adaptive(m_opt.adaptive);
+    m_pool->set_batching(m_opt.batch << 10, m_opt.batchJobs);
+    m_pool->set_prefetch(m_opt.prefetch);
+    m_pool->set_aging(m_opt.aging);
+    m_pool->set_warm(!m_opt.daemon.empty());
+    m_pool->start();
+    if (m_opt.plan) {
+        m_planner = new Planner(m_opt.workers);
+    }
+    if (m_opt.dedupe != Dedupe::DD_NONE) {
+        m_dedupe = new Dedupe(m_opt.dedupe);
+    }
+    if (!m_opt.cache.empty()) {
+        m_cache = new Cache();
+        if (!m_cache->open(m_opt.cache, m_opt.cacheSize << 20)) {
+            delete m_cache;
+            m_cache = nullptr;
+        }
     }
 
+    vector<Job*> joblist = {};
+    if (!m_opt.daemon.empty()) {
+        daemon.serve(*m_pool, joblist);
+    } else if (m_opt.resume) {
+        vector<pair<string, string> > const pending = Journal::instance().pending();
+        for (const pair<string, string>& p : pending) {
+            Target const t = { p.second, m_opt.priority, m_opt.deadline };
+            addJob(p.first, t, joblist);
+        }
+    } else {
+        Target t = { m_opt.outPath, m_opt.priority, m_opt.deadline };
+        checkPath(m_opt.inPath, t, joblist);
+    }
+    if (m_opt.watch) {
+        Target const t = { "", m_opt.priority, m_opt.deadline };
+        cout << "Watching " << m_opt.inPath << " for new inputs" << endl;
+        while (!Cancel::requested()) {
+            vector<string> const ready = watcher.wait(0.5);
+            for (const string& in : ready) {
+                addJob(in, t, joblist);
+            }
+            retire(joblist);
+        }
+        cout << watcher.report() << endl;
+    }
+    if (m_planner) {
+        m_planner->submit(*m_pool, joblist);
+    }
+    m_pool->finish();
+    Reader::instance().stop();
+    Governor::instance().stop();
+    OutputWriter::finish();
+    unordered_map<string, bool> const done = completed(joblist);
+    vector<string> made = {};
+    if (m_dedupe) {
+        if (!Cancel::requested()) {
+            made = m_dedupe->produce(done);
+            for (const string& m : made) {
+                if (Journal::instance().is_open()) {
+                    Journal::instance().done(m);
+                }
+            }
+            /* copies of duplicates are synced like any output */
+            OutputWriter::finish();
+        }
+        cout << m_dedupe->report() << endl;
+        delete m_dedupe;
+        m_dedupe = nullptr;
+    }
+    if (m_cache) {
+        if (!Cancel::requested()) {
+            for (unordered_map<string, Cache::Key>::const_iterator it = m_keys.begin(); it != m_keys.end(); ++it) {
+                unordered_map<string, bool>::const_iterator d = done.find(it->first);
+                if (d != done.end() && d->second) {
+                    m_cache->store(it->second, it->first);
+                }
+            }
+            OutputWriter::finish();
+        }
+        cout << m_cache->report() << endl;
+        delete m_cache;
+        m_cache = nullptr;
+    }
+    made.insert(made.end(), m_cached.begin(), m_cached.end());
+    if (m_opt.resume) {
+        cout << Journal::instance().report() << endl;
+    }
+    Journal::instance().close();
+    if (!m_opt.manifest.empty()) {
+        updateManifest(done, made);
+    }
+    if (m_opt.incremental) {
+        cout << "Incremental: " << m_skipped << " up-to-date input(s) skipped, " << (retired() + joblist.size()) <<
+            " job(s) run" << endl;
+    }
+    if (m_opt.maxMemory) {
+        reportMemory(joblist);
+    }
+    if (m_opt.adaptive > 0) {
+        cout << m_pool->controller_report() << endl;
+    }
+    if (m_planner) {
+        cout << m_planner->report(joblist) << endl;
+    }
+    if (m_opt.batch || m_opt.verbose) {
+        cout << m_pool->dispatch_report() << endl;
+    }
+    string const priorities = m_pool->priority_report();
+    if (!priorities.empty()) {
+        cout << priorities << endl;
+    }
+    if (m_opt.centralIo && m_opt.verbose) {
+        cout << Reader::instance().report() << endl;
+    }
+    if (m_opt.verbose) {
+        cout << Storage::instance().report() << endl;
+    }
+    Trace::instance().close();
+    /* a thread blocked in an abandoned job uses the pool and its job when it wakes up */
+    bool const stranded = m_pool->stranded() > 0;
+    if (!stranded) {
+        delete m_pool;
+    }
+    m_pool = nullptr;
+
+    if (Cancel::requested()) {
+        report(joblist);
+    }
+    if (!stranded) {
+        for (Job* j : joblist) {
+            delete j;
+        }
+        delete m_planner;
+    }
+    m_planner = nullptr;
+
     return true;
 }
 
+void
+MP3enc::report(const vector<Job*>& v)
+{
+    size_t count[Job::JS_CANCELED + 1] = {};
+
+    cout << "Canceled by signal " << Cancel::signal() << ", completed outputs:" << endl;
+    for (const Job* j : v) {
+        Job::STATE state = j->state;
+        if (j->segment > 0) {
+            continue;
+        }
+        /* a split file counts once, done only if all of its segments are */
+        for (size_t i = 0; j->split && i < v.size(); i++) {
+            if (v[i]->split == j->split && v[i]->state != Job::JS_DONE) {
+                state = v[i]->state;
+            }
+        }
+        count[state]++;
+        if (state == Job::JS_DONE) {
+            cout << "   " << j->inPath << endl;
+        }
+    }
+    if (retired()) {
+        cout << "   and " << m_retired[Job::JS_DONE] << " output(s) completed earlier while watching" << endl;
+    }
+    for (size_t s = 0; s <= Job::JS_CANCELED; s++) {
+        count[s] += m_retired[s];
+    }
+    cout << count[Job::JS_DONE] << " done, " << count[Job::JS_FAILED] << " failed, " <<
+        count[Job::JS_CANCELED] << " canceled" << endl;
+}
+
+void
+MP3enc::retire(vector<Job*>& v)
+{
+    vector<Job*> finished;
+
+    m_pool->take_finished(v, finished);
+    for (Job* j : finished) {
+        m_retired[j->state]++;
+        delete j;
+    }
+}
+
+size_t
+MP3enc::retired() const
+{
+    size_t n = 0;
+
+    for (size_t s = 0; s <= Job::JS_CANCELED; s++) {
+        n += m_retired[s];
+    }
+
+    return n;
+}
+
+void
+MP3enc::reportMemory(const vector<Job*>& v)
+{
+    const Job* largest = nullptr;
+
+    for (const Job* j : v) {
+        if (!largest || j->memUsed > largest->memUsed) {
+            largest = j;
+        }
+        if (m_opt.verbose && j->state == Job::JS_DONE) {
+            cout << "   " << j->inPath << ": " << (j->memUsed >> 10) << "KB used, " <<
+                (j->memEstimate >> 10) << "KB estimated" << endl;
+        }
+    }
+    cout << "Memory budget " << m_opt.maxMemory << "MB: at most " << (m_pool->memory_peak() >> 10) <<
+        "KB admitted at once";
+    if (largest) {
+        cout << ", largest job used " << (largest->memUsed >> 10) << "KB of " <<
+            (largest->memEstimate >> 10) << "KB estimated";
+    }
+    cout << endl;
+}
+
 void
 MP3enc::freeInstance()
 {
@@ -268,7 +1019,7 @@ MP3enc::main(int argc, char** argv)
     double elapsed = (double)t / CLOCKS_PER_SEC;
     cout << "elapsed " << fixed << elapsed << "s" << endl;
 
-    return 0;
+    return Cancel::requested() ? 128 + Cancel::signal() : 0;
 }
 
 int main(int argc, char** argv)
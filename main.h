@@ -11,8 +11,17 @@
 
 #include "common.h"
 #include "audio.h"
+#include "pool.h"
+#include "planner.h"
+#include "manifest.h"
+#include "dedupe.h"
+#include "cache.h"
+#include "watch.h"
+#include "daemon.h"
 #include "utils.h"
 
+#include <unordered_map>
+
 /**
  * @class   MP3enc main.h "main.h"
  * @brief   main class for MP3enc application.
@@ -46,15 +55,211 @@ private:
          * @var     bool        recursive
          * @brief   Flag if to search for sub directories, delivered through -r option.
          */
-        bool        recursive;
+        bool        recursive = false;
         /**
          * @var     bool        verbose
          * @brief   Flag to show debug messages, delivered through -v option.
          */
-        bool        verbose;
+        bool        verbose = false;
+        /**
+         * @var     size_t      workers
+         * @brief   Number of encoding threads delivered through -j option. 0 for default.
+         */
+        size_t      workers = 0;
+        /**
+         * @var     OutputWriter::SYNC_POLICY   sync
+         * @brief   Durability of outputs delivered through --sync option.
+         */
+        OutputWriter::SYNC_POLICY   sync = OutputWriter::SYNC_NONE;
+        /**
+         * @var     size_t      syncFiles
+         * @brief   Number of outputs synced together, delivered through --sync-files option.
+         */
+        size_t      syncFiles = 32;
+        /**
+         * @var     int         syncMs
+         * @brief   Longest time an output waits for its group sync, delivered through --sync-ms option.
+         */
+        int         syncMs = 1000;
+        /**
+         * @var     double      watchdog
+         * @brief   Multiple of the expected duration after which a running job is reported,
+         *          delivered through --watchdog option. 0 to disable.
+         */
+        double      watchdog = 0;
+        /**
+         * @var     double      watchdogMin
+         * @brief   Shortest time a job may run before it is reported, delivered through --watchdog-min option.
+         */
+        double      watchdogMin = 30;
+        /**
+         * @var     bool        abandon
+         * @brief   Flag if to give up reported jobs and continue, delivered through --abandon option.
+         */
+        bool        abandon = false;
+        /**
+         * @var     size_t      maxMemory
+         * @brief   Memory budget of the running jobs in MB delivered through --max-memory option. 0 for no limit.
+         */
+        size_t      maxMemory = 0;
+        /**
+         * @var     std::string control
+         * @brief   Resource governor control file delivered through --control option.
+         */
+        std::string control;
+        /**
+         * @var     Topology::PIN_MODE  pin
+         * @brief   Binding of workers to processors delivered through --pin option.
+         */
+        Topology::PIN_MODE  pin = Topology::PIN_NONE;
+        /**
+         * @var     double      adaptive
+         * @brief   Window of the concurrency controller in seconds delivered through --adaptive option.
+         *          0 to keep every worker busy.
+         */
+        double      adaptive = 0;
+        /**
+         * @var     std::string trace
+         * @brief   Trace file of scheduling events delivered through --trace option.
+         */
+        std::string trace;
+        /**
+         * @var     bool        plan
+         * @brief   Flag if to plan the whole batch before encoding, delivered through --plan option.
+         */
+        bool        plan = false;
+        /**
+         * @var     size_t      batch
+         * @brief   Largest input in KB encoded in batches, delivered through --batch option. 0 to disable.
+         */
+        size_t      batch = 0;
+        /**
+         * @var     size_t      batchJobs
+         * @brief   Most jobs in a batch, delivered through --batch-jobs option.
+         */
+        size_t      batchJobs = 16;
+        /**
+         * @var     bool        centralIo
+         * @brief   Flag if to read every input from one reader thread, delivered through --io option.
+         */
+        bool        centralIo = false;
+        /**
+         * @var     size_t      prefetch
+         * @brief   Number of queued jobs prefetched by the reader thread, delivered through --prefetch option.
+         */
+        size_t      prefetch = 2;
+        /**
+         * @var     size_t      readChunk
+         * @brief   Size in KB of a read of the reader thread, delivered through --read-chunk option.
+         */
+        size_t      readChunk = 1024;
+        /**
+         * @var     size_t      hddIo
+         * @brief   I/O in flight allowed on each rotational device, delivered through --hdd-io option.
+         *          0 for no limit.
+         */
+        size_t      hddIo = 2;
+        /**
+         * @var     size_t      ssdIo
+         * @brief   I/O in flight allowed on each other device, delivered through --ssd-io option.
+         *          0 for the depth of its queue.
+         */
+        size_t      ssdIo = 0;
+        /**
+         * @var     std::vector<std::string> outputRoots
+         * @brief   Directories the outputs are spread over by input path, delivered through --output-root options.
+         */
+        std::vector<std::string> outputRoots;
+        /**
+         * @var     bool        incremental
+         * @brief   Flag if to skip inputs whose output is up to date, delivered through --incremental option.
+         */
+        bool        incremental = false;
+        /**
+         * @var     std::string manifest
+         * @brief   Manifest of the encoded outputs delivered through --manifest option.
+         */
+        std::string manifest;
+        /**
+         * @var     Dedupe::MODE dedupe
+         * @brief   How outputs of identical inputs are made, delivered through --dedupe option.
+         */
+        Dedupe::MODE dedupe = Dedupe::DD_NONE;
+        /**
+         * @var     std::string cache
+         * @brief   Directory of the encode cache delivered through --cache option.
+         */
+        std::string cache;
+        /**
+         * @var     size_t      cacheSize
+         * @brief   Size of the encode cache in MB, delivered through --cache-size option.
+         */
+        size_t      cacheSize = 1024;
+        /**
+         * @var     std::string journal
+         * @brief   Journal of the batch delivered through --journal or --resume option.
+         */
+        std::string journal;
+        /**
+         * @var     bool        resume
+         * @brief   Flag if to encode what the journal left incomplete instead of the input path,
+         *          delivered through --resume option.
+         */
+        bool        resume = false;
+        /**
+         * @var     bool        watch
+         * @brief   Flag if to keep encoding inputs as they arrive in the input directory,
+         *          delivered through --watch option.
+         */
+        bool        watch = false;
+        /**
+         * @var     size_t      settleMs
+         * @brief   Milliseconds an arriving input shall stay untouched before it is encoded,
+         *          delivered through --settle option.
+         */
+        size_t      settleMs = 500;
+        /**
+         * @var     string      daemon
+         * @brief   Socket to serve encode requests on instead of encoding the input path,
+         *          delivered through --daemon option.
+         */
+        std::string daemon;
+        /**
+         * @var     string      submit
+         * @brief   Socket of a daemon to encode the input path with, delivered through --submit option.
+         */
+        std::string submit;
+        /**
+         * @var     Job::PRIORITY priority
+         * @brief   Class the jobs are scheduled in, delivered through --priority option.
+         */
+        Job::PRIORITY priority = Job::JP_NORMAL;
+        /**
+         * @var     double      deadline
+         * @brief   Seconds after submission every job shall be finished by, delivered through
+         *          --deadline option. 0 for none.
+         */
+        double      deadline = 0;
+        /**
+         * @var     double      aging
+         * @brief   Seconds a bulk job waits before it is scheduled as a normal one,
+         *          delivered through --aging option. 0 to disable.
+         */
+        double      aging = 60;
+    };
+    /**
+     * @struct  Target
+     * @brief   Output, class and deadline of the inputs of one submission, the command line
+     *          or a daemon request.
+     */
+    struct Target {
+        std::string     out;        /**< output path, empty for the default */
+        Job::PRIORITY   priority;   /**< class the jobs are scheduled in */
+        double          deadline;   /**< seconds after submission the jobs shall be finished by, 0 for none */
     };
 
-    MP3enc() : m_opt{ {}, {}, false, false } {}
+    MP3enc() : m_opt{}, m_pool(nullptr), m_planner(nullptr), m_manifest{}, m_stamps{}, m_skipped(0),
+                m_dedupe(nullptr), m_cache(nullptr), m_keys{}, m_cached{}, m_retired{} {}
     virtual ~MP3enc() {}
 
     /**
@@ -66,13 +271,73 @@ private:
      */
     bool parseOption(int argc, char** argv);
     /**
-     * @fn      void checkPath(string path)
+     * @fn      void checkPath(string path, Target& t, std::vector<Job*>& v)
      * @brief   A function to process input path. This can handle both single file and a directory.
+     *          Every wav file found is appended to v and submitted to the worker pool.
      * @param [in]  path    input path
+     * @param [in,out] t    output, class and deadline of the jobs. The output is cleared for a directory
+     * @param [out] v       list of jobs created
+     */
+    void checkPath(std::string path, Target& t, std::vector<Job*>& v);
+    /**
+     * @fn      void addJob(const std::string& in, const Target& t, std::vector<Job*>& v)
+     * @brief   A function to create a job and submit it to the worker pool, or hand it to
+     *          the planner with --plan.
+     */
+    void addJob(const std::string& in, const Target& t, std::vector<Job*>& v);
+    /**
+     * @fn      std::string outputUnderRoot(const std::string& in)
+     * @brief   A function to place the output of an input under the --output-root picked by a hash
+     *          of its path relative to the input directory, keeping that path. The same input always
+     *          maps to the same root. Missing directories are created.
+     */
+    std::string outputUnderRoot(const std::string& in);
+    /**
+     * @fn      bool upToDate(const std::string& in, const std::string& out)
+     * @brief   A function to tell from the file times and sizes alone whether the output of
+     *          an input is newer than the input and, with --manifest, was encoded from the same
+     *          input with the current settings.
+     */
+    bool upToDate(const std::string& in, const std::string& out);
+    /**
+     * @fn      std::unordered_map<std::string, bool> completed(const std::vector<Job*>& v)
+     * @brief   A function to tell for every output of the jobs whether all its jobs are done.
+     */
+    std::unordered_map<std::string, bool> completed(const std::vector<Job*>& v);
+    /**
+     * @fn      void updateManifest(const std::unordered_map<std::string, bool>& done, const std::vector<std::string>& made)
+     * @brief   A function to record the outputs completed in this run into the manifest,
+     *          along with the outputs made for duplicate inputs.
+     */
+    void updateManifest(const std::unordered_map<std::string, bool>& done, const std::vector<std::string>& made);
+    /**
+     * @fn      void report(const std::vector<Job*>& v)
+     * @brief   A function to list the jobs completed before cancellation.
+     */
+    void report(const std::vector<Job*>& v);
+    /**
+     * @fn      void reportMemory(const std::vector<Job*>& v)
+     * @brief   A function to show the memory accounted against the --max-memory budget.
+     */
+    void reportMemory(const std::vector<Job*>& v);
+    /**
+     * @fn      void retire(std::vector<Job*>& v)
+     * @brief   A function to count and free the finished jobs of v, so that --watch runs in bounded memory.
      */
-    void checkPath(std::string path, std::vector<AudioData*>& v);
+    void retire(std::vector<Job*>& v);
+    size_t retired() const;     /**< number of jobs freed by retire() */
 
     Options         m_opt;          /**< input arguments */
+    WorkerPool*     m_pool;         /**< pool of encoding threads */
+    Planner*        m_planner;      /**< planner of the batch, nullptr without --plan */
+    Manifest        m_manifest;     /**< outputs of previous runs, loaded with --manifest */
+    std::unordered_map<std::string, Manifest::Entry> m_stamps; /**< inputs of the jobs by output */
+    size_t          m_skipped;      /**< inputs skipped as up to date */
+    Dedupe*         m_dedupe;       /**< finder of duplicate inputs, nullptr without --dedupe */
+    Cache*          m_cache;        /**< encode cache, nullptr without --cache */
+    std::unordered_map<std::string, Cache::Key> m_keys; /**< cache keys of the outputs encoded */
+    std::vector<std::string> m_cached;  /**< outputs made from the cache */
+    size_t          m_retired[Job::JS_CANCELED + 1];    /**< jobs freed by retire(), by state */
     static MP3enc*  m_instance;     /**< pointer to the instance */
     static size_t   refCnt;         /**< reference counter to the instance */
 };
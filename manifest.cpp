@@ -0,0 +1,119 @@
+/**
+ * @file        manifest.cpp
+ * @version     1.0
+ * @brief       MP3enc_cpp output manifest source
+ * @date        Oct 18, 2026
+ * @author      Siwon Kang (kkangshawn@gmail.com)
+ */
+
+#include "manifest.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+using namespace std;
+
+static const char* const MANIFEST_HEADER = "# MP3enc_cpp manifest 1";
+
+bool
+Manifest::stamp(const string& path, double& size, long long& mtime)
+{
+    struct stat st;
+
+    if (stat(path.c_str(), &st) != 0) {
+        return false;
+    }
+    size = (double)st.st_size;
+#if defined __linux
+    mtime = (long long)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+#else
+    mtime = (long long)st.st_mtime * 1000000000LL;
+#endif
+
+    return true;
+}
+
+bool
+Manifest::load(const string& path)
+{
+    ifstream in(path);
+    string line;
+
+    m_path = path;
+    m_entries.clear();
+    m_changed = false;
+    if (!in.is_open()) {
+        double size;
+        long long mtime;
+        /* not written yet by a first run */
+        return !stamp(path, size, mtime);
+    }
+    if (!getline(in, line) || line != MANIFEST_HEADER) {
+        cerr << "ERROR: " << path << " is not a manifest of this encoder" << endl;
+        return false;
+    }
+    while (getline(in, line)) {
+        istringstream ls(line);
+        string size, mtime;
+        Entry e;
+        string output;
+        if (getline(ls, size, '\t') && getline(ls, mtime, '\t') && getline(ls, e.settings, '\t') &&
+                getline(ls, output) && !output.empty()) {
+            e.size = atof(size.c_str());
+            e.mtime = atoll(mtime.c_str());
+            m_entries[output] = e;
+        }
+    }
+
+    return !in.bad();
+}
+
+bool
+Manifest::matches(const string& output, const Entry& e) const
+{
+    unordered_map<string, Entry>::const_iterator it = m_entries.find(output);
+
+    return it != m_entries.end() && it->second.size == e.size && it->second.mtime == e.mtime &&
+        it->second.settings == e.settings;
+}
+
+void
+Manifest::set(const string& output, const Entry& e)
+{
+    m_entries[output] = e;
+    m_changed = true;
+}
+
+bool
+Manifest::save()
+{
+    if (!m_changed) {
+        return true;
+    }
+    string const tmp = m_path + ".tmp";
+    {
+        ofstream out(tmp, ios::trunc);
+        out << MANIFEST_HEADER << '\n';
+        for (unordered_map<string, Entry>::const_iterator it = m_entries.begin(); it != m_entries.end(); ++it) {
+            out << (unsigned long long)it->second.size << '\t' << it->second.mtime << '\t' <<
+                it->second.settings << '\t' << it->first << '\n';
+        }
+        out.flush();
+        if (!out.good()) {
+            remove(tmp.c_str());
+            return false;
+        }
+    }
+#if defined _WIN32
+    remove(m_path.c_str());
+#endif
+    if (rename(tmp.c_str(), m_path.c_str()) != 0) {
+        remove(tmp.c_str());
+        return false;
+    }
+    m_changed = false;
+
+    return true;
+}
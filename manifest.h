@@ -0,0 +1,71 @@
+/**
+ * @file        manifest.h
+ * @version     1.0
+ * @brief       MP3enc_cpp output manifest header
+ * @date        Oct 18, 2026
+ * @author      Siwon Kang (kkangshawn@gmail.com)
+ */
+
+#ifndef _MANIFEST_H
+#define _MANIFEST_H
+
+#include "common.h"
+#include "utils.h"
+
+#include <string>
+#include <unordered_map>
+
+/**
+ * @class   Manifest manifest.h "manifest.h"
+ * @brief   Record of the outputs encoded by previous runs, used by --incremental.
+ *          For every output it keeps the size and modification time its input had and
+ *          the encoder settings used, one tab separated line per output.
+ *          The file is replaced atomically by save().
+ */
+class Manifest : public Utils, DEBUG {
+public:
+    /**
+     * @struct  Entry
+     * @brief   What an output was encoded from.
+     */
+    struct Entry {
+        double          size;       /**< input size in bytes */
+        long long       mtime;      /**< input modification time in nanoseconds */
+        std::string     settings;   /**< encoder settings, see AudioData::settings_name() */
+    };
+
+    Manifest() : m_path{}, m_entries{}, m_changed(false) {}
+
+    /**
+     * @fn      static bool stamp(const std::string& path, double& size, long long& mtime)
+     * @brief   get the size and modification time of a file without opening it.
+     * @return  false if the file does not exist
+     */
+    static bool     stamp(const std::string& path, double& size, long long& mtime);
+
+    /**
+     * @fn      bool load(const std::string& path)
+     * @brief   read the manifest. A missing file is an empty manifest.
+     * @return  false if the file exists and could not be read
+     */
+    bool            load(const std::string& path);
+    /**
+     * @fn      bool matches(const std::string& output, const Entry& e) const
+     * @brief   tell whether the output was encoded from the same input with the same settings.
+     */
+    bool            matches(const std::string& output, const Entry& e) const;
+    void            set(const std::string& output, const Entry& e);     /**< record an encoded output */
+    /**
+     * @fn      bool save()
+     * @brief   write the manifest back if anything was recorded.
+     * @return  false on write error
+     */
+    bool            save();
+
+private:
+    std::string                             m_path;     /**< manifest file */
+    std::unordered_map<std::string, Entry>  m_entries;  /**< entries by output path */
+    bool                                    m_changed;  /**< set() was called since load() */
+};
+
+#endif  /* _MANIFEST_H */
@@ -0,0 +1,230 @@
+/**
+ * @file        planner.cpp
+ * @version     1.0
+ * @brief       MP3enc_cpp batch planner source
+ * @date        Oct 18, 2026
+ * @author      Siwon Kang (kkangshawn@gmail.com)
+ */
+
+#include "planner.h"
+#include "audio.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <sstream>
+using namespace std;
+
+/* seconds of audio a job costs on top of its audio for opening the files and the encoder */
+static const double JOB_COST = 0.1;
+/* shortest segment worth a job of its own, in seconds of audio */
+static const double MIN_SEGMENT = 10;
+/* 16-bit stereo at 44.1kHz, assumed for inputs without a usable header */
+static const double CD_BYTES_PER_SECOND = 44100 * 4;
+
+Planner::~Planner()
+{
+    for (SegmentSet* s : m_splits) {
+        delete s;
+    }
+}
+
+void
+Planner::add(Job* job)
+{
+    Entry e = { job, 0, 0, 0, false, 1 };
+    int rate = 0;
+    double const size = get_file_size(job->inPath.c_str());
+
+    /* a pipe has no size and would block here until written */
+    if (size > 0 && AudioData::probe(job->inPath, e.samples, rate, e.splittable) && e.samples > 0 && rate > 0) {
+        e.seconds = (double)e.samples / rate;
+        e.overhead = (double)(AudioData::SEGMENT_PREROLL + AudioData::SEGMENT_TAIL) *
+            AudioData::SAMPLE_SIZE / rate;
+    } else {
+        e.seconds = max(size, 0.0) / CD_BYTES_PER_SECOND;
+        e.splittable = false;
+    }
+    m_entries.push_back(e);
+}
+
+double
+Planner::makespan(vector<double> costs) const
+{
+    priority_queue<double, vector<double>, greater<double> > loads;
+    double longest = 0;
+
+    /* longest processing time first, each to the least loaded worker */
+    sort(costs.begin(), costs.end(), greater<double>());
+    for (size_t i = 0; i < m_workers; i++) {
+        loads.push(0);
+    }
+    for (double c : costs) {
+        double const load = loads.top() + c;
+        loads.pop();
+        loads.push(load);
+        longest = max(longest, load);
+    }
+
+    return longest;
+}
+
+double
+Planner::split(double target)
+{
+    vector<double> costs;
+
+    for (Entry& e : m_entries) {
+        e.segments = 1;
+        if (e.splittable && e.seconds > target) {
+            e.segments = min(m_workers, (size_t)ceil(e.seconds / target));
+        }
+        for (size_t i = 0; i < e.segments; i++) {
+            costs.push_back(e.seconds / e.segments + (i > 0 ? e.overhead : 0) + JOB_COST);
+        }
+    }
+
+    return makespan(costs);
+}
+
+void
+Planner::submit(WorkerPool& pool, vector<Job*>& v)
+{
+    double total = 0;
+
+    for (const Entry& e : m_entries) {
+        total += e.seconds + JOB_COST;
+    }
+    double const whole_makespan = split(INFINITY);
+
+    /*
+     * try segments of an even share of the batch, then of a half, a third... of it,
+     * which pack better around the files encoded whole
+     */
+    double const share = total / m_workers;
+    double best_target = INFINITY;
+    m_makespan = whole_makespan;
+    for (size_t d = 1; d <= m_workers && share / d >= MIN_SEGMENT; d++) {
+        double const m = split(share / d);
+        /* segments are encoded without the bit reservoir, so split only when it pays */
+        if (m < m_makespan) {
+            m_makespan = m;
+            best_target = share / d;
+        }
+    }
+    split(best_target);
+
+    vector<Job*> tasks;
+    size_t files_split = 0;
+    for (Entry& e : m_entries) {
+        if (e.segments == 1) {
+            e.job->predicted = e.seconds + JOB_COST;
+            tasks.push_back(e.job);
+            continue;
+        }
+        unsigned long const frames = (e.samples + AudioData::SAMPLE_SIZE - 1) / AudioData::SAMPLE_SIZE;
+        unsigned long const per = (frames + e.segments - 1) / e.segments * AudioData::SAMPLE_SIZE;
+        size_t const count = (e.samples + per - 1) / per;
+        double const size = get_file_size(e.job->inPath.c_str());
+        SegmentSet* s = new SegmentSet(count);
+
+        m_splits.push_back(s);
+        files_split++;
+        for (size_t i = 0; i < count; i++) {
+            Job* job = e.job;
+            if (i > 0) {
+                job = new Job(v.size(), e.job->inPath, e.job->outPath);
+                job->priority = e.job->priority;
+                job->deadline = e.job->deadline;
+                v.push_back(job);
+            }
+            job->segment = i;
+            job->first = i * per;
+            job->samples = min(per, e.samples - job->first);
+            job->split = s;
+            job->predicted = e.seconds * job->samples / e.samples + (i > 0 ? e.overhead : 0) + JOB_COST;
+            job->memEstimate = AudioData::estimate_memory(size * job->samples / e.samples);
+            tasks.push_back(job);
+        }
+        e.segments = count;
+    }
+    stable_sort(tasks.begin(), tasks.end(), [](const Job* a, const Job* b) {
+        return a->predicted > b->predicted;
+    });
+
+    if (DEBUG::IS_SET()) {
+        ostringstream msg;
+        msg.setf(ios::fixed);
+        msg.precision(1);
+        msg << "Plan: " << m_entries.size() << " files as " << tasks.size() << " jobs on " << m_workers <<
+            " workers, " << files_split << " split, predicted makespan " << m_makespan <<
+            "s of audio (" << whole_makespan << " encoding every file whole)";
+        for (const Entry& e : m_entries) {
+            if (e.segments > 1) {
+                msg << endl << "   " << e.job->inPath << ": " << e.seconds << "s of audio in " <<
+                    e.segments << " segments";
+            }
+        }
+        cout << msg.str() << endl;
+    }
+    if (Trace::instance().is_open()) {
+        ostringstream f;
+        f << "\"files\":" << m_entries.size() << ",\"jobs\":" << tasks.size() << ",\"split\":" << files_split <<
+            ",\"workers\":" << m_workers << ",\"makespan\":" << m_makespan << ",\"whole\":" << whole_makespan;
+        Trace::instance().event("plan", f.str());
+    }
+
+    m_start = monotonic_time();
+    for (Job* job : tasks) {
+        pool.submit(job);
+    }
+}
+
+string
+Planner::report(const vector<Job*>& v)
+{
+    double const wall = monotonic_time() - m_start;
+    double predicted = 0;
+    double actual = 0;
+    size_t n = 0;
+    ostringstream msg;
+
+    for (const Job* j : v) {
+        if (j->state == Job::JS_DONE && j->predicted > 0) {
+            predicted += j->predicted;
+            actual += j->latency();
+            n++;
+        }
+    }
+    if (!n || predicted <= 0) {
+        return "Plan: no planned job finished";
+    }
+
+    /* seconds of encoding per planned second of audio, as measured in this run */
+    double const rate = actual / predicted;
+    double error = 0;
+    msg.setf(ios::fixed);
+    msg.precision(2);
+    for (const Job* j : v) {
+        if (j->state == Job::JS_DONE && j->predicted > 0) {
+            error += fabs(j->latency() - j->predicted * rate);
+            if (DEBUG::IS_SET() && j->split) {
+                msg << "   " << j->inPath << " segment " << j->segment << ": predicted " <<
+                    j->predicted * rate << "s, took " << j->latency() << "s" << endl;
+            }
+        }
+    }
+    msg << "Plan: predicted makespan " << m_makespan * rate << "s, took " << wall << "s, mean job error " <<
+        error / n << "s at " << 1 / rate << "s of audio per second";
+
+    if (Trace::instance().is_open()) {
+        ostringstream f;
+        f << "\"predicted\":" << m_makespan * rate << ",\"actual\":" << wall << ",\"rate\":" << rate <<
+            ",\"error\":" << error / n;
+        Trace::instance().event("plan-result", f.str());
+    }
+
+    return msg.str();
+}
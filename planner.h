@@ -0,0 +1,79 @@
+/**
+ * @file        planner.h
+ * @version     1.0
+ * @brief       MP3enc_cpp batch planner header
+ * @date        Oct 18, 2026
+ * @author      Siwon Kang (kkangshawn@gmail.com)
+ */
+
+#ifndef _PLANNER_H
+#define _PLANNER_H
+
+#include "common.h"
+#include "utils.h"
+#include "job.h"
+#include "pool.h"
+
+#include <string>
+#include <vector>
+
+/**
+ * @class   Planner planner.h "planner.h"
+ * @brief   Plans a whole batch before any job is queued.
+ *          The cost of every file is predicted from the duration in its header. A file longer
+ *          than an even share of the batch is split into segments encoded by several workers
+ *          when that shortens the predicted makespan, all other files are encoded whole.
+ *          Jobs are queued longest first so that the workers finish close together.
+ *          Costs are counted in seconds of audio; the encoding speed measured during the run
+ *          converts them to seconds when predicted and actual times are reported.
+ */
+class Planner : public Utils, DEBUG {
+public:
+    explicit Planner(size_t workers) : m_entries{}, m_splits{}, m_workers(workers < 1 ? 1 : workers),
+                m_makespan(0), m_start(0) {}
+    virtual ~Planner();
+
+    /**
+     * @fn      void add(Job* job)
+     * @brief   read the header of the input of a job to be planned.
+     */
+    void            add(Job* job);
+    /**
+     * @fn      void submit(WorkerPool& pool, std::vector<Job*>& v)
+     * @brief   plan the jobs added so far and queue them to the pool.
+     *          Jobs created for the segments of split files are appended to v.
+     *          The plan is printed in verbose mode and written to the trace.
+     */
+    void            submit(WorkerPool& pool, std::vector<Job*>& v);
+    /**
+     * @fn      std::string report(const std::vector<Job*>& v)
+     * @brief   compare the predicted makespan and job times against the measured ones.
+     *          Shall be called after the pool finished.
+     */
+    std::string     report(const std::vector<Job*>& v);
+
+private:
+    /**
+     * @struct  Entry
+     * @brief   A file to plan.
+     */
+    struct Entry {
+        Job*            job;        /**< job of the whole file */
+        unsigned long   samples;    /**< number of samples, 0 if unknown */
+        double          seconds;    /**< duration, estimated from the file size if unknown */
+        double          overhead;   /**< seconds of audio encoded twice by each extra segment */
+        bool            splittable; /**< AudioData::probe() allows segments */
+        size_t          segments;   /**< planned number of segments, 1 to encode it whole */
+    };
+
+    double          makespan(std::vector<double> costs) const;
+    double          split(double target);
+
+    std::vector<Entry>          m_entries;  /**< files in order of add() */
+    std::vector<SegmentSet*>    m_splits;   /**< segments of the split files */
+    size_t                      m_workers;  /**< number of workers planned for */
+    double                      m_makespan; /**< predicted makespan in seconds of audio */
+    double                      m_start;    /**< time of submit() */
+};
+
+#endif  /* _PLANNER_H */
@@ -0,0 +1,922 @@
+/**
+ * @file        pool.cpp
+ * @version     1.0
+ * @brief       MP3enc_cpp worker pool source
+ * @date        Oct 18, 2026
+ * @author      Siwon Kang (kkangshawn@gmail.com)
+ */
+
+#include "pool.h"
+#include "audio.h"
+#include "cancel.h"
+#include "governor.h"
+#include "journal.h"
+#include "reader.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <unordered_set>
+using namespace std;
+
+/* relative gain in throughput for the controller to keep moving in the same direction */
+static const double ADAPT_GAIN = 0.03;
+
+WorkerPool::WorkerPool(size_t workers) : m_queued(0), m_closed(false), m_active(0), m_busy(0), m_limit(0),
+            m_watchdog(nullptr), m_controller(nullptr),
+            m_factor(0), m_min(0), m_abandon(false), m_stranded(0), m_stranded_mem(0), m_rate(0),
+            m_budget(0), m_mem(0), m_mem_peak(0), m_pin(Topology::PIN_NONE),
+            m_window(0), m_adjustments(0), m_best_rate(0), m_best_limit(0),
+            m_batch_bytes(0), m_batch_jobs(0), m_batches(0), m_prefetch(0), m_warm(false), m_dispatched(0),
+            m_setup(0), m_open(0), m_handoff(0), m_worked(0), m_ranked(false), m_aging(0), m_classes{}
+{
+    if (workers < 1) {
+        workers = 1;
+    }
+    for (size_t i = 0; i < workers; i++) {
+        m_workers.push_back(new Worker(this, i));
+    }
+}
+
+WorkerPool::Worker::Worker(WorkerPool* pool, size_t index) : job(nullptr), batch{}, context{}, idle(0),
+            reported(false), abandoned(false), held(0), m_pool(pool), m_index(index)
+{
+}
+
+/* out of line for the destructor of context, AudioData being incomplete in pool.h */
+WorkerPool::Worker::~Worker()
+{
+}
+
+WorkerPool::~WorkerPool()
+{
+    finish();
+    for (Worker* w : m_workers) {
+        /* an abandoned worker may still be blocked in its job and is leaked */
+        if (!w->abandoned) {
+            delete w;
+        }
+    }
+    delete m_watchdog;
+    delete m_controller;
+}
+
+size_t
+WorkerPool::default_workers()
+{
+    return Topology::instance().default_workers();
+}
+
+void
+WorkerPool::start()
+{
+    {
+        Lock l(m_lock);
+        m_active += m_workers.size();
+        m_limit = (m_window > 0) ? 1 : m_workers.size();
+    }
+    for (Worker* w : m_workers) {
+        w->start();
+    }
+    if (m_factor > 0 && !m_watchdog) {
+        m_watchdog = new Monitor(this, &WorkerPool::watch);
+        m_watchdog->start();
+    }
+    if (m_window > 0 && !m_controller) {
+        m_controller = new Monitor(this, &WorkerPool::control);
+        m_controller->start();
+    }
+}
+
+void
+WorkerPool::set_watchdog(double factor, double min_seconds, bool abandon)
+{
+    m_factor = factor;
+    m_min = min_seconds;
+    m_abandon = abandon;
+}
+
+void
+WorkerPool::submit(Job* job)
+{
+    job->inputBytes = get_file_size(job->inPath.c_str());
+    job->device = Storage::instance().lookup(job->inPath);
+    Storage::instance().add_job(job->device);
+    if (!job->memEstimate) {
+        job->memEstimate = AudioData::estimate_memory(job->inputBytes);
+    }
+
+    Lock l(m_lock);
+
+    job->queued = monotonic_time();
+    if (Cancel::requested()) {
+        job->state = Job::JS_CANCELED;
+        return;
+    }
+    job->state = Job::JS_QUEUED;
+    if (job->priority != Job::JP_NORMAL || job->deadline > 0) {
+        m_ranked = true;
+    }
+    enqueue(job);
+    m_cond.signal();
+}
+
+void
+WorkerPool::finish()
+{
+    {
+        Lock l(m_lock);
+        m_closed = true;
+        m_cond.broadcast();
+
+        double canceled = 0;
+        while (m_active > 0) {
+            m_idle.wait_for(m_lock, 0.1);
+            if (!Cancel::requested() || Cancel::aborted()) {
+                continue;
+            }
+            double const now = monotonic_time();
+            if (!canceled) {
+                canceled = now;
+                DEBUG::WARN("Cancel requested, waiting for running jobs");
+                drop_queued();
+                m_cond.broadcast();
+            } else if (now - canceled >= Cancel::deadline()) {
+                DEBUG::WARN("Cancel deadline passed, aborting running jobs");
+                Cancel::abort();
+            }
+        }
+        m_watch.broadcast();
+    }
+    if (m_watchdog) {
+        m_watchdog->join();
+    }
+    if (m_controller) {
+        m_controller->join();
+    }
+    for (Worker* w : m_workers) {
+        if (w->abandoned) {
+            w->detach();
+        } else {
+            w->join();
+        }
+    }
+}
+
+bool
+WorkerPool::batchable(const Job* job) const
+{
+    return m_batch_bytes && !job->split && job->inputBytes > 0 && job->inputBytes <= m_batch_bytes;
+}
+
+void
+WorkerPool::prefetch(const Job* job)
+{
+    vector<string> paths(1, job->inPath);
+
+    if (!m_prefetch || !Reader::instance().is_running()) {
+        return;
+    }
+    /* the inputs taken and not opened yet, then the next ones in queue order */
+    for (const Worker* w : m_workers) {
+        for (const Job* j : w->batch) {
+            paths.push_back(j->inPath);
+        }
+    }
+    size_t n = 0;
+    for (const Ranked& q : m_queue) {
+        for (Ranked::const_iterator it = q.begin(); it != q.end() && n < m_prefetch; ++it, n++) {
+            paths.push_back(it->second->inPath);
+        }
+    }
+    Reader::instance().prefetch(paths);
+}
+
+WorkerPool::Ranked::key_type
+WorkerPool::rank(const Job* job)
+{
+    return make_pair(job->deadline > 0 ? job->deadline : HUGE_VAL, job->queued);
+}
+
+void
+WorkerPool::enqueue(Job* job)
+{
+    Ranked::value_type const entry(rank(job), job);
+
+    m_queue[job->priority].insert(entry);
+    if (job->priority == Job::JP_BULK && m_aging > 0) {
+        m_bulk.push_back(entry);
+    }
+    m_queued++;
+}
+
+bool
+WorkerPool::unqueue(Job* job)
+{
+    Ranked::key_type const key = rank(job);
+    int const classes[] = { job->priority, Job::JP_NORMAL };
+
+    /* a bulk job may have aged into the normal queue */
+    for (size_t i = 0; i < (job->priority == Job::JP_BULK ? 2u : 1u); i++) {
+        Ranked& q = m_queue[classes[i]];
+        pair<Ranked::iterator, Ranked::iterator> const r = q.equal_range(key);
+        for (Ranked::iterator it = r.first; it != r.second; ++it) {
+            if (it->second == job) {
+                q.erase(it);
+                m_queued--;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void
+WorkerPool::age(double now)
+{
+    /* jobs age in submission order; those taken or canceled meanwhile are not found */
+    while (!m_bulk.empty() && now - m_bulk.front().first.second >= m_aging) {
+        Ranked::value_type const entry = m_bulk.front();
+        m_bulk.pop_front();
+        pair<Ranked::iterator, Ranked::iterator> const r = m_queue[Job::JP_BULK].equal_range(entry.first);
+        for (Ranked::iterator it = r.first; it != r.second; ++it) {
+            if (it->second == entry.second) {
+                m_queue[Job::JP_BULK].erase(it);
+                m_queue[Job::JP_NORMAL].insert(entry);
+                break;
+            }
+        }
+    }
+}
+
+WorkerPool::Ranked::iterator
+WorkerPool::pick(Ranked*& queue)
+{
+    if (!m_bulk.empty()) {
+        age(monotonic_time());
+    }
+    for (Ranked& q : m_queue) {
+        if (!q.empty()) {
+            queue = &q;
+            break;
+        }
+    }
+    Ranked::iterator const first = queue->begin();
+
+    /* with inputs on several devices, pass over the first jobs due as early whose device already queues I/O */
+    if (Storage::instance().count() > 1) {
+        Ranked::iterator it = first;
+        for (size_t i = 0; i < m_workers.size() * 2 && it != queue->end() && it->first.first == first->first.first;
+                i++, ++it) {
+            if (!Storage::instance().congested(it->second->device)) {
+                return it;
+            }
+        }
+    }
+
+    return first;
+}
+
+Job*
+WorkerPool::next_job(Worker& w)
+{
+    Lock l(m_lock);
+    Ranked* queue = nullptr;
+    Ranked::iterator it;
+
+    while (!Cancel::requested()) {
+        if (!m_queued) {
+            if (m_closed) {
+                return nullptr;
+            }
+        } else if (m_busy < m_limit && admit((it = pick(queue))->second)) {
+            Job* job = it->second;
+            double const deadline = it->first.first;
+            it = queue->erase(it);
+            m_queued--;
+            m_busy++;
+
+            /* small inputs next in rank and due as late go to the same worker in one handoff */
+            while (batchable(job) && w.batch.size() + 1 < m_batch_jobs && it != queue->end() &&
+                    it->first.first == deadline && batchable(it->second) && admit(it->second)) {
+                w.batch.push_back(it->second);
+                it = queue->erase(it);
+                m_queued--;
+            }
+            if (!w.batch.empty()) {
+                m_batches++;
+                if (Trace::instance().is_open()) {
+                    ostringstream f;
+                    f << "\"worker\":" << w.index() << ",\"first\":" << job->id << ",\"jobs\":" <<
+                        (w.batch.size() + 1);
+                    Trace::instance().event("batch", f.str());
+                }
+            }
+            prefetch(job);
+            return job;
+        }
+        m_cond.wait_for(m_lock, 0.1);
+    }
+    drop_queued();
+
+    return nullptr;
+}
+
+Job*
+WorkerPool::next_in_batch(Worker& w)
+{
+    Lock l(m_lock);
+
+    if (w.batch.empty()) {
+        return nullptr;
+    }
+    if (Cancel::requested()) {
+        for (Job* job : w.batch) {
+            job->state = Job::JS_CANCELED;
+            m_mem -= job->memEstimate;
+        }
+        w.batch.clear();
+        m_done.broadcast();
+        return nullptr;
+    }
+    Job* job = w.batch.front();
+    w.batch.pop_front();
+
+    return job;
+}
+
+bool
+WorkerPool::admit(Job* job)
+{
+    /* a job left to stranded threads may never return its memory; an idle pool does not wait for it */
+    size_t const held = m_busy ? m_mem : m_mem - m_stranded_mem;
+
+    if (m_budget && held > 0 && held + job->memEstimate > m_budget) {
+        return false;
+    }
+    if (m_budget && job->memEstimate > m_budget) {
+        cerr << "WARNING: " << job->inPath << " needs " << (job->memEstimate >> 10) <<
+            "KB, more than the memory budget. Running it alone" << endl;
+    }
+    m_mem += job->memEstimate;
+    m_mem_peak = max(m_mem_peak, m_mem);
+
+    return true;
+}
+
+void
+WorkerPool::work(Worker& w)
+{
+    Job* job;
+
+    if (m_pin != Topology::PIN_NONE && !Topology::instance().pin(w.index(), m_pin)) {
+        DEBUG::WARN("failed to pin worker");
+    }
+    Governor::instance().enter();
+    w.idle = monotonic_time();
+    while ((job = next_job(w)) != nullptr) {
+        unique_ptr<AudioData> batch;
+        unique_ptr<AudioData>& reuse = m_warm ? w.context : batch;
+        bool const reused = !job->split && (m_warm || batchable(job));
+        do {
+            if (!process(w, job, reused ? &reuse : nullptr)) {
+                /* abandoned: the replacement worker already counts in m_active */
+                Governor::instance().leave();
+                return;
+            }
+        } while ((job = next_in_batch(w)) != nullptr);
+
+        Lock l(m_lock);
+        m_busy--;
+        m_cond.broadcast();
+    }
+    Governor::instance().leave();
+
+    Lock l(m_lock);
+    m_active--;
+    m_idle.signal();
+}
+
+void
+WorkerPool::drop_queued()
+{
+    for (Ranked& q : m_queue) {
+        for (Ranked::iterator it = q.begin(); it != q.end(); ++it) {
+            it->second->state = Job::JS_CANCELED;
+        }
+        q.clear();
+    }
+    m_bulk.clear();
+    m_queued = 0;
+    m_done.broadcast();
+}
+
+bool
+WorkerPool::process(Worker& w, Job* job, unique_ptr<AudioData>* reuse)
+{
+    string const in = job->inPath;
+    string const out = job->outPath;
+    Heartbeat& hb = w.heartbeat();
+    bool done;
+    size_t job_mem;
+    double stages;
+    double opened;
+
+    {
+        Lock l(m_lock);
+        job->state = Job::JS_RUNNING;
+        job->started = monotonic_time();
+        job->handoff = job->started - max(w.idle, job->queued);
+        w.job = job;
+        w.reported = false;
+        hb.beat(Heartbeat::HB_OPENING, job->started);
+    }
+    if (Journal::instance().is_open()) {
+        Journal::instance().started(AudioData::output_name(in, out));
+    }
+    {
+        SegmentSet* const split = job->split;
+        unique_ptr<AudioData> own;
+        if (reuse && *reuse) {
+            (*reuse)->reopen(in, out);
+        } else {
+            own.reset(new AudioData(in, out, job->first, job->samples,
+                        !split || job->segment + 1 == split->parts.size()));
+            if (reuse) {
+                reuse->swap(own);
+            }
+        }
+        AudioData& adata = (reuse && *reuse) ? **reuse : *own;
+        adata.set_heartbeat(&hb);
+        {
+            Lock l(m_lock);
+            if (left(w)) {
+                return false;
+            }
+            job->audioSeconds = adata.duration();
+        }
+        done = adata.encode();
+        job_mem = adata.memory_used();
+        const AudioData::StageTimes& st = adata.stage_times();
+        stages = st.read + st.encode + st.write;
+        opened = st.open;
+        if (split) {
+            {
+                /* abandon() accounted for the segment already */
+                Lock l(m_lock);
+                if (left(w)) {
+                    return false;
+                }
+            }
+            done = join(job, adata, done);
+        }
+    }
+    hb.beat(Heartbeat::HB_IDLE, monotonic_time());
+
+    Lock l(m_lock);
+    if (left(w)) {
+        return false;
+    }
+    w.job = nullptr;
+    job->finished = w.idle = monotonic_time();
+    job->memUsed = job_mem;
+    job->setup = max(job->latency() - stages, 0.0);
+    m_mem -= job->memEstimate;
+    m_cond.broadcast();
+    m_dispatched++;
+    m_setup += job->setup;
+    m_open += opened;
+    m_handoff += job->handoff;
+    m_worked += job->latency();
+    if (job->memUsed > job->memEstimate) {
+        cerr << "WARNING: " << job->inPath << " used " << (job->memUsed >> 10) <<
+            "KB, more than estimated " << (job->memEstimate >> 10) << "KB" << endl;
+    }
+    if (done) {
+        job->state = Job::JS_DONE;
+        if (job->audioSeconds > 0) {
+            double const rate = job->latency() / job->audioSeconds;
+            m_rate = m_rate > 0 ? 0.8 * m_rate + 0.2 * rate : rate;
+        }
+    } else {
+        job->state = Cancel::aborted() ? Job::JS_CANCELED : Job::JS_FAILED;
+    }
+    ClassStats& c = m_classes[job->priority];
+    c.jobs++;
+    c.wait += job->wait();
+    c.longest = max(c.longest, job->wait());
+    if (job->deadline > 0) {
+        c.deadlines++;
+        c.missed += job->finished > job->deadline;
+    }
+    m_done.broadcast();
+    if (Trace::instance().is_open()) {
+        ostringstream f;
+        f << "\"job\":" << job->id << ",\"in\":" << Trace::quote(job->inPath) << ",\"worker\":" << w.index() <<
+            ",\"ok\":" << (done ? "true" : "false") << ",\"wait\":" << job->wait() <<
+            ",\"latency\":" << job->latency() << ",\"audio\":" << job->audioSeconds <<
+            ",\"setup\":" << job->setup << ",\"handoff\":" << job->handoff;
+        if (job->split) {
+            f << ",\"segment\":" << job->segment;
+        }
+        if (job->predicted > 0) {
+            f << ",\"predicted\":" << job->predicted;
+        }
+        if (m_ranked) {
+            f << ",\"class\":\"" << Job::priority_name(job->priority) << "\"";
+        }
+        if (job->deadline > 0) {
+            f << ",\"slack\":" << (job->deadline - job->finished);
+        }
+        Trace::instance().event("job", f.str());
+    }
+
+    return true;
+}
+
+bool
+WorkerPool::join(Job* job, AudioData& adata, bool done)
+{
+    SegmentSet* const split = job->split;
+    bool last;
+
+    if (done) {
+        adata.take_segment(split->parts[job->segment]);
+    }
+    {
+        Lock l(m_lock);
+        split->failed = split->failed || !done;
+        last = (--split->pending == 0);
+    }
+    if (!last) {
+        return done;
+    }
+
+    /* the segments are done and no other job touches split any more */
+    if (split->failed) {
+        cerr << "ERROR: a segment of " << job->inPath << " failed, no output written" << endl;
+        done = false;
+    } else {
+        done = AudioData::join_segments(AudioData::output_name(job->inPath, job->outPath), split->parts);
+    }
+    vector<vector<unsigned char> >(split->parts.size()).swap(split->parts);
+
+    return done;
+}
+
+void
+WorkerPool::watch()
+{
+    Lock l(m_lock);
+
+    while (!m_closed || m_active > 0) {
+        m_watch.wait_for(m_lock, 1.0);
+
+        double const now = monotonic_time();
+        vector<Worker*> stuck;
+        for (Worker* w : m_workers) {
+            Job* job = w->job;
+            if (!job || w->reported || w->abandoned) {
+                continue;
+            }
+            double const limit = max(m_min, m_factor * m_rate * job->audioSeconds);
+            if (now - job->started >= limit) {
+                w->reported = true;
+                cerr << "WARNING: job " << job->id << " (" << job->inPath << ") running for " <<
+                    (now - job->started) << "s, over the limit of " << limit << "s" << endl;
+                stuck.push_back(w);
+            }
+        }
+        if (stuck.empty()) {
+            continue;
+        }
+        snapshot(now);
+        if (m_abandon) {
+            for (Worker* w : stuck) {
+                abandon(w);
+            }
+        }
+    }
+}
+
+double
+WorkerPool::audio_done()
+{
+    double audio = 0;
+
+    for (Worker* w : m_workers) {
+        audio += w->heartbeat().audio;
+    }
+
+    return audio;
+}
+
+void
+WorkerPool::control()
+{
+    Lock l(m_lock);
+    double last = monotonic_time();
+    double done = audio_done();
+    double base = 0;            /* throughput before the step being probed */
+    int dir = 1;
+    bool probing = false;       /* the limit was moved to see if throughput improves */
+    bool settle = false;        /* the last window mixed two limits */
+    size_t backoff = 1;         /* windows to hold after a step without gain */
+    size_t hold = 0;            /* windows left to hold */
+
+    while (!m_closed || m_active > 0) {
+        m_watch.wait_for(m_lock, m_window);
+
+        double const now = monotonic_time();
+        double const total = audio_done();
+        double const rate = (now > last) ? (total - done) / (now - last) : 0;
+        size_t const limit = m_limit;
+        /* only a window with every allowed worker busy and work waiting tells about the limit */
+        bool const saturated = (m_busy == m_limit && m_queued);
+        int step = 0;
+
+        last = now;
+        done = total;
+        if (settle || !saturated) {
+            settle = false;
+        } else if (probing) {
+            probing = false;
+            if (rate < base * (1 + ADAPT_GAIN)) {
+                /* no gain: step back and stay there longer each time */
+                dir = -dir;
+                step = dir;
+                hold = backoff;
+                backoff = min(backoff * 2, (size_t)16);
+            } else {
+                backoff = 1;
+                step = dir;
+                probing = true;
+                base = rate;
+            }
+        } else if (hold > 0) {
+            hold--;
+        } else {
+            if ((dir > 0 && m_limit >= m_workers.size()) || (dir < 0 && m_limit <= 1)) {
+                dir = -dir;
+            }
+            step = dir;
+            probing = true;
+            base = rate;
+        }
+        if (step > 0 && m_limit < m_workers.size()) {
+            m_limit++;
+        } else if (step < 0 && m_limit > 1) {
+            m_limit--;
+        } else if (step != 0) {
+            /* at a bound: nothing to probe */
+            probing = false;
+        }
+        if (m_limit != limit) {
+            m_adjustments++;
+            settle = true;
+            m_cond.broadcast();
+        }
+        if (saturated && rate > m_best_rate) {
+            m_best_rate = rate;
+            m_best_limit = limit;
+        }
+
+        const char* decision = (m_limit > limit) ? "up" : (m_limit < limit) ? "down" : "hold";
+        ostringstream f;
+        f << "\"workers\":" << limit << ",\"busy\":" << m_busy << ",\"queued\":" << m_queued <<
+            ",\"throughput\":" << rate << ",\"decision\":\"" << decision << "\",\"next\":" << m_limit;
+        Trace::instance().event("adapt", f.str());
+        if (DEBUG::IS_SET() && m_limit != limit) {
+            ostringstream msg;
+            msg << "workers " << limit << " -> " << m_limit << " at " << rate << " audio-sec/s";
+            DEBUG::INFO(msg.str().c_str());
+        }
+    }
+}
+
+size_t
+WorkerPool::cancel(const vector<Job*>& jobs)
+{
+    unordered_set<const Job*> const listed(jobs.begin(), jobs.end());
+    size_t withdrawn = 0;
+    Lock l(m_lock);
+
+    for (Job* job : jobs) {
+        if (job->state == Job::JS_QUEUED && unqueue(job)) {
+            job->state = Job::JS_CANCELED;
+            withdrawn++;
+        }
+    }
+    /* jobs batched behind the job of a worker are admitted already */
+    for (Worker* w : m_workers) {
+        for (deque<Job*>::iterator it = w->batch.begin(); it != w->batch.end();) {
+            if (listed.count(*it)) {
+                (*it)->state = Job::JS_CANCELED;
+                m_mem -= (*it)->memEstimate;
+                it = w->batch.erase(it);
+                withdrawn++;
+            } else {
+                ++it;
+            }
+        }
+    }
+    if (withdrawn) {
+        m_cond.broadcast();
+        m_done.broadcast();
+    }
+
+    return withdrawn;
+}
+
+bool
+WorkerPool::wait(const vector<Job*>& jobs, double seconds)
+{
+    double const until = monotonic_time() + seconds;
+    Lock l(m_lock);
+
+    for (;;) {
+        bool busy = false;
+        for (const Job* j : jobs) {
+            busy = busy || j->state == Job::JS_QUEUED || j->state == Job::JS_RUNNING;
+        }
+        double const now = monotonic_time();
+        if (!busy || now >= until) {
+            return !busy;
+        }
+        m_done.wait_for(m_lock, until - now);
+    }
+}
+
+vector<size_t>
+WorkerPool::states(const vector<Job*>& jobs)
+{
+    vector<size_t> count(Job::JS_CANCELED + 1, 0);
+    Lock l(m_lock);
+
+    for (const Job* j : jobs) {
+        count[j->state]++;
+    }
+
+    return count;
+}
+
+void
+WorkerPool::take_finished(vector<Job*>& jobs, vector<Job*>& finished)
+{
+    Lock l(m_lock);
+    size_t kept = 0;
+
+    for (Job* j : jobs) {
+        if (j->state == Job::JS_QUEUED || j->state == Job::JS_RUNNING) {
+            jobs[kept++] = j;
+        } else {
+            finished.push_back(j);
+        }
+    }
+    jobs.resize(kept);
+}
+
+string
+WorkerPool::dispatch_report()
+{
+    Lock l(m_lock);
+    ostringstream s;
+
+    if (!m_dispatched) {
+        return "Dispatch: no job finished";
+    }
+    s.setf(ios::fixed);
+    s.precision(2);
+    s << "Dispatch: " << m_dispatched << " job(s), " << m_batches << " batch(es), per job " <<
+        (m_setup * 1000 / m_dispatched) << "ms setup (" << (m_open * 1000 / m_dispatched) <<
+        "ms opening files and LAME) and " << (m_handoff * 1000 / m_dispatched) << "ms handoff, " <<
+        (m_worked > 0 ? m_setup * 100 / m_worked : 0) << "% of worker time in setup";
+
+    return s.str();
+}
+
+string
+WorkerPool::priority_report()
+{
+    Lock l(m_lock);
+    ostringstream s;
+
+    if (!m_ranked) {
+        return "";
+    }
+    if (!m_dispatched) {
+        return "Priority: no job finished";
+    }
+    s.setf(ios::fixed);
+    s.precision(2);
+    s << "Priority:";
+    for (int p = Job::JP_INTERACTIVE; p < Job::JP_COUNT; p++) {
+        const ClassStats& c = m_classes[p];
+        if (!c.jobs) {
+            continue;
+        }
+        s << " " << Job::priority_name(p) << " " << c.jobs << " job(s), wait " << (c.wait / c.jobs) <<
+            "s average " << c.longest << "s longest";
+        if (c.deadlines) {
+            s << ", " << c.missed << " of " << c.deadlines << " deadline(s) missed (" <<
+                (c.missed * 100.0 / c.deadlines) << "%)";
+        }
+        s << ";";
+    }
+    string r = s.str();
+    r.pop_back();
+
+    return r;
+}
+
+string
+WorkerPool::controller_report()
+{
+    Lock l(m_lock);
+    ostringstream s;
+
+    s << "Adaptive workers: " << m_limit << " of " << m_workers.size() << " at the end, " <<
+        m_adjustments << " adjustment(s)";
+    if (m_best_rate > 0) {
+        s << ", best " << m_best_rate << " audio-sec/s with " << m_best_limit << " worker(s)";
+    }
+
+    return s.str();
+}
+
+void
+WorkerPool::snapshot(double now)
+{
+    cerr << "Worker snapshot: " << m_queued << " job(s) queued, " << m_active << " worker(s) active" << endl;
+    for (Worker* w : m_workers) {
+        if (w->abandoned) {
+            continue;
+        }
+        Heartbeat& hb = w->heartbeat();
+        cerr << "   worker " << w->index() << ": " << Heartbeat::name(hb.stage);
+        if (w->job) {
+            cerr << " job " << w->job->id << " (" << w->job->inPath << ") for " <<
+                (now - w->job->started) << "s, last progress " << (now - hb.time) << "s ago";
+        }
+        cerr << endl;
+    }
+}
+
+bool
+WorkerPool::left(Worker& w)
+{
+    /* once abandoned, the thread touches neither its job nor the pool after this */
+    if (w.abandoned) {
+        m_stranded--;
+        m_stranded_mem -= w.held;
+        m_mem -= w.held;
+        w.held = 0;
+        m_cond.broadcast();
+    }
+
+    return w.abandoned;
+}
+
+size_t
+WorkerPool::stranded()
+{
+    Lock l(m_lock);
+
+    return m_stranded;
+}
+
+void
+WorkerPool::abandon(Worker* w)
+{
+    Job* job = w->job;
+
+    cerr << "WARNING: abandoning job " << job->id << " (" << job->inPath << ")" << endl;
+    job->state = Job::JS_FAILED;
+    job->finished = monotonic_time();
+    m_done.broadcast();
+    w->job = nullptr;
+    w->abandoned = true;
+    w->held = job->memEstimate;
+    m_stranded++;
+    m_stranded_mem += w->held;
+    m_busy--;
+    w->heartbeat().abandoned = true;
+    /* the rest of its batch goes back to the queue */
+    while (!w->batch.empty()) {
+        m_mem -= w->batch.back()->memEstimate;
+        enqueue(w->batch.back());
+        w->batch.pop_back();
+    }
+    if (job->split) {
+        /* the remaining segments fail the file; it is left unwritten if this one was the last */
+        job->split->failed = true;
+        job->split->pending--;
+    }
+
+    /* the stuck thread cannot be interrupted; a new worker takes its place */
+    Worker* r = new Worker(this, m_workers.size());
+    m_workers.push_back(r);
+    r->start();
+}
@@ -0,0 +1,293 @@
+/**
+ * @file        pool.h
+ * @version     1.0
+ * @brief       MP3enc_cpp worker pool header
+ * @date        Oct 18, 2026
+ * @author      Siwon Kang (kkangshawn@gmail.com)
+ */
+
+#ifndef _POOL_H
+#define _POOL_H
+
+#include "common.h"
+#include "utils.h"
+#include "thread.h"
+#include "job.h"
+#include "topology.h"
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+class AudioData;
+
+/**
+ * @class   WorkerPool pool.h "pool.h"
+ * @brief   A fixed number of worker threads encoding jobs from a shared queue.
+ *          Jobs are owned by the caller and have to outlive the pool.
+ *          Each priority class has a queue ordered by deadline, then by submission, so jobs
+ *          without deadlines are taken in submission order. A worker takes from the first
+ *          class with jobs; a bulk job waiting longer than the aging time moves to the normal
+ *          queue so that backfills keep moving.
+ */
+class WorkerPool : public Utils, DEBUG {
+public:
+    explicit WorkerPool(size_t workers);
+    virtual ~WorkerPool();
+
+    /**
+     * @fn      static size_t default_workers()
+     * @brief   A function to get the number of workers used when not specified.
+     * @return  the number of processors in the affinity mask, limited by the cgroup CPU quota
+     */
+    static size_t   default_workers();
+    /**
+     * @fn      void start()
+     * @brief   start worker threads.
+     */
+    void            start();
+    /**
+     * @fn      void submit(Job* job)
+     * @brief   queue a job. Can be called before or after start().
+     *          The job is canceled right away if cancellation was requested.
+     *          Its memory estimate is derived from the input file size unless already set.
+     * @param [in]  job     a job to encode
+     */
+    void            submit(Job* job);
+    /**
+     * @fn      void finish()
+     * @brief   close the queue and wait until all the queued jobs are done.
+     *          Once cancellation is requested, running jobs are aborted after Cancel::deadline().
+     */
+    void            finish();
+    /**
+     * @fn      void set_watchdog(double factor, double min_seconds, bool abandon)
+     * @brief   watch running jobs. A job running longer than factor times its expected
+     *          duration, but at least min_seconds, is reported with the stage of every worker.
+     *          The expected duration comes from the encoding speed of the jobs done so far.
+     * @param [in]  factor      multiple of the expected duration, 0 to disable
+     * @param [in]  min_seconds shortest time a job may run before it is reported
+     * @param [in]  abandon     give up the stuck job and replace its worker
+     */
+    void            set_watchdog(double factor, double min_seconds, bool abandon);
+    /**
+     * @fn      void set_memory_budget(size_t bytes)
+     * @brief   admit a queued job only when its estimated working set fits in the budget
+     *          together with the running jobs. A job larger than the budget runs alone.
+     * @param [in]  bytes   budget in bytes, 0 for no limit
+     */
+    void            set_memory_budget(size_t bytes) { m_budget = bytes; }
+    /**
+     * @fn      void set_pinning(Topology::PIN_MODE mode)
+     * @brief   bind each worker to a processor or a NUMA node when it starts.
+     */
+    void            set_pinning(Topology::PIN_MODE mode) { m_pin = mode; }
+    /**
+     * @fn      void set_adaptive(double window)
+     * @brief   let a controller choose how many of the workers process jobs at once.
+     *          It measures seconds of audio encoded per second over each window and moves the
+     *          limit by one worker at a time, turning around when throughput stops improving.
+     *          Every decision is written to the trace.
+     * @param [in]  window  seconds between decisions, 0 to keep every worker busy
+     */
+    void            set_adaptive(double window) { m_window = window; }
+    /**
+     * @fn      void set_batching(size_t bytes, size_t jobs)
+     * @brief   let a worker take up to jobs consecutive queued inputs of at most bytes each
+     *          and encode them back to back, reusing its buffers between them.
+     * @param [in]  bytes   largest input file batched, 0 to disable
+     * @param [in]  jobs    most jobs in a batch
+     */
+    void            set_batching(size_t bytes, size_t jobs) { m_batch_bytes = bytes; m_batch_jobs = jobs; }
+    /**
+     * @fn      void set_prefetch(size_t jobs)
+     * @brief   let the central reader prefetch the inputs of the next jobs queued
+     *          whenever a worker takes a job. Has no effect unless the Reader runs.
+     * @param [in]  jobs    number of queued jobs to prefetch, 0 to disable
+     */
+    void            set_prefetch(size_t jobs) { m_prefetch = jobs; }
+    /**
+     * @fn      void set_warm(bool warm)
+     * @brief   let every worker keep its encoder context between jobs, as batches do, instead of
+     *          creating one per job. Its PCM and output buffers keep their capacity for the next
+     *          input; the LAME context is still created per input. Segments of split files never
+     *          reuse a context.
+     */
+    void            set_warm(bool warm) { m_warm = warm; }
+    /**
+     * @fn      void set_aging(double seconds)
+     * @brief   rank a bulk job with the normal class once it waited the given time.
+     * @param [in]  seconds time in the queue, 0 to keep bulk jobs behind all the others
+     */
+    void            set_aging(double seconds) { m_aging = seconds; }
+    /**
+     * @fn      size_t cancel(const std::vector<Job*>& jobs)
+     * @brief   withdraw the jobs of a list that no worker has started yet.
+     * @return  number of jobs withdrawn
+     */
+    size_t          cancel(const std::vector<Job*>& jobs);
+    /**
+     * @fn      bool wait(const std::vector<Job*>& jobs, double seconds)
+     * @brief   wait until no job of a list is queued or running, at most the given time.
+     * @return  true if all of them are finished
+     */
+    bool            wait(const std::vector<Job*>& jobs, double seconds);
+    /**
+     * @fn      std::vector<size_t> states(const std::vector<Job*>& jobs)
+     * @brief   count the jobs of a list in each Job::STATE.
+     */
+    std::vector<size_t> states(const std::vector<Job*>& jobs);
+    /**
+     * @fn      void take_finished(std::vector<Job*>& jobs, std::vector<Job*>& finished)
+     * @brief   move the jobs of a list that are neither queued nor running to another list.
+     *          The pool does not touch them any more, so they can be deleted.
+     */
+    void            take_finished(std::vector<Job*>& jobs, std::vector<Job*>& finished);
+    /**
+     * @fn      std::string dispatch_report()
+     * @brief   summarize the time workers spent setting up jobs and being handed jobs.
+     */
+    std::string     dispatch_report();
+    /**
+     * @fn      std::string controller_report()
+     * @brief   summarize the decisions of the concurrency controller.
+     */
+    std::string     controller_report();
+    /**
+     * @fn      std::string priority_report()
+     * @brief   summarize the queue wait and the deadlines missed by each priority class.
+     * @return  an empty string unless the queue was ranked
+     */
+    std::string     priority_report();
+    /**
+     * @fn      size_t stranded()
+     * @brief   count the threads of abandoned workers still blocked in their job.
+     *          They use the pool when they wake up, so a pool with stranded threads
+     *          must be left undeleted until the process exits.
+     */
+    size_t          stranded();
+    size_t          memory_peak() const { return m_mem_peak; }  /**< most bytes admitted at once */
+    size_t          size() const { return m_workers.size(); }  /**< number of workers */
+
+private:
+    /**
+     * @class   Worker pool.h "pool.h"
+     * @brief   A thread of WorkerPool.
+     */
+    class Worker : public Thread {
+    public:
+        Worker(WorkerPool* pool, size_t index);
+        ~Worker();
+        size_t      index() const { return m_index; }
+        Heartbeat&  heartbeat() { return m_heartbeat; }
+
+        Job*        job;        /**< job being processed, protected by m_lock of the pool */
+        std::deque<Job*> batch; /**< jobs taken after job, protected by m_lock of the pool */
+        std::unique_ptr<AudioData> context; /**< encoder context kept between jobs with set_warm() */
+        double      idle;       /**< time the worker became ready for a job */
+        bool        reported;   /**< the watchdog reported the job */
+        bool        abandoned;  /**< the watchdog gave up the job and this worker */
+        size_t      held;       /**< memory estimate of the abandoned job, released when the thread returns */
+    private:
+        void    run() { m_pool->work(*this); }
+
+        WorkerPool* m_pool;     /**< pool this worker belongs to */
+        size_t      m_index;    /**< index in the pool */
+        Heartbeat   m_heartbeat;    /**< progress of the job */
+    };
+    /**
+     * @class   Monitor pool.h "pool.h"
+     * @brief   A thread running one of the periodic checks of WorkerPool until the pool finishes.
+     */
+    class Monitor : public Thread {
+    public:
+        Monitor(WorkerPool* pool, void (WorkerPool::*check)()) : m_pool(pool), m_check(check) {}
+    private:
+        void    run() { (m_pool->*m_check)(); }
+
+        WorkerPool* m_pool;                 /**< pool to check */
+        void        (WorkerPool::*m_check)();   /**< watch() or control() */
+    };
+
+    /**
+     * @struct  ClassStats
+     * @brief   Jobs of a priority class finished so far.
+     */
+    struct ClassStats {
+        size_t      jobs;       /**< jobs finished */
+        double      wait;       /**< sum of Job::wait() */
+        double      longest;    /**< longest Job::wait() */
+        size_t      deadlines;  /**< jobs finished with a deadline */
+        size_t      missed;     /**< jobs finished after their deadline */
+    };
+
+    typedef std::multimap<std::pair<double, double>, Job*> Ranked;  /**< jobs by deadline, then submission time */
+
+    static Ranked::key_type rank(const Job* job);
+    void            enqueue(Job* job);
+    bool            unqueue(Job* job);
+    void            age(double now);
+    Ranked::iterator pick(Ranked*& queue);
+    Job*            next_job(Worker& w);
+    Job*            next_in_batch(Worker& w);
+    bool            batchable(const Job* job) const;
+    void            prefetch(const Job* job);
+    bool            admit(Job* job);
+    void            drop_queued();
+    void            work(Worker& w);
+    bool            process(Worker& w, Job* job, std::unique_ptr<AudioData>* reuse);
+    bool            join(Job* job, AudioData& adata, bool done);
+    void            watch();
+    void            control();
+    double          audio_done();
+    void            snapshot(double now);
+    void            abandon(Worker* w);
+    bool            left(Worker& w);
+
+    std::vector<Worker*>    m_workers;  /**< worker threads */
+    Ranked                  m_queue[Job::JP_COUNT]; /**< jobs waiting for a worker, by the class they are ranked in */
+    std::deque<Ranked::value_type> m_bulk;  /**< bulk jobs in submission order until they age, possibly taken already */
+    size_t                  m_queued;   /**< jobs in m_queue */
+    Mutex                   m_lock;     /**< protects m_queue, m_closed and m_active */
+    Condition               m_cond;     /**< signaled on submit and close */
+    Condition               m_idle;     /**< signaled when a worker exits */
+    Condition               m_done;     /**< broadcast when jobs finish or are canceled */
+    bool                    m_closed;   /**< no more jobs will be submitted */
+    size_t                  m_active;   /**< workers started and not exited yet */
+    size_t                  m_busy;     /**< jobs being processed */
+    size_t                  m_limit;    /**< most jobs processed at once */
+    Monitor*                m_watchdog; /**< watchdog thread, nullptr if disabled */
+    Monitor*                m_controller;   /**< concurrency controller thread, nullptr if disabled */
+    Condition               m_watch;    /**< wakes up the monitor threads to exit */
+    double                  m_factor;   /**< watchdog limit as a multiple of the expected duration */
+    double                  m_min;      /**< watchdog limit lower bound in seconds */
+    bool                    m_abandon;  /**< replace workers stuck in a job */
+    size_t                  m_stranded; /**< threads of abandoned workers not returned yet */
+    size_t                  m_stranded_mem; /**< part of m_mem held by those threads */
+    double                  m_rate;     /**< average seconds of encoding per second of audio */
+    size_t                  m_budget;   /**< memory budget in bytes, 0 for no limit */
+    size_t                  m_mem;      /**< estimated bytes of the admitted jobs */
+    size_t                  m_mem_peak; /**< highest m_mem */
+    Topology::PIN_MODE      m_pin;      /**< how workers are bound to processors */
+    double                  m_window;   /**< controller window in seconds, 0 if disabled */
+    size_t                  m_adjustments;  /**< times the controller changed m_limit */
+    double                  m_best_rate;    /**< best throughput seen in a window */
+    size_t                  m_best_limit;   /**< m_limit during that window */
+    size_t                  m_batch_bytes;  /**< largest input batched, 0 if disabled */
+    size_t                  m_batch_jobs;   /**< most jobs in a batch */
+    size_t                  m_batches;  /**< batches of more than one job taken */
+    size_t                  m_prefetch; /**< queued jobs prefetched by the Reader */
+    bool                    m_warm;     /**< workers keep their encoder context between jobs */
+    size_t                  m_dispatched;   /**< jobs finished */
+    double                  m_setup;    /**< sum of Job::setup */
+    double                  m_open;     /**< part of m_setup spent opening files and LAME */
+    double                  m_handoff;  /**< sum of Job::handoff */
+    double                  m_worked;   /**< sum of Job::latency() */
+    bool                    m_ranked;   /**< a job of another class than normal or with a deadline was submitted */
+    double                  m_aging;    /**< seconds before a bulk job is ranked as normal, 0 if never */
+    ClassStats              m_classes[Job::JP_COUNT];   /**< statistics by priority class */
+};
+
+#endif  /* _POOL_H */
@@ -0,0 +1,420 @@
+/**
+ * @file        reader.cpp
+ * @version     1.0
+ * @brief       MP3enc_cpp input reader source
+ * @date        Oct 18, 2026
+ * @author      Siwon Kang (kkangshawn@gmail.com)
+ */
+
+#include "reader.h"
+#include "hints.h"
+
+#include <algorithm>
+#include <sstream>
+#include <sys/stat.h>
+using namespace std;
+
+/* size of a regular file, -1 for pipes and devices whose reads may block or not be repeatable */
+static double
+regular_file_size(const string& path)
+{
+    struct stat st;
+
+    if (stat(path.c_str(), &st) != 0 || (st.st_mode & S_IFMT) != S_IFREG) {
+        return -1;
+    }
+
+    return (double)st.st_size;
+}
+
+static bool
+seek_file(FILE* file, size_t offset)
+{
+#if defined _WIN32
+    return _fseeki64(file, (__int64)offset, SEEK_SET) == 0;
+#else
+    return fseeko(file, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+Reader&
+Reader::instance()
+{
+    static Reader reader;
+
+    return reader;
+}
+
+void
+Reader::configure(size_t chunk, size_t ahead, size_t prefetch)
+{
+    Lock l(m_lock);
+
+    m_chunk = max(chunk, (size_t)4096);
+    m_ahead = max(ahead, (size_t)1);
+    m_prefetch = prefetch;
+}
+
+Reader::~Reader()
+{
+    for (Lane* lane : m_lanes) {
+        delete lane;
+    }
+    for (Lane* lane : m_stopped) {
+        delete lane;
+    }
+}
+
+void
+Reader::start()
+{
+    Lock l(m_lock);
+
+    /* lanes that exited in stop() are replaced as their devices are seen again */
+    m_stopped.insert(m_stopped.end(), m_lanes.begin(), m_lanes.end());
+    m_lanes.clear();
+    m_running = true;
+    m_stop = false;
+}
+
+void
+Reader::stop()
+{
+    vector<Lane*> lanes;
+    {
+        Lock l(m_lock);
+        if (!m_running) {
+            return;
+        }
+        m_stop = true;
+        for (Lane* lane : m_lanes) {
+            lane->wake.broadcast();
+        }
+        m_ready.broadcast();
+        lanes = m_lanes;
+    }
+    for (Lane* lane : lanes) {
+        lane->join();
+    }
+
+    Lock l(m_lock);
+    m_running = false;
+    /* streams still open belong to abandoned jobs and are released by their Buffer */
+    for (list<Stream*>::iterator it = m_streams.begin(); it != m_streams.end();) {
+        Stream* s = *it++;
+        if (!s->active) {
+            release(s);
+        }
+    }
+}
+
+Reader::Lane*
+Reader::lane(const string& path)
+{
+    Storage::Device* const device = Storage::instance().lookup(path);
+
+    for (Lane* lane : m_lanes) {
+        if (lane->device == device) {
+            return lane;
+        }
+    }
+    Lane* lane = new Lane(this, device);
+    m_lanes.push_back(lane);
+    lane->start();
+
+    return lane;
+}
+
+Reader::Stream*
+Reader::create(const string& path, size_t size, bool active)
+{
+    Stream* s = new Stream{ path, lane(path), nullptr, size, 0, 0, {}, 0, active, false, false, false };
+
+    m_streams.push_back(s);
+    s->lane->wake.signal();
+    return s;
+}
+
+void
+Reader::release(Stream* s)
+{
+    m_streams.remove(s);
+    if (s->file) {
+        fclose(s->file);
+    }
+    delete s;
+}
+
+istream*
+Reader::open(const string& path)
+{
+    double const size = regular_file_size(path);
+    Stream* s = nullptr;
+
+    /* a pipe may block and cannot be read again; it is read by the encoder itself */
+    if (size <= 0) {
+        return nullptr;
+    }
+
+    Lock l(m_lock);
+    if (!m_running || m_stop) {
+        return nullptr;
+    }
+    m_opened++;
+    for (list<Stream*>::iterator it = m_streams.begin(); it != m_streams.end(); ++it) {
+        if (!(*it)->active && !(*it)->closed && (*it)->path == path && (*it)->size == (size_t)size) {
+            s = *it;
+            /* served after the encoders opened before it */
+            m_streams.splice(m_streams.end(), m_streams, it);
+            break;
+        }
+    }
+    if (s) {
+        s->active = true;
+        if (s->next > 0) {
+            m_hits++;
+        }
+    } else {
+        s = create(path, (size_t)size, true);
+    }
+    s->lane->wake.signal();
+
+    return new ChunkStream(this, s);
+}
+
+void
+Reader::prefetch(const vector<string>& paths)
+{
+    Lock l(m_lock);
+
+    if (!m_running || m_stop) {
+        return;
+    }
+    for (list<Stream*>::iterator it = m_streams.begin(); it != m_streams.end();) {
+        Stream* s = *it++;
+        if (s->active || s->closed || find(paths.begin(), paths.end(), s->path) != paths.end()) {
+            continue;
+        }
+        if (s->reading) {
+            s->closed = true;
+        } else {
+            release(s);
+        }
+    }
+    for (const string& path : paths) {
+        bool known = false;
+        for (const Stream* s : m_streams) {
+            known = known || (!s->closed && s->path == path);
+        }
+        double const size = known ? 0 : regular_file_size(path);
+        if (size > 0) {
+            create(path, (size_t)size, false);
+        }
+    }
+}
+
+Reader::Stream*
+Reader::pick(const Lane& lane)
+{
+    /* encoders first, oldest first, then the queued jobs in order */
+    for (int pass = 0; pass < 2; pass++) {
+        for (Stream* s : m_streams) {
+            if (s->lane != &lane || s->reading || s->closed || s->failed || s->next >= s->size || s->active != (pass == 0)) {
+                continue;
+            }
+            if (s->active ? s->buffered < m_ahead * m_chunk : s->next < m_prefetch) {
+                return s;
+            }
+        }
+    }
+
+    return nullptr;
+}
+
+void
+Reader::serve(Lane& lane)
+{
+    m_lock.lock();
+    while (!m_stop) {
+        Stream* s = pick(lane);
+        if (!s) {
+            lane.wake.wait(m_lock);
+            continue;
+        }
+        FILE* file = s->file;
+        size_t const offset = s->next;
+        unsigned int const generation = s->generation;
+        string const path = s->path;
+        Chunk c = { offset, vector<char>(s->active ? m_chunk : min(m_chunk, m_prefetch - offset)) };
+        s->reading = true;
+        m_lock.unlock();
+
+        size_t const want = c.data.size();
+        bool failed;
+        size_t n;
+        {
+            Storage::Slot slot(lane.device);
+            if (!file && (file = fopen(path.c_str(), "rb")) != nullptr) {
+                /* chunks are as large as any buffer stdio would add */
+                setvbuf(file, nullptr, _IONBF, 0);
+                if (StreamHints::enabled()) {
+                    StreamHints::sequential(fileno(file));
+                }
+            }
+            failed = !file || !seek_file(file, offset);
+            n = failed ? 0 : fread(c.data.data(), 1, want, file);
+            failed = failed || (n < want && ferror(file));
+        }
+        if (n > 0 && StreamHints::enabled()) {
+            /* the chunk is copied out, the kernel keeps reading ahead of it */
+            StreamHints::drop(fileno(file), offset, n);
+        }
+        c.data.resize(n);
+
+        m_lock.lock();
+        s->file = file;
+        s->reading = false;
+        m_bytes += n;
+        m_reads++;
+        if (s->closed) {
+            release(s);
+            continue;
+        }
+        if (failed) {
+            DEBUG::ERR("failed to read input");
+            s->failed = true;
+        } else if (generation == s->generation) {
+            s->next = offset + n;
+            if (n < want && s->next < s->size) {
+                /* the file shrank since it was opened */
+                s->size = s->next;
+            }
+            if (n > 0) {
+                s->buffered += n;
+                s->ready.push_back(Chunk());
+                s->ready.back().offset = c.offset;
+                s->ready.back().data.swap(c.data);
+            }
+        }
+        m_ready.broadcast();
+    }
+    m_lock.unlock();
+}
+
+bool
+Reader::take(Stream* s, vector<char>& chunk, size_t& offset)
+{
+    Lock l(m_lock);
+
+    while (s->ready.empty() && !s->failed && s->next < s->size && !m_stop) {
+        s->lane->wake.signal();
+        m_ready.wait(m_lock);
+    }
+    if (s->ready.empty()) {
+        return false;
+    }
+    chunk.swap(s->ready.front().data);
+    offset = s->ready.front().offset;
+    s->buffered -= chunk.size();
+    s->ready.pop_front();
+    s->lane->wake.signal();
+
+    return true;
+}
+
+void
+Reader::seek(Stream* s, size_t offset)
+{
+    Lock l(m_lock);
+
+    s->ready.clear();
+    s->buffered = 0;
+    s->next = offset;
+    s->generation++;
+    s->lane->wake.signal();
+}
+
+void
+Reader::close(Stream* s)
+{
+    Lock l(m_lock);
+
+    if (s->reading) {
+        s->closed = true;
+    } else {
+        release(s);
+    }
+}
+
+string
+Reader::report()
+{
+    Lock l(m_lock);
+    ostringstream msg;
+
+    msg << "Reader: " << (m_bytes >> 20) << "MB in " << m_reads << " read(s) of up to " << (m_chunk >> 10) <<
+        "KB on " << m_lanes.size() << " lane(s), " << m_hits << " of " << m_opened << " input(s) prefetched";
+
+    return msg.str();
+}
+
+Reader::Buffer::int_type
+Reader::Buffer::underflow()
+{
+    if (gptr() < egptr()) {
+        return traits_type::to_int_type(*gptr());
+    }
+    size_t const pos = m_offset + m_chunk.size();
+
+    if (!m_reader->take(m_stream, m_chunk, m_offset)) {
+        m_chunk.clear();
+        m_offset = pos;
+        setg(nullptr, nullptr, nullptr);
+        return traits_type::eof();
+    }
+    setg(m_chunk.data(), m_chunk.data(), m_chunk.data() + m_chunk.size());
+
+    return traits_type::to_int_type(*gptr());
+}
+
+Reader::Buffer::pos_type
+Reader::Buffer::seekoff(off_type off, ios_base::seekdir dir, ios_base::openmode which)
+{
+    off_type const cur = (off_type)m_offset + (gptr() - eback());
+    off_type target;
+
+    if (!(which & ios_base::in)) {
+        return pos_type(off_type(-1));
+    }
+    if (dir == ios_base::beg) {
+        target = off;
+    } else if (dir == ios_base::cur) {
+        target = cur + off;
+    } else {
+        Lock l(m_reader->m_lock);
+        target = (off_type)m_stream->size + off;
+    }
+    if (target < 0) {
+        return pos_type(off_type(-1));
+    }
+    if (target == cur) {
+        return pos_type(target);
+    }
+
+    if (!m_chunk.empty() && target >= (off_type)m_offset && target <= (off_type)(m_offset + m_chunk.size())) {
+        setg(eback(), eback() + (target - m_offset), egptr());
+    } else {
+        m_reader->seek(m_stream, (size_t)target);
+        m_chunk.clear();
+        m_offset = (size_t)target;
+        setg(nullptr, nullptr, nullptr);
+    }
+
+    return pos_type(target);
+}
+
+Reader::Buffer::pos_type
+Reader::Buffer::seekpos(pos_type pos, ios_base::openmode which)
+{
+    return seekoff(off_type(pos), ios_base::beg, which);
+}
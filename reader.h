@@ -0,0 +1,171 @@
+/**
+ * @file        reader.h
+ * @version     1.0
+ * @brief       MP3enc_cpp input reader header
+ * @date        Oct 18, 2026
+ * @author      Siwon Kang (kkangshawn@gmail.com)
+ */
+
+#ifndef _READER_H
+#define _READER_H
+
+#include "common.h"
+#include "utils.h"
+#include "thread.h"
+#include "storage.h"
+
+#include <cstdio>
+#include <deque>
+#include <istream>
+#include <list>
+#include <string>
+#include <vector>
+
+/**
+ * @class   Reader reader.h "reader.h"
+ * @brief   Process wide reader doing all the input I/O from one lane thread per device.
+ *          Each lane reads the inputs on its device in large sequential chunks, one chunk at
+ *          a time: first for the inputs being encoded, oldest first, up to a few chunks ahead
+ *          of each encoder, then the header and first megabytes of the jobs queued next.
+ *          A slow disk thus never delays the reads of another. Encoders consume the filled
+ *          chunks through an istream in place of their own ifstream.
+ *          Disabled unless started; pipes and other files without a size are never handled.
+ */
+class Reader : public Utils, DEBUG {
+public:
+    static Reader&  instance();     /**< the process wide reader */
+
+    /**
+     * @fn      void configure(size_t chunk, size_t ahead, size_t prefetch)
+     * @brief   set the size of a read, the chunks kept filled ahead of each encoder and
+     *          the bytes prefetched from each queued job.
+     */
+    void            configure(size_t chunk, size_t ahead, size_t prefetch);
+    void            start();        /**< start reading, a lane is started for each device seen. Can follow stop() */
+    /**
+     * @fn      void stop()
+     * @brief   stop the lane threads and drop prefetched data. Shall be called once
+     *          no encoder reads any more.
+     */
+    void            stop();
+    bool            is_running() const { return m_running; }
+    /**
+     * @fn      std::istream* open(const std::string& path)
+     * @brief   open an input to be read by the reader thread, taking over its prefetched chunks.
+     * @return  a stream to be deleted by the caller, nullptr if the reader is not running
+     *          or the file is not a regular file
+     */
+    std::istream*   open(const std::string& path);
+    /**
+     * @fn      void prefetch(const std::vector<std::string>& paths)
+     * @brief   replace the inputs to prefetch, in the order they will be opened.
+     *          Prefetched data of inputs missing from the list is dropped.
+     */
+    void            prefetch(const std::vector<std::string>& paths);
+    /**
+     * @fn      std::string report()
+     * @brief   summarize the reads done so far.
+     */
+    std::string     report();
+
+private:
+    /**
+     * @struct  Chunk
+     * @brief   Data read at an offset of a file.
+     */
+    struct Chunk {
+        size_t              offset;
+        std::vector<char>   data;
+    };
+    class Lane;
+    /**
+     * @struct  Stream
+     * @brief   An input read by a lane. Shared by the lane and the encoder, protected by m_lock.
+     */
+    struct Stream {
+        std::string         path;
+        Lane*               lane;       /**< lane of the device of the file */
+        FILE*               file;       /**< opened by the lane on the first read */
+        size_t              size;       /**< file size when opened */
+        size_t              next;       /**< offset of the next chunk to read */
+        size_t              buffered;   /**< bytes in ready */
+        std::deque<Chunk>   ready;      /**< chunks read and not consumed yet */
+        unsigned int        generation; /**< incremented by every seek to discard reads in flight */
+        bool                active;     /**< opened by an encoder, prefetched otherwise */
+        bool                reading;    /**< the lane is reading it */
+        bool                closed;     /**< released by the encoder while being read */
+        bool                failed;     /**< a read failed */
+    };
+    /**
+     * @class   Lane
+     * @brief   Thread reading the inputs of one device.
+     */
+    class Lane : public Thread {
+    public:
+        Lane(Reader* reader, Storage::Device* device) : device(device), wake{}, m_reader(reader) {}
+
+        Storage::Device*    device;     /**< device read, nullptr for files of unknown device */
+        Condition           wake;       /**< signaled when the lane may have a chunk to read */
+    private:
+        void    run() { m_reader->serve(*this); }
+
+        Reader*             m_reader;
+    };
+    /**
+     * @class   Buffer
+     * @brief   streambuf over the chunks of a Stream.
+     */
+    class Buffer : public std::streambuf {
+    public:
+        Buffer(Reader* reader, Stream* stream) : m_reader(reader), m_stream(stream), m_chunk{}, m_offset(0) {}
+        virtual ~Buffer() { m_reader->close(m_stream); }
+    protected:
+        int_type    underflow();
+        pos_type    seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which);
+        pos_type    seekpos(pos_type pos, std::ios_base::openmode which);
+    private:
+        Reader*             m_reader;
+        Stream*             m_stream;
+        std::vector<char>   m_chunk;    /**< chunk being consumed */
+        size_t              m_offset;   /**< file offset of m_chunk */
+    };
+    /**
+     * @class   ChunkStream
+     * @brief   istream owning its Buffer.
+     */
+    class ChunkStream : public std::istream {
+    public:
+        ChunkStream(Reader* reader, Stream* stream) : std::istream(nullptr), m_buf(reader, stream) { rdbuf(&m_buf); }
+    private:
+        Buffer  m_buf;
+    };
+
+    Reader() : m_streams{}, m_lanes{}, m_stopped{}, m_chunk(1 << 20), m_ahead(4), m_prefetch(4 << 20), m_running(false),
+                m_stop(false), m_bytes(0), m_reads(0), m_opened(0), m_hits(0) {}
+    virtual ~Reader();
+    void            serve(Lane& lane);
+    Stream*         pick(const Lane& lane);
+    Lane*           lane(const std::string& path);
+    bool            take(Stream* s, std::vector<char>& chunk, size_t& offset);
+    void            seek(Stream* s, size_t offset);
+    void            close(Stream* s);
+    void            release(Stream* s);
+    Stream*         create(const std::string& path, size_t size, bool active);
+
+    std::list<Stream*>  m_streams;  /**< active streams in order of open, then prefetched ones in queue order */
+    std::vector<Lane*>  m_lanes;    /**< one lane per device */
+    std::vector<Lane*>  m_stopped;  /**< lanes of an earlier start(), kept until exit for streams of abandoned jobs */
+    size_t          m_chunk;        /**< bytes per read */
+    size_t          m_ahead;        /**< chunks kept ready for each encoder */
+    size_t          m_prefetch;     /**< bytes prefetched per queued job */
+    bool            m_running;      /**< the reader is started */
+    bool            m_stop;         /**< the lanes shall exit */
+    size_t          m_bytes;        /**< bytes read */
+    size_t          m_reads;        /**< reads done */
+    size_t          m_opened;       /**< streams opened by encoders */
+    size_t          m_hits;         /**< of which had prefetched data */
+    Mutex           m_lock;         /**< protects the members above and every Stream */
+    Condition       m_ready;        /**< signaled when a chunk is read */
+};
+
+#endif  /* _READER_H */
@@ -0,0 +1,212 @@
+/**
+ * @file        storage.cpp
+ * @version     1.0
+ * @brief       MP3enc_cpp storage device source
+ * @date        Oct 18, 2026
+ * @author      Siwon Kang (kkangshawn@gmail.com)
+ */
+
+#include "storage.h"
+
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+#if defined __linux
+#include <sys/sysmacros.h>
+#include <climits>
+#include <cstdlib>
+#endif
+using namespace std;
+
+/**
+ * @fn      static bool read_queue(const string& dir, bool& rotational, size_t& queue)
+ * @brief   read the queue attributes of a block device directory in sysfs.
+ * @return  false if the directory has no queue, as a partition
+ */
+static bool
+read_queue(const string& dir, bool& rotational, size_t& queue)
+{
+    ifstream r(dir + "/queue/rotational");
+    ifstream q(dir + "/queue/nr_requests");
+    int flag = 0;
+
+    if (!(r >> flag)) {
+        return false;
+    }
+    rotational = flag != 0;
+    if (!(q >> queue)) {
+        queue = 0;
+    }
+
+    return true;
+}
+
+Storage&
+Storage::instance()
+{
+    static Storage storage;
+
+    return storage;
+}
+
+void
+Storage::configure(size_t rotational, size_t other)
+{
+    Lock l(m_lock);
+
+    m_rotational = rotational;
+    m_other = other;
+}
+
+Storage::Device*
+Storage::create(unsigned long long id)
+{
+    Device* d = new Device{ id, {}, false, 0, 0, 0, 0, 0, 0, 0 };
+#if defined __linux
+    unsigned int const major_id = major((dev_t)id);
+    unsigned int const minor_id = minor((dev_t)id);
+    ostringstream dir;
+    char real[PATH_MAX];
+
+    dir << "/sys/dev/block/" << major_id << ":" << minor_id;
+    if (major_id == 0 || !realpath(dir.str().c_str(), real)) {
+        /* tmpfs, overlayfs, nfs...: no block device to look at */
+        ostringstream name;
+        name << major_id << ":" << minor_id;
+        d->name = name.str();
+    } else {
+        string const path = real;
+        d->name = path.substr(path.rfind('/') + 1);
+        /* a partition has its queue in the directory of its disk */
+        if (!read_queue(path, d->rotational, d->queue)) {
+            read_queue(path.substr(0, path.rfind('/')), d->rotational, d->queue);
+        }
+    }
+#elif defined _WIN32
+    d->name = string(1, (char)('A' + id)) + ":";
+#endif
+    d->limit = d->rotational ? m_rotational : (m_other ? m_other : d->queue);
+    m_devices[id] = d;
+
+    if (DEBUG::IS_SET()) {
+        ostringstream msg;
+        msg << "device " << d->name << (d->rotational ? " rotational" : "") << ", queue " << d->queue <<
+            ", I/O limit " << d->limit;
+        DEBUG::INFO(msg.str().c_str());
+    }
+
+    return d;
+}
+
+Storage::Device*
+Storage::lookup(const string& path)
+{
+    struct stat st;
+
+    if (stat(path.c_str(), &st) != 0) {
+        size_t const slash = path.find_last_of(DELIMITER);
+        string const dir = slash == string::npos ? "." : (slash == 0 ? path.substr(0, 1) : path.substr(0, slash));
+        if (stat(dir.c_str(), &st) != 0) {
+            return nullptr;
+        }
+    }
+
+    Lock l(m_lock);
+    map<unsigned long long, Device*>::iterator it = m_devices.find((unsigned long long)st.st_dev);
+    if (it != m_devices.end()) {
+        return it->second;
+    }
+
+    return create((unsigned long long)st.st_dev);
+}
+
+void
+Storage::acquire(Device* device)
+{
+    /* the limit never changes once the device is created */
+    if (!device || !device->limit) {
+        return;
+    }
+    Lock l(m_lock);
+
+    if (device->inflight >= device->limit) {
+        double const start = monotonic_time();
+        device->waiting++;
+        while (device->inflight >= device->limit) {
+            m_cond.wait(m_lock);
+        }
+        device->waiting--;
+        device->waited += monotonic_time() - start;
+    }
+    device->inflight++;
+    device->ops++;
+}
+
+void
+Storage::release(Device* device)
+{
+    if (!device || !device->limit) {
+        return;
+    }
+    Lock l(m_lock);
+
+    device->inflight--;
+    if (device->waiting) {
+        m_cond.broadcast();
+    }
+}
+
+bool
+Storage::congested(const Device* device)
+{
+    if (!device || !device->limit) {
+        return false;
+    }
+    Lock l(m_lock);
+
+    return device->waiting > 0;
+}
+
+void
+Storage::add_job(Device* device)
+{
+    if (!device) {
+        return;
+    }
+    Lock l(m_lock);
+
+    device->jobs++;
+}
+
+size_t
+Storage::count()
+{
+    Lock l(m_lock);
+
+    return m_devices.size();
+}
+
+string
+Storage::report()
+{
+    Lock l(m_lock);
+    ostringstream msg;
+
+    msg.setf(ios::fixed);
+    msg.precision(2);
+    for (map<unsigned long long, Device*>::const_iterator it = m_devices.begin(); it != m_devices.end(); ++it) {
+        const Device* d = it->second;
+        if (it != m_devices.begin()) {
+            msg << endl;
+        }
+        msg << "Device " << d->name << (d->rotational ? " (rotational)" : "") << ": " << d->jobs <<
+            " job(s), ";
+        if (d->limit) {
+            msg << d->ops << " I/O(s) at most " << d->limit << " in flight, " << d->waited << "s waited";
+        } else {
+            msg << "no I/O limit";
+        }
+    }
+
+    return msg.str();
+}
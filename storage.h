@@ -0,0 +1,103 @@
+/**
+ * @file        storage.h
+ * @version     1.0
+ * @brief       MP3enc_cpp storage device header
+ * @date        Oct 18, 2026
+ * @author      Siwon Kang (kkangshawn@gmail.com)
+ */
+
+#ifndef _STORAGE_H
+#define _STORAGE_H
+
+#include "common.h"
+#include "utils.h"
+#include "thread.h"
+
+#include <map>
+#include <string>
+
+/**
+ * @class   Storage storage.h "storage.h"
+ * @brief   Devices backing the inputs and outputs, told apart by st_dev.
+ *          Whether a device is rotational and the depth of its request queue are read once
+ *          from /sys/dev/block. Every device has its own limit of I/O in flight, taken by a
+ *          Slot around each read or write, so that a slow disk queues its own I/O without
+ *          holding back the others. Files on other systems or on virtual file systems
+ *          share one device without a limit.
+ */
+class Storage : public Utils, DEBUG {
+public:
+    /**
+     * @struct  Device
+     * @brief   A backing device. Counters are protected by the lock of Storage.
+     */
+    struct Device {
+        unsigned long long  id;         /**< st_dev */
+        std::string         name;       /**< block device name, e.g. sda */
+        bool                rotational; /**< a spinning disk */
+        size_t              queue;      /**< nr_requests of the block device, 0 if unknown */
+        size_t              limit;      /**< most I/O in flight, 0 for no limit */
+        size_t              inflight;   /**< I/O in flight */
+        size_t              waiting;    /**< I/O waiting for the limit */
+        size_t              jobs;       /**< jobs reading from it */
+        size_t              ops;        /**< I/O done */
+        double              waited;     /**< seconds I/O waited for the limit */
+    };
+    /**
+     * @class   Slot
+     * @brief   Holds one I/O in flight on a device for the scope of the instance.
+     *          Costs nothing on devices without a limit.
+     */
+    class Slot {
+    public:
+        explicit Slot(Device* device) : m_device(device) { Storage::instance().acquire(m_device); }
+        ~Slot() { Storage::instance().release(m_device); }
+    private:
+        Slot(const Slot&);
+        Slot& operator=(const Slot&);
+
+        Device* m_device;
+    };
+
+    static Storage& instance();     /**< the devices of this process */
+
+    /**
+     * @fn      void configure(size_t rotational, size_t other)
+     * @brief   set the I/O in flight allowed on each rotational and each other device.
+     *          0 lets rotational devices have no limit and other devices the depth of their queue.
+     *          Shall be called before any lookup.
+     */
+    void            configure(size_t rotational, size_t other);
+    /**
+     * @fn      Device* lookup(const std::string& path)
+     * @brief   get the device holding a file, or holding its directory if it does not exist yet.
+     * @return  nullptr if neither exists
+     */
+    Device*         lookup(const std::string& path);
+    /**
+     * @fn      bool congested(const Device* device)
+     * @brief   tell whether I/O queues for the limit of the device at the moment.
+     */
+    bool            congested(const Device* device);
+    void            add_job(Device* device);    /**< count a job reading from a device */
+    size_t          count();        /**< number of devices seen */
+    /**
+     * @fn      std::string report()
+     * @brief   describe every device seen with its jobs and the time its I/O waited.
+     */
+    std::string     report();
+
+private:
+    Storage() : m_devices{}, m_rotational(2), m_other(0) {}
+    void            acquire(Device* device);
+    void            release(Device* device);
+    Device*         create(unsigned long long id);
+
+    std::map<unsigned long long, Device*>   m_devices;  /**< devices by st_dev, never freed */
+    size_t          m_rotational;   /**< limit of rotational devices */
+    size_t          m_other;        /**< limit of other devices */
+    Mutex           m_lock;         /**< protects the members above and every Device */
+    Condition       m_cond;         /**< signaled when I/O leaves a limited device */
+};
+
+#endif  /* _STORAGE_H */
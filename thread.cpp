@@ -7,6 +7,8 @@
  */
 
 #include <iostream>
+#include <chrono>
+#include <errno.h>
 #include "thread.h"
 
 void
@@ -29,3 +31,29 @@ Thread::join()
         m_is_running = false;
     }
 }
+
+void
+Thread::detach()
+{
+    if (m_is_running) {
+        pthread_detach(m_thread);
+        m_is_running = false;
+    }
+}
+
+bool
+Condition::wait_for(Mutex& m, double seconds)
+{
+    using namespace std::chrono;
+
+    if (seconds < 0) {
+        seconds = 0;
+    }
+    nanoseconds const deadline = duration_cast<nanoseconds>(
+            system_clock::now().time_since_epoch() + duration<double>(seconds));
+    struct timespec ts;
+    ts.tv_sec = (time_t)(deadline.count() / 1000000000);
+    ts.tv_nsec = (long)(deadline.count() % 1000000000);
+
+    return pthread_cond_timedwait(&m_cond, &m.m_mutex, &ts) != ETIMEDOUT;
+}
@@ -21,6 +21,7 @@
 class Thread {
 public:
     Thread() : m_thread{}, m_is_running(false) {}
+    virtual ~Thread() {}
 
     /**
      * @fn      void start()
@@ -32,6 +33,11 @@ public:
      * @brief   join a thread binding a function specified by run() via pthread_create()
      */
     void join();
+    /**
+     * @fn      void detach()
+     * @brief   detach a running thread so that it is never joined.
+     */
+    void detach();
 private:
     /**
      * @fn      virtual void run()
@@ -47,4 +53,67 @@ private:
     bool      m_is_running;     /**< state variable to check thread is running */
 };
 
+/**
+ * @class   Mutex thread.h "thread.h"
+ * @brief   Mutex class using pthread library.
+ */
+class Mutex {
+public:
+    Mutex() { pthread_mutex_init(&m_mutex, NULL); }
+    ~Mutex() { pthread_mutex_destroy(&m_mutex); }
+
+    void lock() { pthread_mutex_lock(&m_mutex); }       /**< acquire the mutex */
+    void unlock() { pthread_mutex_unlock(&m_mutex); }   /**< release the mutex */
+private:
+    friend class Condition;
+    Mutex(const Mutex&);
+    Mutex& operator=(const Mutex&);
+
+    pthread_mutex_t m_mutex;    /**< mutex handle */
+};
+
+/**
+ * @class   Lock thread.h "thread.h"
+ * @brief   Scoped lock which holds a Mutex until it goes out of scope.
+ */
+class Lock {
+public:
+    explicit Lock(Mutex& m) : m_mutex(m) { m_mutex.lock(); }
+    ~Lock() { m_mutex.unlock(); }
+private:
+    Lock(const Lock&);
+    Lock& operator=(const Lock&);
+
+    Mutex&  m_mutex;            /**< mutex held by this lock */
+};
+
+/**
+ * @class   Condition thread.h "thread.h"
+ * @brief   Condition variable class using pthread library.
+ */
+class Condition {
+public:
+    Condition() { pthread_cond_init(&m_cond, NULL); }
+    ~Condition() { pthread_cond_destroy(&m_cond); }
+
+    /**
+     * @fn      void wait(Mutex& m)
+     * @brief   wait until signaled. The mutex shall be held by the caller.
+     */
+    void wait(Mutex& m) { pthread_cond_wait(&m_cond, &m.m_mutex); }
+    /**
+     * @fn      bool wait_for(Mutex& m, double seconds)
+     * @brief   wait until signaled or the timeout expires. The mutex shall be held by the caller.
+     * @return  false if the timeout expired
+     */
+    bool wait_for(Mutex& m, double seconds);
+    void signal() { pthread_cond_signal(&m_cond); }         /**< wake up one waiter */
+    void broadcast() { pthread_cond_broadcast(&m_cond); }   /**< wake up all waiters */
+private:
+    Condition(const Condition&);
+    Condition& operator=(const Condition&);
+
+    pthread_cond_t m_cond;      /**< condition variable handle */
+};
+
 #endif  /* _THREAD_H */
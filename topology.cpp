@@ -0,0 +1,312 @@
+/**
+ * @file        topology.cpp
+ * @version     1.0
+ * @brief       MP3enc_cpp CPU topology source
+ * @date        Oct 18, 2026
+ * @author      Siwon Kang (kkangshawn@gmail.com)
+ */
+
+#include "topology.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#if defined __linux
+#include <pthread.h>
+#include <sched.h>
+#include <dirent.h>
+#include <unistd.h>
+#elif defined _WIN32
+#include <Windows.h>
+#endif
+using namespace std;
+
+/**
+ * @fn      static vector<int> parse_cpulist(const string& list)
+ * @brief   parse a kernel cpu list such as "0-3,8-11".
+ */
+static vector<int>
+parse_cpulist(const string& list)
+{
+    vector<int> cpus;
+    istringstream ss(list);
+    string range;
+
+    while (getline(ss, range, ',')) {
+        int first, last;
+        char dash;
+        istringstream rs(range);
+        if (!(rs >> first)) {
+            continue;
+        }
+        last = first;
+        if (rs >> dash >> last) {
+            last = max(last, first);
+        }
+        for (int c = first; c <= last; c++) {
+            cpus.push_back(c);
+        }
+    }
+
+    return cpus;
+}
+
+/**
+ * @fn      static double read_cpu_limit(const string& dir, bool v2)
+ * @brief   read the quota of one cgroup directory.
+ * @return  processors allowed, 0 if unlimited or unknown
+ */
+static double
+read_cpu_limit(const string& dir, bool v2)
+{
+    double quota = -1;
+    double period = 0;
+
+    if (v2) {
+        ifstream in(dir + "/cpu.max");
+        string q;
+        if (in >> q >> period && q != "max") {
+            quota = atof(q.c_str());
+        }
+    } else {
+        ifstream q(dir + "/cpu.cfs_quota_us");
+        ifstream p(dir + "/cpu.cfs_period_us");
+        if (!(q >> quota) || !(p >> period)) {
+            quota = -1;
+        }
+    }
+
+    return (quota > 0 && period > 0) ? quota / period : 0;
+}
+
+Topology&
+Topology::instance()
+{
+    static Topology topology;
+
+    return topology;
+}
+
+Topology::Topology() : m_quota(0)
+{
+    read_affinity();
+    read_nodes();
+    read_quota();
+}
+
+void
+Topology::read_affinity()
+{
+#if defined __linux
+    cpu_set_t set;
+
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int c = 0; c < CPU_SETSIZE; c++) {
+            if (CPU_ISSET(c, &set)) {
+                m_cpus.push_back(c);
+            }
+        }
+    }
+    if (m_cpus.empty()) {
+        long const n = sysconf(_SC_NPROCESSORS_ONLN);
+        for (long c = 0; c < n; c++) {
+            m_cpus.push_back((int)c);
+        }
+    }
+#elif defined _WIN32
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    for (DWORD c = 0; c < si.dwNumberOfProcessors; c++) {
+        m_cpus.push_back((int)c);
+    }
+#endif
+    if (m_cpus.empty()) {
+        m_cpus.push_back(0);
+    }
+}
+
+void
+Topology::read_nodes()
+{
+#if defined __linux
+    DIR* dir = opendir("/sys/devices/system/node");
+    vector<int> ids;
+
+    if (dir) {
+        struct dirent* ent;
+        while ((ent = readdir(dir)) != NULL) {
+            if (!strncmp(ent->d_name, "node", 4) && isdigit((unsigned char)ent->d_name[4])) {
+                ids.push_back(atoi(ent->d_name + 4));
+            }
+        }
+        closedir(dir);
+    }
+    sort(ids.begin(), ids.end());
+
+    vector<int> ordered;
+    for (int id : ids) {
+        ostringstream path;
+        path << "/sys/devices/system/node/node" << id << "/cpulist";
+        ifstream in(path.str());
+        string list;
+        getline(in, list);
+
+        vector<int> cpus;
+        for (int c : parse_cpulist(list)) {
+            if (find(m_cpus.begin(), m_cpus.end(), c) != m_cpus.end()) {
+                cpus.push_back(c);
+            }
+        }
+        if (!cpus.empty()) {
+            ordered.insert(ordered.end(), cpus.begin(), cpus.end());
+            m_nodes.push_back(cpus);
+        }
+    }
+    /* every allowed processor shall be covered, otherwise ignore the node information */
+    if (ordered.size() == m_cpus.size()) {
+        m_cpus = ordered;
+        return;
+    }
+    m_nodes.clear();
+#endif
+    m_nodes.push_back(m_cpus);
+}
+
+void
+Topology::read_quota()
+{
+#if defined __linux
+    string v1_mount, v1_root, v2_mount, v2_root;
+    string v1_path, v2_path;
+    string line;
+
+    /* mount points of the cpu controller: "... root mountpoint ... - fstype source options" */
+    ifstream mi("/proc/self/mountinfo");
+    while (getline(mi, line)) {
+        size_t const sep = line.find(" - ");
+        if (sep == string::npos) {
+            continue;
+        }
+        istringstream head(line.substr(0, sep));
+        istringstream tail(line.substr(sep + 3));
+        string id, parent, dev, root, mount, fstype, source, options;
+        if (!(head >> id >> parent >> dev >> root >> mount) || !(tail >> fstype >> source >> options)) {
+            continue;
+        }
+        if (fstype == "cgroup2" && v2_mount.empty()) {
+            v2_mount = mount;
+            v2_root = root;
+        } else if (fstype == "cgroup" && ("," + options + ",").find(",cpu,") != string::npos) {
+            v1_mount = mount;
+            v1_root = root;
+        }
+    }
+
+    /* cgroup of this process: "hierarchy:controllers:path" */
+    ifstream cg("/proc/self/cgroup");
+    while (getline(cg, line)) {
+        size_t const c1 = line.find(':');
+        size_t const c2 = line.find(':', c1 + 1);
+        if (c1 == string::npos || c2 == string::npos) {
+            continue;
+        }
+        string const controllers = line.substr(c1 + 1, c2 - c1 - 1);
+        string const path = line.substr(c2 + 1);
+        if (controllers.empty()) {
+            v2_path = path;
+        } else if (("," + controllers + ",").find(",cpu,") != string::npos) {
+            v1_path = path;
+        }
+    }
+
+    bool const v2 = v1_mount.empty();
+    string const mount = v2 ? v2_mount : v1_mount;
+    string const root = v2 ? v2_root : v1_root;
+    string path = v2 ? v2_path : v1_path;
+    if (mount.empty()) {
+        return;
+    }
+    /* the path is relative to the root of the hierarchy, which may be mounted below it */
+    if (root != "/" && path.compare(0, root.size(), root) == 0) {
+        path = path.substr(root.size());
+    }
+
+    /* the tightest limit of the cgroup and its ancestors applies */
+    for (;;) {
+        double const q = read_cpu_limit(mount + path, v2);
+        if (q > 0 && (m_quota == 0 || q < m_quota)) {
+            m_quota = q;
+        }
+        size_t const slash = path.find_last_of('/');
+        if (path.empty() || path == "/" || slash == string::npos) {
+            break;
+        }
+        path = path.substr(0, slash);
+    }
+#endif
+}
+
+size_t
+Topology::default_workers() const
+{
+    size_t workers = m_cpus.size();
+
+    if (m_quota > 0) {
+        workers = min(workers, (size_t)ceil(m_quota));
+    }
+
+    return max(workers, (size_t)1);
+}
+
+bool
+Topology::pin(size_t index, PIN_MODE mode) const
+{
+#if defined __linux
+    cpu_set_t set;
+
+    CPU_ZERO(&set);
+    if (mode == PIN_CPU) {
+        CPU_SET(m_cpus[index % m_cpus.size()], &set);
+    } else if (mode == PIN_NODE) {
+        /* as many consecutive workers per node as it has processors */
+        size_t pos = index % m_cpus.size();
+        for (const vector<int>& node : m_nodes) {
+            if (pos < node.size()) {
+                for (int c : node) {
+                    CPU_SET(c, &set);
+                }
+                break;
+            }
+            pos -= node.size();
+        }
+    } else {
+        return true;
+    }
+
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#elif defined _WIN32
+    if (mode != PIN_CPU) {
+        return mode == PIN_NONE;
+    }
+    return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << m_cpus[index % m_cpus.size()]) != 0;
+#else
+    return mode == PIN_NONE;
+#endif
+}
+
+string
+Topology::describe() const
+{
+    ostringstream s;
+
+    s << m_cpus.size() << " cpus allowed on " << m_nodes.size() << " NUMA node(s)";
+    if (m_quota > 0) {
+        s << ", cgroup quota " << m_quota << " cpus";
+    }
+
+    return s.str();
+}
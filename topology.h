@@ -0,0 +1,61 @@
+/**
+ * @file        topology.h
+ * @version     1.0
+ * @brief       MP3enc_cpp CPU topology header
+ * @date        Oct 18, 2026
+ * @author      Siwon Kang (kkangshawn@gmail.com)
+ */
+
+#ifndef _TOPOLOGY_H
+#define _TOPOLOGY_H
+
+#include "common.h"
+#include "utils.h"
+
+#include <string>
+#include <vector>
+
+/**
+ * @class   Topology topology.h "topology.h"
+ * @brief   Processors this process may actually use: the affinity mask, the CPU quota of
+ *          its cgroup (v1 cpu.cfs_quota_us or v2 cpu.max) and the NUMA node of each processor.
+ *          Read once from /proc and /sys on first use; only the processor count on other systems.
+ */
+class Topology : public Utils, DEBUG {
+public:
+    enum PIN_MODE { PIN_NONE, PIN_CPU, PIN_NODE };
+
+    static Topology&    instance();     /**< topology of the running process */
+
+    /**
+     * @fn      size_t default_workers() const
+     * @brief   get the number of workers that keeps every allowed processor busy
+     *          without exceeding the cgroup quota.
+     */
+    size_t      default_workers() const;
+    /**
+     * @fn      bool pin(size_t index, PIN_MODE mode) const
+     * @brief   bind the calling worker thread to the processor (PIN_CPU) or the NUMA node
+     *          (PIN_NODE) of the given worker index. Workers fill one node before the next,
+     *          and memory the worker allocates afterwards is placed on its node.
+     * @return  false if the affinity could not be set
+     */
+    bool        pin(size_t index, PIN_MODE mode) const;
+    /**
+     * @fn      std::string describe() const
+     * @brief   describe the topology, e.g. "8 cpus allowed on 2 NUMA nodes, cgroup quota 4.0 cpus".
+     */
+    std::string describe() const;
+
+private:
+    Topology();
+    void        read_affinity();
+    void        read_nodes();
+    void        read_quota();
+
+    std::vector<int>                m_cpus;     /**< allowed processors ordered by NUMA node */
+    std::vector<std::vector<int>>   m_nodes;    /**< allowed processors of each NUMA node */
+    double                          m_quota;    /**< processors allowed by the cgroup quota, 0 if unlimited */
+};
+
+#endif  /* _TOPOLOGY_H */
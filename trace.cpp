@@ -0,0 +1,100 @@
+/**
+ * @file        trace.cpp
+ * @version     1.0
+ * @brief       MP3enc_cpp event trace source
+ * @date        Oct 18, 2026
+ * @author      Siwon Kang (kkangshawn@gmail.com)
+ */
+
+#include "trace.h"
+
+#include <cstdio>
+#include <sstream>
+using namespace std;
+
+Trace&
+Trace::instance()
+{
+    static Trace trace;
+
+    return trace;
+}
+
+bool
+Trace::open(const string& path)
+{
+    Lock l(m_lock);
+
+    m_out.open(path.c_str(), ios::out | ios::trunc);
+    m_open = m_out.is_open();
+    m_start = monotonic_time();
+
+    return m_open;
+}
+
+void
+Trace::close()
+{
+    Lock l(m_lock);
+
+    if (m_open) {
+        m_out.close();
+        m_open = false;
+    }
+}
+
+void
+Trace::event(const char* name, const string& fields)
+{
+    if (!m_open) {
+        return;
+    }
+
+    ostringstream line;
+    line.setf(ios::fixed);
+    line.precision(6);
+    line << "{\"t\":" << (monotonic_time() - m_start) << ",\"event\":\"" << name << "\"";
+    if (!fields.empty()) {
+        line << "," << fields;
+    }
+    line << "}\n";
+
+    Lock l(m_lock);
+    if (m_open) {
+        m_out << line.str();
+    }
+}
+
+string
+Trace::quote(const string& s)
+{
+    string q = "\"";
+
+    for (char c : s) {
+        switch (c) {
+        case '"':
+            q += "\\\"";
+            break;
+        case '\\':
+            q += "\\\\";
+            break;
+        case '\n':
+            q += "\\n";
+            break;
+        case '\t':
+            q += "\\t";
+            break;
+        default:
+            if ((unsigned char)c < 0x20) {
+                char esc[8];
+                snprintf(esc, sizeof(esc), "\\u%04x", c);
+                q += esc;
+            } else {
+                q += c;
+            }
+            break;
+        }
+    }
+
+    return q + "\"";
+}
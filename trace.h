@@ -0,0 +1,58 @@
+/**
+ * @file        trace.h
+ * @version     1.0
+ * @brief       MP3enc_cpp event trace header
+ * @date        Oct 18, 2026
+ * @author      Siwon Kang (kkangshawn@gmail.com)
+ */
+
+#ifndef _TRACE_H
+#define _TRACE_H
+
+#include "common.h"
+#include "utils.h"
+#include "thread.h"
+
+#include <fstream>
+#include <string>
+
+/**
+ * @class   Trace trace.h "trace.h"
+ * @brief   Process wide trace of scheduling events, written as one JSON object per line:
+ *          {"t":<seconds since open>,"event":"<name>",<fields>}
+ *          Events are dropped while no trace file is open.
+ */
+class Trace : public Utils, DEBUG {
+public:
+    static Trace&   instance();     /**< the process wide trace */
+
+    /**
+     * @fn      bool open(const std::string& path)
+     * @brief   start writing events to the given file. Shall be called before workers start.
+     */
+    bool            open(const std::string& path);
+    void            close();        /**< flush and stop tracing */
+    bool            is_open() const { return m_open; }
+    /**
+     * @fn      void event(const char* name, const std::string& fields)
+     * @brief   write an event.
+     * @param [in]  name    event name
+     * @param [in]  fields  JSON members without braces, e.g. "\"workers\":4"
+     */
+    void            event(const char* name, const std::string& fields);
+    /**
+     * @fn      static std::string quote(const std::string& s)
+     * @brief   quote and escape a string as a JSON string.
+     */
+    static std::string quote(const std::string& s);
+
+private:
+    Trace() : m_open(false), m_start(0) {}
+
+    std::ofstream   m_out;      /**< trace file */
+    bool            m_open;     /**< m_out is open */
+    double          m_start;    /**< time of open() */
+    Mutex           m_lock;     /**< serializes event() */
+};
+
+#endif  /* _TRACE_H */
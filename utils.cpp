@@ -10,9 +10,14 @@
 
 #include <iostream>
 #include <fstream>
+#include <chrono>
+#if defined __linux
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 int
-Utils::read_32_bits_high_low(std::ifstream* in)
+Utils::read_32_bits_high_low(std::istream* in)
 {
     char bytes[4] = { 0, 0, 0, 0 };
 
@@ -27,7 +32,7 @@ Utils::read_32_bits_high_low(std::ifstream* in)
 }
 
 int
-Utils::read_32_bits_low_high(std::ifstream* in)
+Utils::read_32_bits_low_high(std::istream* in)
 {
     char bytes[4] = { 0, 0, 0, 0 };
 
@@ -42,7 +47,7 @@ Utils::read_32_bits_low_high(std::ifstream* in)
 }
 
 int
-Utils::read_16_bits_low_high(std::ifstream* in)
+Utils::read_16_bits_low_high(std::istream* in)
 {
     char bytes[2] = { 0, 0 };
 
@@ -105,3 +110,30 @@ Utils::scmp(const char* a, const char* b) {
 
     return *a - *b;
 }
+
+double
+Utils::monotonic_time()
+{
+    return std::chrono::duration<double>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool
+Utils::drop_file_cache(const char* file)
+{
+#if defined __linux
+    int fd = open(file, O_RDONLY);
+
+    if (fd < 0) {
+        return false;
+    }
+    fdatasync(fd);
+    bool ret = (posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0);
+    close(fd);
+
+    return ret;
+#else
+    (void)file;
+    return false;
+#endif
+}
@@ -28,26 +28,26 @@ protected:
 #endif
 
     /**
-     * @fn      int read_32_bits_high_low(std::ifstream* in)
+     * @fn      int read_32_bits_high_low(std::istream* in)
      * @brief   A function to read bits from input file stream.
      * @param [in]  in      a file stream to read bits
      * @return  int value
      */
-    int     read_32_bits_high_low(std::ifstream* in);
+    int     read_32_bits_high_low(std::istream* in);
     /**
-     * @fn      int read_32_bits_low_high(std::ifstream* in)
+     * @fn      int read_32_bits_low_high(std::istream* in)
      * @brief   A function to read bits from input file stream.
      * @param [in]  in      a file stream to read bits
      * @return  int value
      */
-    int     read_32_bits_low_high(std::ifstream* in);
+    int     read_32_bits_low_high(std::istream* in);
     /**
-     * @fn      int read_16_bits_low_high(std::ifstream* in)
+     * @fn      int read_16_bits_low_high(std::istream* in)
      * @brief   A function to read bits from input file stream.
      * @param [in]  in      a file stream to read bits
      * @return  int value
      */
-    int     read_16_bits_low_high(std::ifstream* in);
+    int     read_16_bits_low_high(std::istream* in);
     long    make_even_number_of_bytes_in_length(long x);    /**< padding 1 if given number is odd. */
     /**
      * @fn      double get_file_size(const char* file)
@@ -65,6 +65,20 @@ protected:
      */
     bool    is_wav(const std::string path);
     int     scmp(const char* a, const char* b); /**< compare two strings are identical. Return 0 if same. */
+    /**
+     * @fn      static double monotonic_time()
+     * @brief   A function to get time from a monotonic clock.
+     * @return  seconds elapsed from an arbitrary fixed point
+     */
+    static double monotonic_time();
+    /**
+     * @fn      bool drop_file_cache(const char* file)
+     * @brief   A function to evict cached pages of the given file so that the next read
+     *          comes from the storage. Only supported on Linux.
+     * @param [in]  file    a filename with path to evict
+     * @return  true if the page cache was dropped
+     */
+    bool    drop_file_cache(const char* file);
 };
 
 #endif  /* _UTILS_H */
@@ -0,0 +1,274 @@
+/**
+ * @file        watch.cpp
+ * @version     1.0
+ * @brief       MP3enc_cpp hot folder watcher source
+ * @date        Oct 18, 2026
+ * @author      Siwon Kang (kkangshawn@gmail.com)
+ */
+
+#include "watch.h"
+#include "manifest.h"
+
+#include <algorithm>
+#include <sstream>
+#include <unordered_set>
+#if defined __linux
+#include <dirent.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+#if defined __linux
+static const uint32_t WATCH_MASK = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MODIFY | IN_CREATE | IN_DELETE |
+    IN_MOVED_FROM | IN_ONLYDIR;
+#endif
+
+bool
+Watcher::stamp(const string& path, Stamp& s)
+{
+    return Manifest::stamp(path, s.first, s.second);
+}
+
+bool
+Watcher::open(const string& path)
+{
+#if defined __linux
+    string dir = path;
+
+    if (dir.size() > 1 && dir.back() == DELIMITER) {
+        dir.pop_back();
+    }
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_fd < 0) {
+        cerr << "ERROR: could not start watching " << dir << endl;
+        return false;
+    }
+    add(dir, false);
+    if (m_dirs.empty()) {
+        cerr << "ERROR: " << dir << " is not a directory that can be watched" << endl;
+        close();
+        return false;
+    }
+
+    return true;
+#else
+    cerr << "ERROR: --watch is not supported on this system, " << path << " not watched" << endl;
+    return false;
+#endif
+}
+
+void
+Watcher::close()
+{
+#if defined __linux
+    if (m_fd >= 0) {
+        ::close(m_fd);
+    }
+#endif
+    m_fd = -1;
+    m_dirs.clear();
+}
+
+void
+Watcher::add(const string& dir, bool scan)
+{
+#if defined __linux
+    int const wd = inotify_add_watch(m_fd, dir.c_str(), WATCH_MASK);
+    if (wd < 0) {
+        DEBUG::WARN(("could not watch " + dir).c_str());
+        return;
+    }
+    m_dirs[wd] = dir;
+
+    /* the watch is in place, so whatever is listed now cannot be missed */
+    DIR* d = opendir(dir.c_str());
+    struct dirent* ent;
+    double const now = monotonic_time();
+    while (d && (ent = readdir(d)) != NULL) {
+        string const full = dir + DELIMITER + ent->d_name;
+        if (ent->d_type == DT_DIR) {
+            if (m_recursive && scmp(ent->d_name, ".") && scmp(ent->d_name, "..")) {
+                add(full, scan);
+            }
+        } else if (ent->d_type == DT_REG && is_wav(ent->d_name)) {
+            Stamp s;
+            if (scan) {
+                schedule(full, now);
+            } else if (stamp(full, s)) {
+                m_seen[full] = s;
+            }
+        }
+    }
+    if (d) {
+        closedir(d);
+    }
+#else
+    (void)dir;
+    (void)scan;
+#endif
+}
+
+void
+Watcher::schedule(const string& path, double now)
+{
+    Stamp s;
+
+    if (!stamp(path, s)) {
+        return;
+    }
+    unordered_map<string, Stamp>::const_iterator seen = m_seen.find(path);
+    if (seen != m_seen.end() && seen->second == s) {
+        return;
+    }
+    Pending const p = { now + m_settle, s };
+    m_pending[path] = p;
+}
+
+void
+Watcher::forget(const string& prefix)
+{
+    /* the directory is gone, files of one made again under its name are new */
+    for (unordered_map<string, Stamp>::iterator it = m_seen.begin(); it != m_seen.end();) {
+        if (it->first.compare(0, prefix.size(), prefix) == 0) {
+            it = m_seen.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void
+Watcher::rescan(double now)
+{
+#if defined __linux
+    vector<string> dirs;
+    unordered_set<string> watched;
+
+    for (unordered_map<int, string>::const_iterator it = m_dirs.begin(); it != m_dirs.end(); ++it) {
+        dirs.push_back(it->second);
+        watched.insert(it->second);
+    }
+    for (const string& dir : dirs) {
+        DIR* d = opendir(dir.c_str());
+        struct dirent* ent;
+        while (d && (ent = readdir(d)) != NULL) {
+            string const full = dir + DELIMITER + ent->d_name;
+            if (ent->d_type == DT_DIR && m_recursive && scmp(ent->d_name, ".") && scmp(ent->d_name, "..")) {
+                if (!watched.count(full)) {
+                    add(full, true);
+                }
+            } else if (ent->d_type == DT_REG && is_wav(ent->d_name) && !m_pending.count(full)) {
+                schedule(full, now);
+            }
+        }
+        if (d) {
+            closedir(d);
+        }
+    }
+#else
+    (void)now;
+#endif
+}
+
+vector<string>
+Watcher::wait(double timeout)
+{
+    vector<string> ready;
+    double now = monotonic_time();
+
+#if defined __linux
+    double until = now + timeout;
+    for (unordered_map<string, Pending>::const_iterator it = m_pending.begin(); it != m_pending.end(); ++it) {
+        until = min(until, it->second.deadline);
+    }
+    struct pollfd pfd = { m_fd, POLLIN, 0 };
+    if (m_fd >= 0 && poll(&pfd, 1, (int)max((until - now) * 1000, 0.0)) > 0) {
+        alignas(struct inotify_event) char buf[64 << 10];
+        ssize_t len;
+        bool overflow = false;
+        now = monotonic_time();
+        while ((len = read(m_fd, buf, sizeof(buf))) > 0) {
+            for (char* p = buf; p < buf + len; p += sizeof(struct inotify_event) + ((struct inotify_event*)p)->len) {
+                const struct inotify_event* ev = (const struct inotify_event*)p;
+                m_events++;
+                if (ev->mask & IN_Q_OVERFLOW) {
+                    overflow = true;
+                    continue;
+                }
+                if (ev->mask & IN_IGNORED) {
+                    unordered_map<int, string>::const_iterator gone = m_dirs.find(ev->wd);
+                    if (gone != m_dirs.end()) {
+                        forget(gone->second + DELIMITER);
+                        m_dirs.erase(gone);
+                    }
+                    continue;
+                }
+                unordered_map<int, string>::const_iterator dir = m_dirs.find(ev->wd);
+                if (dir == m_dirs.end() || !ev->len) {
+                    continue;
+                }
+                string const full = dir->second + DELIMITER + ev->name;
+                if (ev->mask & IN_ISDIR) {
+                    /* files may have landed in it before the watch was added */
+                    if (m_recursive && (ev->mask & (IN_CREATE | IN_MOVED_TO))) {
+                        add(full, true);
+                    }
+                } else if (!is_wav(ev->name)) {
+                    continue;
+                } else if (ev->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                    m_pending.erase(full);
+                    m_seen.erase(full);
+                } else if (ev->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                    schedule(full, now);
+                } else if (m_pending.count(full)) {
+                    /* still being written */
+                    m_pending[full].deadline = now + m_settle;
+                }
+            }
+        }
+        if (overflow) {
+            DEBUG::WARN("inotify event queue overflowed, listing watched directories again");
+            m_overflows++;
+            rescan(now);
+        }
+    }
+#else
+    (void)timeout;
+#endif
+
+    now = monotonic_time();
+    for (unordered_map<string, Pending>::iterator it = m_pending.begin(); it != m_pending.end();) {
+        Stamp s;
+        if (it->second.deadline > now) {
+            ++it;
+        } else if (!stamp(it->first, s)) {
+            it = m_pending.erase(it);
+        } else if (s != it->second.stamp) {
+            /* written without events, e.g. through a mapping or over the network */
+            it->second.stamp = s;
+            it->second.deadline = now + m_settle;
+            ++it;
+        } else {
+            m_seen[it->first] = s;
+            ready.push_back(it->first);
+            it = m_pending.erase(it);
+        }
+    }
+    m_queued += ready.size();
+    sort(ready.begin(), ready.end());
+
+    return ready;
+}
+
+string
+Watcher::report()
+{
+    ostringstream msg;
+
+    msg << "Watch: " << m_events << " event(s), " << m_queued << " input(s) queued, " << m_overflows <<
+        " overflow(s), " << m_dirs.size() << " director" << (m_dirs.size() == 1 ? "y" : "ies") << " watched";
+
+    return msg.str();
+}
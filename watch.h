@@ -0,0 +1,86 @@
+/**
+ * @file        watch.h
+ * @version     1.0
+ * @brief       MP3enc_cpp hot folder watcher header
+ * @date        Oct 18, 2026
+ * @author      Siwon Kang (kkangshawn@gmail.com)
+ */
+
+#ifndef _WATCH_H
+#define _WATCH_H
+
+#include "common.h"
+#include "utils.h"
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @class   Watcher watch.h "watch.h"
+ * @brief   Finds wav files as they arrive in a directory, enabled by --watch.
+ *          The directory, and its subdirectories with -r, are watched with inotify for files
+ *          closed after writing or moved in. A file is handed out once it has settled: no event
+ *          came for it during the settle time and its size and modification time did not move.
+ *          When the event queue overflows, the watched directories are listed again and only
+ *          files whose size or modification time changed since they were handed out are taken.
+ *          Linux only.
+ */
+class Watcher : public Utils, DEBUG {
+public:
+    Watcher(bool recursive, double settle) : m_recursive(recursive), m_settle(settle), m_fd(-1), m_dirs{},
+                m_pending{}, m_seen{}, m_events(0), m_overflows(0), m_queued(0) {}
+    virtual ~Watcher() { close(); }
+
+    /**
+     * @fn      bool open(const std::string& path)
+     * @brief   start watching a directory. The wav files already in it count as handed out.
+     * @return  false if path is not a directory or cannot be watched
+     */
+    bool            open(const std::string& path);
+    void            close();        /**< stop watching */
+    /**
+     * @fn      std::vector<std::string> wait(double timeout)
+     * @brief   wait up to timeout seconds for events, or less if a file settles earlier.
+     * @return  wav files settled since the last call
+     */
+    std::vector<std::string> wait(double timeout);
+    /**
+     * @fn      std::string report()
+     * @brief   summarize the events seen and the files handed out.
+     */
+    std::string     report();
+
+private:
+    typedef std::pair<double, long long> Stamp;     /**< size and modification time of a file */
+    /**
+     * @struct  Pending
+     * @brief   A file waiting to settle.
+     */
+    struct Pending {
+        double      deadline;   /**< monotonic time it settles if nothing happens to it */
+        Stamp       stamp;      /**< size and modification time when last seen */
+    };
+
+    Watcher(const Watcher&);
+    Watcher& operator=(const Watcher&);
+
+    void            add(const std::string& dir, bool scan);
+    void            schedule(const std::string& path, double now);
+    void            rescan(double now);
+    void            forget(const std::string& prefix);
+    static bool     stamp(const std::string& path, Stamp& s);
+
+    bool            m_recursive;    /**< watch subdirectories */
+    double          m_settle;       /**< seconds without events before a file is taken */
+    int             m_fd;           /**< inotify instance, -1 if closed */
+    std::unordered_map<int, std::string>        m_dirs;     /**< watched directories by watch descriptor */
+    std::unordered_map<std::string, Pending>    m_pending;  /**< files waiting to settle */
+    std::unordered_map<std::string, Stamp>      m_seen;     /**< files handed out, as they were then */
+    size_t          m_events;       /**< events read */
+    size_t          m_overflows;    /**< event queue overflows */
+    size_t          m_queued;       /**< files handed out */
+};
+
+#endif  /* _WATCH_H */
@@ -0,0 +1,507 @@
+/**
+ * @file        writer.cpp
+ * @version     1.0
+ * @brief       MP3enc_cpp output writer source
+ * @date        Oct 18, 2026
+ * @author      Siwon Kang (kkangshawn@gmail.com)
+ */
+
+#include "writer.h"
+#include "hints.h"
+#include "journal.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <sstream>
+#if defined __linux
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#elif defined _WIN32
+#include <process.h>
+#define getpid _getpid
+#endif
+using namespace std;
+
+static const size_t WRITER_ALIGN = 4096;
+
+size_t OutputWriter::buffer_size = 1 << 20;
+size_t OutputWriter::hold_limit = 0;
+OutputWriter::SYNC_POLICY OutputWriter::sync_policy = OutputWriter::SYNC_NONE;
+
+static string
+dir_name(const string& path)
+{
+    size_t const slash = path.find_last_of("/\\");
+
+    return slash == string::npos ? "." : path.substr(0, slash + 1);
+}
+
+static bool
+sync_dir(const string& dir)
+{
+#if defined __linux
+    int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    bool const ret = (fsync(fd) == 0);
+    ::close(fd);
+    return ret;
+#else
+    (void)dir;
+    return true;
+#endif
+}
+
+OutputWriter::~OutputWriter()
+{
+    if (is_open()) {
+        abort();
+    }
+    free(m_buf);
+}
+
+void
+OutputWriter::set_sync_policy(SYNC_POLICY policy, size_t files, double seconds)
+{
+    sync_policy = policy;
+    if (policy == SYNC_GROUP) {
+        SyncGroup::instance().configure(files, seconds);
+    }
+}
+
+void
+OutputWriter::finish()
+{
+    if (sync_policy == SYNC_GROUP) {
+        SyncGroup::instance().stop();
+    }
+}
+
+size_t
+OutputWriter::memory_estimate(size_t output)
+{
+    size_t need = buffer_size;
+    size_t cap = WRITER_ALIGN;
+
+    /* grow() doubles the buffer while holding the whole output */
+    if (hold_limit && output > need) {
+        need = output < hold_limit ? output : hold_limit;
+    }
+    while (cap < need) {
+        cap *= 2;
+    }
+
+    return cap;
+}
+
+bool
+OutputWriter::open(const string& path)
+{
+    static atomic<unsigned int> counter(0);
+    ostringstream tmp;
+    size_t const slash = path.find_last_of("/\\");
+
+    m_path = path;
+    m_len = m_flushed = m_reserved = 0;
+    m_hold = m_failed = false;
+
+    /* hidden name in the same directory so that rename() stays atomic */
+    if (slash == string::npos) {
+        tmp << "." << path;
+    } else {
+        tmp << path.substr(0, slash + 1) << "." << path.substr(slash + 1);
+    }
+    tmp << "." << getpid() << "." << counter++ << ".tmp";
+    m_tmp = tmp.str();
+
+#if defined __linux
+    m_fd = ::open(m_tmp.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+    if (m_fd < 0) {
+        return false;
+    }
+#else
+    m_file = fopen(m_tmp.c_str(), "wb");
+    if (!m_file) {
+        return false;
+    }
+#endif
+    m_device = Storage::instance().lookup(m_tmp);
+
+    return grow(buffer_size);
+}
+
+bool
+OutputWriter::grow(size_t need)
+{
+    if (need <= m_cap) {
+        return true;
+    }
+    size_t cap = m_cap ? m_cap : WRITER_ALIGN;
+    while (cap < need) {
+        cap *= 2;
+    }
+    cap = (cap + WRITER_ALIGN - 1) / WRITER_ALIGN * WRITER_ALIGN;
+
+    void* buf = nullptr;
+#if defined _WIN32
+    buf = malloc(cap);
+#else
+    if (posix_memalign(&buf, WRITER_ALIGN, cap) != 0) {
+        buf = nullptr;
+    }
+#endif
+    if (!buf) {
+        DEBUG::ERR("failed to allocate output buffer");
+        return false;
+    }
+    if (m_len) {
+        memcpy(buf, m_buf, m_len);
+    }
+    free(m_buf);
+    m_buf = (char*)buf;
+    m_cap = cap;
+
+    return true;
+}
+
+void
+OutputWriter::reserve(size_t estimate)
+{
+    if (hold_limit && estimate <= hold_limit) {
+        m_hold = grow(estimate);
+    }
+#if defined __linux
+    if (m_fd >= 0 && estimate > 0) {
+        /* blocks only, the file size follows what is actually written */
+        if (fallocate(m_fd, FALLOC_FL_KEEP_SIZE, 0, estimate) == 0) {
+            m_reserved = estimate;
+        } else if (errno != EOPNOTSUPP) {
+            DEBUG::WARN("fallocate() failed");
+        }
+    }
+#endif
+}
+
+bool
+OutputWriter::pwrite_all(const char* data, size_t len, size_t offset)
+{
+    Storage::Slot slot(m_device);
+
+#if defined __linux
+    while (len > 0) {
+        ssize_t n = pwrite(m_fd, data, len, offset);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        len -= n;
+        offset += n;
+    }
+    return true;
+#else
+    return fseek(m_file, (long)offset, SEEK_SET) == 0 && fwrite(data, 1, len, m_file) == len;
+#endif
+}
+
+bool
+OutputWriter::flush()
+{
+    if (m_failed || m_len == 0) {
+        return !m_failed;
+    }
+    if (!pwrite_all(m_buf, m_len, m_flushed)) {
+        m_failed = true;
+        return false;
+    }
+    if (StreamHints::enabled()) {
+        StreamHints::write_behind(m_fd, m_flushed, m_len);
+    }
+    m_flushed += m_len;
+    m_len = 0;
+
+    return true;
+}
+
+bool
+OutputWriter::write(const void* data, size_t len)
+{
+    const char* p = (const char*)data;
+
+    if (m_failed || !is_open()) {
+        return false;
+    }
+    if (m_hold) {
+        if (!grow(m_len + len)) {
+            m_failed = true;
+            return false;
+        }
+        memcpy(m_buf + m_len, p, len);
+        m_len += len;
+        return true;
+    }
+    while (len > 0) {
+        size_t const n = min(len, m_cap - m_len);
+        memcpy(m_buf + m_len, p, n);
+        m_len += n;
+        p += n;
+        len -= n;
+        if (m_len == m_cap && !flush()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool
+OutputWriter::write_at(size_t offset, const void* data, size_t len)
+{
+    const char* p = (const char*)data;
+
+    if (m_failed || !is_open() || offset + len > size()) {
+        return false;
+    }
+    /* the part already on disk is patched in place, the rest in the buffer */
+    if (offset < m_flushed) {
+        size_t const n = min(len, m_flushed - offset);
+        if (!pwrite_all(p, n, offset)) {
+            m_failed = true;
+            return false;
+        }
+        p += n;
+        len -= n;
+        offset += n;
+    }
+    if (len > 0) {
+        memcpy(m_buf + (offset - m_flushed), p, len);
+    }
+
+    return true;
+}
+
+bool
+OutputWriter::commit()
+{
+    bool ret = flush();
+
+#if defined __linux
+    if (m_fd < 0) {
+        return false;
+    }
+    if (m_reserved > m_flushed && ftruncate(m_fd, m_flushed) != 0) {
+        ret = false;
+    }
+    if (ret && StreamHints::enabled()) {
+        StreamHints::drop_written(m_fd);
+    }
+    if (ret && sync_policy == SYNC_GROUP) {
+        SyncGroup::instance().add(m_fd, m_tmp, m_path);
+        m_fd = -1;
+        return true;
+    }
+    if (ret && sync_policy == SYNC_FILE && fdatasync(m_fd) != 0) {
+        ret = false;
+    }
+    if (::close(m_fd) != 0) {
+        ret = false;
+    }
+    m_fd = -1;
+#else
+    if (!m_file) {
+        return false;
+    }
+    if (fclose(m_file) != 0) {
+        ret = false;
+    }
+    m_file = nullptr;
+    if (ret) {
+        remove(m_path.c_str());
+    }
+#endif
+    if (ret && rename(m_tmp.c_str(), m_path.c_str()) != 0) {
+        ret = false;
+    }
+    if (ret && sync_policy == SYNC_FILE && !sync_dir(dir_name(m_path))) {
+        DEBUG::WARN("failed to sync output directory");
+    }
+    if (!ret) {
+        remove(m_tmp.c_str());
+    } else if (Journal::instance().is_open()) {
+        Journal::instance().done(m_path);
+    }
+
+    return ret;
+}
+
+void
+OutputWriter::abort()
+{
+#if defined __linux
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+#else
+    if (m_file) {
+        fclose(m_file);
+        m_file = nullptr;
+    }
+#endif
+    remove(m_tmp.c_str());
+    m_len = 0;
+}
+
+SyncGroup&
+SyncGroup::instance()
+{
+    static SyncGroup group;
+
+    return group;
+}
+
+void
+SyncGroup::configure(size_t files, double seconds)
+{
+    Lock l(m_lock);
+
+    m_files = files > 0 ? files : 1;
+    m_seconds = seconds;
+}
+
+void
+SyncGroup::add(int fd, const string& tmp, const string& path)
+{
+    vector<Pending> batch;
+    Pending const p = { fd, tmp, path };
+
+    {
+        Lock l(m_lock);
+        if (m_pending.empty()) {
+            m_oldest = monotonic_time();
+        }
+        m_pending.push_back(p);
+        if (m_pending.size() >= m_files) {
+            batch.swap(m_pending);
+        } else if (!m_running) {
+            m_running = true;
+            m_stop = false;
+            start();
+        } else {
+            m_cond.signal();
+        }
+    }
+    if (!batch.empty()) {
+        sync(batch);
+    }
+}
+
+void
+SyncGroup::flush()
+{
+    vector<Pending> batch;
+
+    {
+        Lock l(m_lock);
+        batch.swap(m_pending);
+    }
+    sync(batch);
+}
+
+void
+SyncGroup::stop()
+{
+    {
+        Lock l(m_lock);
+        m_stop = true;
+        m_cond.signal();
+    }
+    join();
+    {
+        Lock l(m_lock);
+        m_running = false;
+    }
+    flush();
+}
+
+void
+SyncGroup::run()
+{
+    vector<Pending> batch;
+
+    m_lock.lock();
+    while (!m_stop) {
+        if (m_pending.empty()) {
+            m_cond.wait(m_lock);
+            continue;
+        }
+        double const left = m_oldest + m_seconds - monotonic_time();
+        if (left > 0) {
+            m_cond.wait_for(m_lock, left);
+            continue;
+        }
+        batch.swap(m_pending);
+        m_lock.unlock();
+        sync(batch);
+        batch.clear();
+        m_lock.lock();
+    }
+    m_lock.unlock();
+}
+
+void
+SyncGroup::sync(vector<Pending>& batch)
+{
+    Lock l(m_sync_lock);
+    set<string> dirs;
+
+    if (batch.empty()) {
+        return;
+    }
+    /* sync all the data first so that the disk sees one batch of flushes */
+    for (Pending& p : batch) {
+#if defined __linux
+        if (fdatasync(p.fd) != 0) {
+            cerr << "ERROR: failed to sync " << p.path << endl;
+            ::close(p.fd);
+            p.fd = -1;
+            remove(p.tmp.c_str());
+            p.tmp.clear();
+            continue;
+        }
+        ::close(p.fd);
+#endif
+        p.fd = -1;
+    }
+    for (Pending& p : batch) {
+        if (p.tmp.empty()) {
+            continue;
+        }
+        if (rename(p.tmp.c_str(), p.path.c_str()) != 0) {
+            cerr << "ERROR: failed to rename " << p.tmp << " to " << p.path << endl;
+            remove(p.tmp.c_str());
+            p.tmp.clear();
+            continue;
+        }
+        dirs.insert(dir_name(p.path));
+    }
+    for (const string& d : dirs) {
+        if (!sync_dir(d)) {
+            DEBUG::WARN("failed to sync output directory");
+        }
+    }
+    if (Journal::instance().is_open()) {
+        for (const Pending& p : batch) {
+            if (!p.tmp.empty()) {
+                Journal::instance().done(p.path);
+            }
+        }
+    }
+}
@@ -0,0 +1,192 @@
+/**
+ * @file        writer.h
+ * @version     1.0
+ * @brief       MP3enc_cpp output writer header
+ * @date        Oct 18, 2026
+ * @author      Siwon Kang (kkangshawn@gmail.com)
+ */
+
+#ifndef _WRITER_H
+#define _WRITER_H
+
+#include "common.h"
+#include "thread.h"
+#include "utils.h"
+#include "storage.h"
+
+#include <vector>
+
+/**
+ * @class   OutputWriter writer.h "writer.h"
+ * @brief   Writes an output file through a large aligned buffer.
+ *          The file is preallocated from an estimated size, data is written with pwrite()
+ *          at explicit offsets so that rewriting the LAME-tag needs no seek, and small
+ *          outputs can be kept in memory entirely until a single write on commit().
+ *          Data goes to a temporary file in the same directory which replaces the output
+ *          file atomically on commit(), so a crash never leaves a truncated output behind.
+ */
+class OutputWriter : DEBUG {
+public:
+    /**
+     * @brief   Durability of committed outputs.
+     *          SYNC_NONE renames without syncing, SYNC_FILE syncs every file before its rename,
+     *          SYNC_GROUP syncs and renames pending files together every N files or T seconds.
+     */
+    enum SYNC_POLICY { SYNC_NONE, SYNC_FILE, SYNC_GROUP };
+
+    OutputWriter() : m_fd(-1), m_file(nullptr), m_path{}, m_tmp{}, m_buf(nullptr), m_cap(0), m_len(0),
+                m_flushed(0), m_reserved(0), m_hold(false), m_failed(false), m_device(nullptr) {}
+    virtual ~OutputWriter();
+
+    /**
+     * @fn      static void set_buffer_size(size_t bytes)
+     * @brief   set the size of the write buffer used by instances opened afterwards.
+     */
+    static void     set_buffer_size(size_t bytes) { buffer_size = bytes; }
+    /**
+     * @fn      static void set_hold_limit(size_t bytes)
+     * @brief   keep outputs estimated up to bytes in memory until close(). 0 disables.
+     */
+    static void     set_hold_limit(size_t bytes) { hold_limit = bytes; }
+    static size_t   get_hold_limit() { return hold_limit; }    /**< current hold limit */
+    /**
+     * @fn      static void set_sync_policy(SYNC_POLICY policy, size_t files, double seconds)
+     * @brief   set durability of committed outputs.
+     * @param [in]  policy  one of SYNC_POLICY
+     * @param [in]  files   SYNC_GROUP syncs once this many files are pending
+     * @param [in]  seconds SYNC_GROUP syncs once the oldest pending file waited this long
+     */
+    static void     set_sync_policy(SYNC_POLICY policy, size_t files, double seconds);
+    /**
+     * @fn      static void finish()
+     * @brief   sync and rename all outputs still pending in a group commit.
+     *          Shall be called before the process exits.
+     */
+    static void     finish();
+    /**
+     * @fn      static size_t memory_estimate(size_t output)
+     * @brief   upper bound of the write buffer allocated for an output of at most the given size.
+     */
+    static size_t   memory_estimate(size_t output);
+
+    /**
+     * @fn      bool open(const std::string& path)
+     * @brief   create a temporary file next to the output file. An existing output file is
+     *          kept intact until commit().
+     * @return  true if the file is opened
+     */
+    bool            open(const std::string& path);
+    /**
+     * @fn      void reserve(size_t estimate)
+     * @brief   preallocate the file with the estimated output size and decide whether
+     *          to hold the whole output in memory.
+     */
+    void            reserve(size_t estimate);
+    /**
+     * @fn      bool write(const void* data, size_t len)
+     * @brief   append data at the end of the output.
+     * @return  false on write error
+     */
+    bool            write(const void* data, size_t len);
+    /**
+     * @fn      bool write_at(size_t offset, const void* data, size_t len)
+     * @brief   overwrite data already written at the given offset, e.g. the LAME-tag frame.
+     * @return  false on write error or if the range was never written
+     */
+    bool            write_at(size_t offset, const void* data, size_t len);
+    /**
+     * @fn      bool commit()
+     * @brief   flush buffered data, release preallocated space beyond the end and replace
+     *          the output file with it according to the sync policy.
+     * @return  false if any write failed. The temporary file is removed in that case.
+     */
+    bool            commit();
+    /**
+     * @fn      void abort()
+     * @brief   discard the output. Called from the destructor unless committed.
+     */
+    void            abort();
+    size_t          size() const { return m_flushed + m_len; }  /**< bytes written so far */
+    size_t          capacity() const { return m_cap; }          /**< bytes of the write buffer */
+    bool            is_open() const { return m_fd >= 0 || m_file; }
+
+private:
+    OutputWriter(const OutputWriter&);
+    OutputWriter& operator=(const OutputWriter&);
+
+    bool            flush();
+    bool            grow(size_t need);
+    bool            pwrite_all(const char* data, size_t len, size_t offset);
+
+    int             m_fd;           /**< file descriptor */
+    FILE*           m_file;         /**< stdio file where pwrite() is unavailable */
+    std::string     m_path;         /**< output file */
+    std::string     m_tmp;          /**< temporary file renamed to m_path on commit */
+    char*           m_buf;          /**< aligned write buffer */
+    size_t          m_cap;          /**< capacity of m_buf */
+    size_t          m_len;          /**< bytes pending in m_buf */
+    size_t          m_flushed;      /**< bytes already written to the file */
+    size_t          m_reserved;     /**< bytes preallocated */
+    bool            m_hold;         /**< keep the whole output in memory */
+    bool            m_failed;       /**< a write has failed */
+    Storage::Device* m_device;      /**< device of the output, whose I/O limit writes take */
+
+    static size_t       buffer_size;
+    static size_t       hold_limit;
+    static SYNC_POLICY  sync_policy;
+};
+
+/**
+ * @class   SyncGroup writer.h "writer.h"
+ * @brief   Group commit of outputs under OutputWriter::SYNC_GROUP.
+ *          Committed files stay under their temporary names until the group is synced,
+ *          then all of them are renamed and their directories synced at once.
+ */
+class SyncGroup : public Thread, Utils, DEBUG {
+public:
+    static SyncGroup&   instance();     /**< the process wide group */
+
+    void    configure(size_t files, double seconds);
+    /**
+     * @fn      void add(int fd, const std::string& tmp, const std::string& path)
+     * @brief   queue a written file. The group takes over the file descriptor.
+     */
+    void    add(int fd, const std::string& tmp, const std::string& path);
+    /**
+     * @fn      void flush()
+     * @brief   sync and rename everything pending now.
+     */
+    void    flush();
+    /**
+     * @fn      void stop()
+     * @brief   flush and stop the timer thread.
+     */
+    void    stop();
+
+private:
+    /**
+     * @struct  Pending
+     * @brief   A file waiting for the group to be synced.
+     */
+    struct Pending {
+        int         fd;
+        std::string tmp;
+        std::string path;
+    };
+
+    SyncGroup() : m_files(32), m_seconds(1.0), m_oldest(0), m_running(false), m_stop(false) {}
+    void    run();
+    void    sync(std::vector<Pending>& batch);
+
+    std::vector<Pending>    m_pending;  /**< files waiting for the next sync */
+    size_t                  m_files;    /**< sync when this many files are pending */
+    double                  m_seconds;  /**< sync when the oldest file waited this long */
+    double                  m_oldest;   /**< time the oldest pending file was added */
+    bool                    m_running;  /**< the timer thread is started */
+    bool                    m_stop;     /**< the timer thread shall exit */
+    Mutex                   m_lock;     /**< protects the members above */
+    Condition               m_cond;     /**< wakes up the timer thread */
+    Mutex                   m_sync_lock;    /**< serializes sync() */
+};
+
+#endif  /* _WRITER_H */